@@ -36,6 +36,9 @@ set( HAVE_GTS       ${GTS_FOUND}        )
 if(with_zlib AND ZLIB_FOUND)
   set(HAVE_ZLIB 1)
 endif()
+if(CMAKE_USE_PTHREADS_INIT)
+  set(HAVE_PTHREAD 1)
+endif()
 
 if(LTDL_FOUND)
   set(ENABLE_LTDL 1)
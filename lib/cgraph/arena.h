@@ -0,0 +1,88 @@
+/// \file
+/// \brief Region allocator for many small objects that are freed together
+///
+/// Allocations are carved out of large zeroed blocks and cannot be freed
+/// individually. All memory of an arena is released at once by `arena_reset`.
+/// This avoids the per-allocation overhead of `malloc` for objects that share
+/// a lifetime.
+
+#pragma once
+
+#include <assert.h>
+#include <cgraph/alloc.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/// a type with the strictest alignment of the basic types
+typedef union {
+  long double ld;
+  long long ll;
+  double d;
+  void *p;
+  void (*f)(void);
+} arena_align_t;
+
+typedef struct arena_block_s {
+  struct arena_block_s *next; ///< block allocated before this one
+  arena_align_t data[];
+} arena_block_t;
+
+typedef struct arena_s {
+  arena_block_t *blocks; ///< most recently allocated block first
+  size_t used;           ///< bytes used in the first block
+  size_t capacity;       ///< bytes available in the first block
+  size_t total;          ///< bytes allocated by all blocks
+} arena_t;
+
+/// allocate `size` zeroed bytes that live until the arena is reset
+static inline void *arena_alloc(arena_t *arena, size_t size) {
+  assert(arena != NULL);
+
+  // round up to keep following allocations aligned
+  size_t align = sizeof(arena_align_t);
+  size = (size + align - 1) / align * align;
+  if (size == 0)
+    size = align;
+
+  if (arena->blocks == NULL || arena->capacity - arena->used < size) {
+    // Blocks double in size, from 4KB up to 64KB, so small arenas stay small
+    // and large ones need few blocks. Staying below the usual threshold at
+    // which malloc maps memory separately keeps blocks on the heap, so their
+    // addresses increase with allocation order as those of plain malloc
+    // calls do. cgraph IDs of named objects are string addresses, and layouts
+    // should not change with the memory discipline. Requests that do not fit
+    // get a block of their own.
+    enum { MIN_BLOCK = 4096, MAX_BLOCK = 1 << 16 };
+    size_t capacity = arena->total < MIN_BLOCK ? MIN_BLOCK : arena->total;
+    if (capacity > MAX_BLOCK)
+      capacity = MAX_BLOCK;
+    if (capacity < size)
+      capacity = size;
+
+    arena_block_t *block = gv_alloc(sizeof(arena_block_t) + capacity);
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->used = 0;
+    arena->capacity = capacity;
+    arena->total += capacity;
+  }
+
+  void *p = (char *)arena->blocks->data + arena->used;
+  arena->used += size;
+  return p;
+}
+
+/// release all memory of the arena, leaving it empty and reusable
+static inline void arena_reset(arena_t *arena) {
+  assert(arena != NULL);
+
+  while (arena->blocks != NULL) {
+    arena_block_t *next = arena->blocks->next;
+    free(arena->blocks);
+    arena->blocks = next;
+  }
+  arena->used = 0;
+  arena->capacity = 0;
+  arena->total = 0;
+}
@@ -212,6 +212,7 @@ static void freeattr(Agobj_t * obj, Agattr_t * attr)
     for (i = 0; i < sz; i++)
 	agstrfree(g, attr->str[i]);
     agfree(g, attr->str);
+    agfree(g, attr->parsed);
 }
 
 static void freesym(Dict_t * d, void * obj, Dtdisc_t * disc)
@@ -493,6 +494,8 @@ int agxset(void *obj, Agsym_t * sym, const char *value)
     assert(sym->id >= 0 && sym->id < topdictsize(obj));
     agstrfree(g, data->str[sym->id]);
     data->str[sym->id] = agstrdup(g, value);
+    if (sym->id < data->nparsed)
+	data->parsed[sym->id].kind = 0;
     if (hdr->tag.objtype == AGRAPH) {
 	/* also update dict default */
 	Dict_t *dict;
@@ -509,6 +512,44 @@ int agxset(void *obj, Agsym_t * sym, const char *value)
     return SUCCESS;
 }
 
+/*
+ * Callers that convert attribute strings to numbers can keep the result
+ * with the object, so the string need not be parsed again. kind is a
+ * nonzero tag of the caller's choosing, saying how the value was derived.
+ * agxgetparsed returns the tag of the cached value, or 0 if there is none,
+ * as after the attribute has been set with agxset.
+ */
+int agxgetparsed(void *obj, Agsym_t * sym, double *value)
+{
+    Agattr_t *data;
+
+    data = agattrrec(obj);
+    if (sym->id >= data->nparsed || data->parsed[sym->id].kind == 0)
+	return 0;
+    *value = data->parsed[sym->id].value;
+    return data->parsed[sym->id].kind;
+}
+
+void agxsetparsed(void *obj, Agsym_t * sym, int kind, double value)
+{
+    Agraph_t *g;
+    Agattr_t *data;
+    int sz;
+
+    g = agraphof(obj);
+    data = agattrrec(obj);
+    assert(sym->id >= 0 && sym->id < topdictsize(obj));
+    if (sym->id >= data->nparsed) {
+	sz = topdictsize(obj);
+	data->parsed = agrealloc(g, data->parsed,
+				 (size_t) data->nparsed * sizeof(Agparsed_t),
+				 (size_t) sz * sizeof(Agparsed_t));
+	data->nparsed = sz;
+    }
+    data->parsed[sym->id].value = value;
+    data->parsed[sym->id].kind = kind;
+}
+
 int agsafeset(void *obj, char *name, const char *value, const char *def) {
     Agsym_t *a;
 
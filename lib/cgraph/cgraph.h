@@ -73,6 +73,7 @@ typedef struct Agcbdisc_s Agcbdisc_t;   ///< client event callbacks
 typedef struct Agcbstack_s Agcbstack_t; ///< enclosing state for cbdisc
 typedef struct Agclos_s Agclos_t;       ///< common fields for graph/subgs
 typedef struct Agrec_s Agrec_t;         ///< generic runtime record
+typedef struct Agsnapshot_s Agsnapshot_t; ///< read-only adjacency arrays
 typedef struct Agdatadict_s Agdatadict_t; ///< set of dictionaries per graph
 typedef struct Agedgepair_s Agedgepair_t; ///< the edge object
 typedef struct Agsubnode_s Agsubnode_t;
@@ -217,6 +218,12 @@ CGRAPH_API extern Agiodisc_t AgIoDisc;
 
 CGRAPH_API extern Agdisc_t AgDefaultDisc;
 
+/// @brief region allocator: objects are never freed individually and
+/// closing the root graph releases all its memory at once
+CGRAPH_API extern Agmemdisc_t AgArenaMemDisc;
+/// default disciplines, but with @ref AgArenaMemDisc for memory
+CGRAPH_API extern Agdisc_t AgArenaDisc;
+
 struct Agdstate_s {
     void *mem;
     void *id;
@@ -290,6 +297,8 @@ CGRAPH_API int agissimple(Agraph_t * g);
 CGRAPH_API Agnode_t *agnode(Agraph_t * g, char *name, int createflag);
 CGRAPH_API Agnode_t *agidnode(Agraph_t * g, IDTYPE id, int createflag);
 CGRAPH_API Agnode_t *agsubnode(Agraph_t * g, Agnode_t * n, int createflag);
+CGRAPH_API int agnodes(Agraph_t * g, char **names, size_t count,
+		       Agnode_t ** nodes);
 CGRAPH_API Agnode_t *agfstnode(Agraph_t * g);
 CGRAPH_API Agnode_t *agnxtnode(Agraph_t * g, Agnode_t * n);
 CGRAPH_API Agnode_t *aglstnode(Agraph_t * g);
@@ -304,6 +313,8 @@ CGRAPH_API Agedge_t *agedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 CGRAPH_API Agedge_t *agidedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
               IDTYPE id, int createflag);
 CGRAPH_API Agedge_t *agsubedge(Agraph_t * g, Agedge_t * e, int createflag);
+CGRAPH_API int agedges(Agraph_t * g, Agnode_t ** nodes, const size_t * ends,
+		       size_t count, Agedge_t ** edges);
 CGRAPH_API Agedge_t *agfstin(Agraph_t * g, Agnode_t * n);
 CGRAPH_API Agedge_t *agnxtin(Agraph_t * g, Agedge_t * e);
 CGRAPH_API Agedge_t *agfstout(Agraph_t * g, Agnode_t * n);
@@ -311,6 +322,32 @@ CGRAPH_API Agedge_t *agnxtout(Agraph_t * g, Agedge_t * e);
 CGRAPH_API Agedge_t *agfstedge(Agraph_t * g, Agnode_t * n);
 CGRAPH_API Agedge_t *agnxtedge(Agraph_t * g, Agedge_t * e, Agnode_t * n);
 
+/// @brief compressed sparse row view of a graph's adjacency
+///
+/// Nodes are numbered 0 … nnodes-1 in @ref agfstnode order. The out-edges of
+/// node i are entries out_start[i] … out_start[i+1]-1 of out_edge, in
+/// @ref agfstout order, and the matching entries of out_adj are the numbers of
+/// their heads. in_* and adj_* likewise hold the in-edges and their tails, as
+/// visited by @ref agfstin, and all incident edges and their other endpoints,
+/// as visited by @ref agfstedge. The view is only valid until nodes or edges
+/// of the graph are added or deleted.
+struct Agsnapshot_s {
+    Agraph_t *g;
+    size_t nnodes;
+    size_t nedges;
+    Agnode_t **nodes;
+    size_t *out_start, *out_adj;
+    Agedge_t **out_edge;
+    size_t *in_start, *in_adj;
+    Agedge_t **in_edge;
+    size_t *adj_start, *adj;
+    Agedge_t **adj_edge;
+};
+
+CGRAPH_API Agsnapshot_t *agsnapshot(Agraph_t * g);
+CGRAPH_API size_t agsnapindex(const Agsnapshot_t * s, Agnode_t * n);
+CGRAPH_API void agsnapfree(Agsnapshot_t * s);
+
 /* generic */
 CGRAPH_API Agraph_t *agraphof(void* obj);
 CGRAPH_API Agraph_t *agroot(void* obj);
@@ -335,10 +372,19 @@ CGRAPH_API char *agcanonStr(char *str);  /* manages its own buf */
 
 /// definitions for dynamic string attributes
 
+/// value parsed from an attribute string, see @ref agxsetparsed
+
+typedef struct {
+    double value;
+    int kind;			/* caller's tag for how it was parsed, 0 if none */
+} Agparsed_t;
+
 struct Agattr_s {		/* dynamic string attributes */
     Agrec_t h;			/* common data header */
     Dict_t *dict;		/* shared dict to interpret attr field */
     char **str;			/* the attribute string values */
+    Agparsed_t *parsed;		/* values parsed from str[], or NULL */
+    int nparsed;		/* size of parsed[] */
 };
 
 /// symbol in one of the above dictionaries
@@ -378,6 +424,9 @@ CGRAPH_API char *agget(void *obj, char *name);
 CGRAPH_API char *agxget(void *obj, Agsym_t * sym);
 CGRAPH_API int agset(void *obj, char *name, const char *value);
 CGRAPH_API int agxset(void *obj, Agsym_t * sym, const char *value);
+CGRAPH_API int agxgetparsed(void *obj, Agsym_t * sym, double *value);
+CGRAPH_API void agxsetparsed(void *obj, Agsym_t * sym, int kind,
+			     double value);
 CGRAPH_API int agsafeset(void* obj, char* name, const char* value,
                          const char* def);
 
@@ -9,9 +9,13 @@
  *************************************************************************/
 
 #include <assert.h>
+#include <cgraph/alloc.h>
 #include <cgraph/cghdr.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 /* return first outedge of <n> */
 Agedge_t *agfstout(Agraph_t * g, Agnode_t * n)
@@ -147,19 +151,19 @@ Agsubnode_t *agsubrep(Agraph_t * g, Agnode_t * n)
     return sn;
 }
 
-static void ins(Dict_t * d, Dtlink_t ** set, Agedge_t * e)
+static void ins(Agraph_t * g, Dict_t * d, Dtlink_t ** set, Agedge_t * e)
 {
     dtrestore(d, *set);
-    dtinsert(d, e);
+    agdtinsert(g, d, e);
     *set = dtextract(d);
 }
 
-static void del(Dict_t * d, Dtlink_t ** set, Agedge_t * e)
+static void del(Agraph_t * g, Dict_t * d, Dtlink_t ** set, Agedge_t * e)
 {
-    void *x;
+    int x;
     (void)x;
     dtrestore(d, *set);
-    x = dtdelete(d, e);
+    x = agdtdelete(g, d, e);
     assert(x);
     *set = dtextract(d);
 }
@@ -177,11 +181,11 @@ static void installedge(Agraph_t * g, Agedge_t * e)
     while (g) {
 	if (agfindedge_by_key(g, t, h, AGTAG(e))) break;
 	sn = agsubrep(g, t);
-	ins(g->e_seq, &sn->out_seq, out);
-	ins(g->e_id, &sn->out_id, out);
+	ins(g, g->e_seq, &sn->out_seq, out);
+	ins(g, g->e_id, &sn->out_id, out);
 	sn = agsubrep(g, h);
-	ins(g->e_seq, &sn->in_seq, in);
-	ins(g->e_id, &sn->in_id, in);
+	ins(g, g->e_seq, &sn->in_seq, in);
+	ins(g, g->e_id, &sn->in_id, in);
 	g = agparent(g);
     }
 }
@@ -304,6 +308,157 @@ Agedge_t *agedge(Agraph_t * g, Agnode_t * t, Agnode_t * h, char *name,
     return e;
 }
 
+/* stable counting sort of batch positions by one endpoint index */
+static void sortends(const size_t * pairs, int end, const size_t * from,
+		     size_t * to, size_t count, size_t * bucket, size_t nnodes)
+{
+    memset(bucket, 0, (nnodes + 1) * sizeof(size_t));
+    for (size_t p = 0; p < count; p++)
+	bucket[pairs[2 * p + end] + 1]++;
+    for (size_t k = 0; k < nnodes; k++)
+	bucket[k + 1] += bucket[k];
+    for (size_t i = 0; i < count; i++) {
+	size_t p = from ? from[i] : i;
+	to[bucket[pairs[2 * p + end]]++] = p;
+    }
+}
+
+/* insert the out (or in) halves of a batch of new edges, grouped by the
+ * node whose sets they join, restoring each node's sets once per group */
+static void installedgeset(Agraph_t * g, Agedge_t ** fresh,
+			   const size_t * order, size_t count, bool out)
+{
+    for (size_t i = 0, j; i < count; i = j) {
+	Agedge_t *e = out ? fresh[order[i]] : AGOUT2IN(fresh[order[i]]);
+	Agnode_t *n = out ? AGTAIL(e) : AGHEAD(e);
+	Agsubnode_t *sn = agsubrep(g, n);
+	Dtlink_t **seqset = out ? &sn->out_seq : &sn->in_seq;
+	Dtlink_t **idset = out ? &sn->out_id : &sn->in_id;
+
+	dtrestore(g->e_seq, *seqset);
+	for (j = i; j < count; j++) {
+	    e = out ? fresh[order[j]] : AGOUT2IN(fresh[order[j]]);
+	    if ((out ? AGTAIL(e) : AGHEAD(e)) != n)
+		break;
+	    agdtinsert(g, g->e_seq, e);
+	}
+	*seqset = dtextract(g->e_seq);
+	dtrestore(g->e_id, *idset);
+	for (size_t k = i; k < j; k++)
+	    agdtinsert(g, g->e_id,
+		       out ? fresh[order[k]] : AGOUT2IN(fresh[order[k]]));
+	*idset = dtextract(g->e_id);
+    }
+}
+
+/* bulk edge constructor: edges[i] = agedge(g, nodes[ends[2 * i]],
+ * nodes[ends[2 * i + 1]], NULL, TRUE) */
+int agedges(Agraph_t * g, Agnode_t ** nodes, const size_t * ends,
+	    size_t count, Agedge_t ** edges)
+{
+    Agraph_t *root = agroot(g);
+    size_t *which, *pairs, *byout, *byin, *tmp, *bucket;
+    IDTYPE *ids;
+    Agedge_t **fresh;
+    size_t nfresh = 0, nnodes = 0;
+    int rv = SUCCESS;
+
+    if (agisstrict(g)) {
+	/* anonymous edges may coincide with earlier ones */
+	for (size_t i = 0; i < count; i++) {
+	    Agedge_t *e = agedge(g, nodes[ends[2 * i]], nodes[ends[2 * i + 1]],
+				 NULL, TRUE);
+	    if (e == NULL)
+		rv = FAILURE;
+	    if (edges)
+		edges[i] = e;
+	}
+	return rv;
+    }
+
+    /* the positions of the edges to be made; sequence numbers follow it */
+    which = gv_calloc(count, sizeof(size_t));
+    pairs = gv_calloc(2 * count, sizeof(size_t));
+    ids = gv_calloc(count, sizeof(IDTYPE));
+    for (size_t i = 0; i < count; i++) {
+	if (edges)
+	    edges[i] = NULL;
+	if (ok_to_make_edge(g, nodes[ends[2 * i]], nodes[ends[2 * i + 1]])
+	    && agmapnametoid(g, AGEDGE, NULL, &ids[nfresh], TRUE)) {
+	    pairs[2 * nfresh] = ends[2 * i];
+	    pairs[2 * nfresh + 1] = ends[2 * i + 1];
+	    which[nfresh++] = i;
+	} else
+	    rv = FAILURE;
+	if (ends[2 * i] >= nnodes)
+	    nnodes = ends[2 * i] + 1;
+	if (ends[2 * i + 1] >= nnodes)
+	    nnodes = ends[2 * i + 1] + 1;
+    }
+
+    /* order the batch by (tail, head) and by (head, tail) with counting
+     * sorts on the caller's indices, so no node has to be visited */
+    byout = gv_calloc(nfresh, sizeof(size_t));
+    byin = gv_calloc(nfresh, sizeof(size_t));
+    tmp = gv_calloc(nfresh, sizeof(size_t));
+    bucket = gv_calloc(nnodes + 1, sizeof(size_t));
+    sortends(pairs, 1, NULL, tmp, nfresh, bucket, nnodes);
+    sortends(pairs, 0, tmp, byout, nfresh, bucket, nnodes);
+    sortends(pairs, 0, NULL, tmp, nfresh, bucket, nnodes);
+    sortends(pairs, 1, tmp, byin, nfresh, bucket, nnodes);
+    if (g != root) {
+	for (size_t i = 0; i < nfresh; i++) {
+	    (void)agsubnode(g, nodes[pairs[2 * i]], TRUE);
+	    (void)agsubnode(g, nodes[pairs[2 * i + 1]], TRUE);
+	}
+    }
+
+    /* allocate the pairs in out-set order, so installing them there walks
+     * memory sequentially */
+    fresh = gv_calloc(nfresh, sizeof(Agedge_t *));
+    uint64_t seq0 = g->clos->seq[AGEDGE] + 1;
+    g->clos->seq[AGEDGE] += nfresh;
+    assert((g->clos->seq[AGEDGE] & SEQ_MASK) == g->clos->seq[AGEDGE]
+	   && "sequence ID overflow");
+    for (size_t k = 0; k < nfresh; k++) {
+	size_t p = byout[k];
+	Agedgepair_t *e2 = agalloc(g, sizeof(Agedgepair_t));
+	AGTYPE(&e2->in) = AGINEDGE;
+	AGTYPE(&e2->out) = AGOUTEDGE;
+	AGID(&e2->in) = AGID(&e2->out) = ids[p];
+	AGSEQ(&e2->in) = AGSEQ(&e2->out) = (seq0 + p) & SEQ_MASK;
+	e2->in.node = nodes[pairs[2 * p]];
+	e2->out.node = nodes[pairs[2 * p + 1]];
+	fresh[p] = &e2->out;
+    }
+
+    for (Agraph_t *par = g; par; par = agparent(par)) {
+	installedgeset(par, fresh, byout, nfresh, true);
+	installedgeset(par, fresh, byin, nfresh, false);
+    }
+    for (size_t p = 0; p < nfresh; p++) {
+	Agedge_t *e = fresh[p];
+	if (g->desc.has_attrs) {
+	    (void)agbindrec(e, AgDataRecName, sizeof(Agattr_t), false);
+	    agedgeattr_init(g, e);
+	}
+	agmethod_init(g, e);
+	agregister(g, AGEDGE, e);
+	if (edges)
+	    edges[which[p]] = e;
+    }
+
+    free(fresh);
+    free(bucket);
+    free(tmp);
+    free(byin);
+    free(byout);
+    free(ids);
+    free(pairs);
+    free(which);
+    return rv;
+}
+
 void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
 {
     Agedge_t *in, *out;
@@ -321,11 +476,11 @@ void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
     t = in->node;
     h = out->node;
     sn = agsubrep(g, t);
-    del(g->e_seq, &sn->out_seq, out);
-    del(g->e_id, &sn->out_id, out);
+    del(g, g->e_seq, &sn->out_seq, out);
+    del(g, g->e_id, &sn->out_id, out);
     sn = agsubrep(g, h);
-    del(g->e_seq, &sn->in_seq, in);
-    del(g->e_id, &sn->in_id, in);
+    del(g, g->e_seq, &sn->in_seq, in);
+    del(g, g->e_id, &sn->in_id, in);
 #ifdef DEBUG
     for (e = agfstin(g,h); e; e = agnxtin(g,e))
 	assert(e != in);
@@ -99,6 +99,7 @@ int agclose(Agraph_t * g)
 	/* free entire heap */
 	agmethod_delete(g, g);	/* invoke user callbacks */
 	agfreeid(g, AGRAPH, AGID(g));
+	AGDISC(g, id)->close(AGCLOS(g, id));
 	AGDISC(g, mem)->close(AGCLOS(g, mem));	/* whoosh */
 	return SUCCESS;
     }
@@ -265,6 +266,7 @@ Agdesc_t Agundirected = { .maingraph = 1 };
 Agdesc_t Agstrictundirected = { .strict = 1, .maingraph = 1 };
 
 Agdisc_t AgDefaultDisc = { &AgMemDisc, &AgIdDisc, &AgIoDisc };
+Agdisc_t AgArenaDisc = { &AgArenaMemDisc, &AgIdDisc, &AgIoDisc };
 
 /**
  * @dir lib/cgraph
@@ -8,8 +8,11 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <cgraph/alloc.h>
+#include <cgraph/arena.h>
 #include <cgraph/cghdr.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* memory management discipline and entry points */
 static void *memopen(Agdisc_t* disc)
@@ -48,6 +51,46 @@ static void memfree(void *heap, void *ptr)
 Agmemdisc_t AgMemDisc =
     { memopen, memalloc, memresize, memfree, NULL };
 
+/* region discipline: objects are bump allocated from large blocks and never
+ * freed individually, so closing the root graph releases everything at once */
+static void *arenaopen(Agdisc_t* disc)
+{
+    (void)disc; /* unused */
+    return gv_alloc(sizeof(arena_t));
+}
+
+static void *arenaalloc(void *heap, size_t request)
+{
+    return arena_alloc(heap, request);
+}
+
+static void *arenaresize(void *heap, void *ptr, size_t oldsize,
+			 size_t request)
+{
+    void *rv;
+
+    if (request <= oldsize)
+	return ptr;
+    rv = arena_alloc(heap, request);
+    memcpy(rv, ptr, oldsize);
+    return rv;
+}
+
+static void arenafree(void *heap, void *ptr)
+{
+    (void)heap;
+    (void)ptr;
+}
+
+static void arenaclose(void *heap)
+{
+    arena_reset(heap);
+    free(heap);
+}
+
+Agmemdisc_t AgArenaMemDisc =
+    { arenaopen, arenaalloc, arenaresize, arenafree, arenaclose };
+
 void *agalloc(Agraph_t * g, size_t size)
 {
     void *mem;
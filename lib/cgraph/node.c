@@ -9,9 +9,12 @@
  *************************************************************************/
 
 #include <assert.h>
+#include <cgraph/alloc.h>
 #include <cgraph/cghdr.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 Agnode_t *agfindnode_by_id(Agraph_t * g, IDTYPE id)
 {
@@ -172,6 +175,150 @@ Agnode_t *agnode(Agraph_t * g, char *name, int cflag)
     return NULL;
 }
 
+typedef struct {
+    char *name;
+    IDTYPE id;
+    size_t index;
+} nodeid_t;
+
+static int nodenamecmpf(const void *a, const void *b)
+{
+    const nodeid_t *x = a;
+    const nodeid_t *y = b;
+    int c = strcmp(x->name, y->name);
+    if (c != 0)
+	return c;
+    if (x->index != y->index)
+	return x->index < y->index ? -1 : 1;
+    return 0;
+}
+
+static int nodeidcmpf(const void *a, const void *b)
+{
+    const nodeid_t *x = a;
+    const nodeid_t *y = b;
+    if (x->id != y->id)
+	return x->id < y->id ? -1 : 1;
+    if (x->index != y->index)
+	return x->index < y->index ? -1 : 1;
+    return 0;
+}
+
+/* install new nodes in g and all its ancestors. fresh is in sequence order
+ * and byid lists positions in fresh in ID order; each dictionary receives
+ * the batch in its own key order, so its splay tree is only ever extended
+ * at the end or walked sequentially. */
+static void installnodes(Agraph_t * g, Agnode_t ** fresh, const size_t * byid,
+			 size_t count)
+{
+    Agsubnode_t **sns = gv_calloc(count, sizeof(Agsubnode_t *));
+
+    for (; g; g = agparent(g)) {
+	for (size_t i = 0; i < count; i++) {
+	    if (g == agroot(g))
+		sns[i] = &fresh[i]->mainsub;
+	    else
+		sns[i] = agalloc(g, sizeof(Agsubnode_t));
+	    sns[i]->node = fresh[i];
+	    dtinsert(g->n_seq, sns[i]);
+	}
+	for (size_t i = 0; i < count; i++)
+	    dtinsert(g->n_id, sns[byid[i]]);
+	assert(dtsize(g->n_id) == dtsize(g->n_seq));
+    }
+    free(sns);
+}
+
+/* bulk node constructor: nodes[i] = agnode(g, names[i], TRUE) */
+int agnodes(Agraph_t * g, char **names, size_t count, Agnode_t ** nodes)
+{
+    Agraph_t *root = agroot(g);
+    Agiddisc_t *iddisc = AGDISC(g, id);
+    nodeid_t *ids = gv_calloc(count, sizeof(nodeid_t));
+    Agnode_t **fresh = gv_calloc(count, sizeof(Agnode_t *));
+    size_t *slot = gv_calloc(count, sizeof(size_t));
+    size_t *byid = gv_calloc(count, sizeof(size_t));
+    bool *local = gv_calloc(count, sizeof(bool));
+    bool *made = gv_calloc(count, sizeof(bool));
+    size_t nids = 0, mapped = 0, nfresh = 0;
+    bool sorted = true;
+    int rv = SUCCESS;
+
+    /* reserve an ID for every name the discipline can map, in name order
+     * so the string dictionary is walked rather than searched at random.
+     * Anonymous and internal names take the ordinary path below. */
+    for (size_t i = 0; i < count; i++) {
+	nodes[i] = NULL;
+	if (names[i] && names[i][0] != LOCALNAMEPREFIX)
+	    ids[nids++] = (nodeid_t){.name = names[i], .index = i};
+	else
+	    local[i] = true;
+    }
+    qsort(ids, nids, sizeof(nodeid_t), nodenamecmpf);
+    for (size_t i = 0; i < nids; i++) {
+	if (!iddisc->map(AGCLOS(g, id), AGNODE, ids[i].name, &ids[i].id, TRUE)) {
+	    local[ids[i].index] = true;
+	    continue;
+	}
+	if (mapped > 0 && nodeidcmpf(&ids[mapped - 1], &ids[i]) > 0)
+	    sorted = false;
+	ids[mapped++] = ids[i];
+    }
+    nids = mapped;
+
+    /* in ID order, probing the root is a sequential walk of its tree.
+     * Repeated names share the node of their first occurrence, and any
+     * reservation that did not make a node is given back. */
+    if (!sorted)
+	qsort(ids, nids, sizeof(nodeid_t), nodeidcmpf);
+    for (size_t i = 0; i < nids; i++) {
+	Agnode_t *n;
+	if (i > 0 && ids[i].id == ids[i - 1].id) {
+	    agfreeid(g, AGNODE, ids[i].id);
+	    nodes[ids[i].index] = nodes[ids[i - 1].index];
+	} else if ((n = agfindnode_by_id(root, ids[i].id))) {
+	    agfreeid(g, AGNODE, ids[i].id);
+	    nodes[ids[i].index] = g == root ? n : agsubnode(g, n, TRUE);
+	} else {
+	    nodes[ids[i].index] = newnode(g, ids[i].id, 0);
+	    made[ids[i].index] = true;
+	}
+    }
+
+    /* sequence numbers follow the order of first appearance in names */
+    for (size_t i = 0; i < count; i++) {
+	if (local[i]) {
+	    if (!(nodes[i] = agnode(g, names[i], TRUE)))
+		rv = FAILURE;
+	} else if (made[i]) {
+	    uint64_t seq = agnextseq(g, AGNODE);
+	    assert((seq & SEQ_MASK) == seq && "sequence ID overflow");
+	    AGSEQ(nodes[i]) = seq & SEQ_MASK;
+	    slot[i] = nfresh;
+	    fresh[nfresh++] = nodes[i];
+	}
+    }
+
+    for (size_t i = 0, k = 0; i < nids; i++) {
+	if (made[ids[i].index])
+	    byid[k++] = slot[ids[i].index];
+    }
+
+    installnodes(g, fresh, byid, nfresh);
+    for (size_t i = 0; i < nfresh; i++) {
+	initnode(g, fresh[i]);
+	agregister(g, AGNODE, fresh[i]);
+    }
+
+    free(made);
+    free(local);
+    free(byid);
+    free(slot);
+    free(fresh);
+    free(ids);
+    return rv;
+}
+
 /* removes image of node and its edges from graph.
    caller must ensure n belongs to g. */
 void agdelnodeimage(Agraph_t * g, Agnode_t * n, void *ignored)
@@ -0,0 +1,157 @@
+/// \file
+/// \brief read-only compressed sparse row view of a graph's adjacency
+///
+/// Walking edges with `agfstout`/`agnxtout` and friends means a splay tree
+/// restore and a traversal step per edge. Algorithms that visit the edges of
+/// a graph that they do not change, often many times over, can take a
+/// snapshot once and then scan plain arrays indexed by node number.
+
+#include <assert.h>
+#include <cgraph/alloc.h>
+#include <cgraph/cghdr.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/// a node number lookup used while the snapshot is built
+///
+/// Node sequence numbers are usually dense, in which case a table indexed by
+/// them is used. Otherwise the numbers of nodes are found by binary search of
+/// the node array, which is sorted by sequence number.
+typedef struct {
+  const Agsnapshot_t *s;
+  size_t *byseq; ///< node number per sequence number, or NULL
+} numbering_t;
+
+static size_t search(const Agsnapshot_t *s, Agnode_t *n) {
+  size_t lo = 0, hi = s->nnodes;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (AGSEQ(s->nodes[mid]) < AGSEQ(n)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < s->nnodes && s->nodes[lo] == n) {
+    return lo;
+  }
+  return SIZE_MAX;
+}
+
+static numbering_t numbering_new(const Agsnapshot_t *s) {
+  numbering_t num = {.s = s};
+  if (s->nnodes == 0) {
+    return num;
+  }
+  const uint64_t maxseq = AGSEQ(s->nodes[s->nnodes - 1]);
+  if (maxseq / 2 <= s->nnodes) {
+    num.byseq = gv_calloc((size_t)maxseq + 1, sizeof(size_t));
+    for (size_t i = 0; i < s->nnodes; ++i) {
+      num.byseq[AGSEQ(s->nodes[i])] = i;
+    }
+  }
+  return num;
+}
+
+static size_t number(const numbering_t *num, Agnode_t *n) {
+  if (num->byseq != NULL) {
+    return num->byseq[AGSEQ(n)];
+  }
+  return search(num->s, n);
+}
+
+Agsnapshot_t *agsnapshot(Agraph_t *g) {
+  Agsnapshot_t *s = gv_alloc(sizeof(Agsnapshot_t));
+  s->g = g;
+
+  s->nnodes = (size_t)agnnodes(g);
+  s->nodes = gv_calloc(s->nnodes, sizeof(Agnode_t *));
+  s->out_start = gv_calloc(s->nnodes + 1, sizeof(size_t));
+  s->in_start = gv_calloc(s->nnodes + 1, sizeof(size_t));
+  s->adj_start = gv_calloc(s->nnodes + 1, sizeof(size_t));
+
+  // number the nodes and count their edges
+  size_t i = 0, nout = 0, nin = 0, nloops = 0;
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n), ++i) {
+    s->nodes[i] = n;
+    for (Agedge_t *e = agfstout(g, n); e; e = agnxtout(g, e)) {
+      ++nout;
+      if (aghead(e) == n) {
+        ++nloops;
+      }
+    }
+    s->out_start[i + 1] = nout;
+    for (Agedge_t *e = agfstin(g, n); e; e = agnxtin(g, e)) {
+      ++nin;
+    }
+    s->in_start[i + 1] = nin;
+  }
+  assert(i == s->nnodes);
+  assert(nin == nout);
+  s->nedges = nout;
+
+  s->out_adj = gv_calloc(nout, sizeof(size_t));
+  s->out_edge = gv_calloc(nout, sizeof(Agedge_t *));
+  s->in_adj = gv_calloc(nin, sizeof(size_t));
+  s->in_edge = gv_calloc(nin, sizeof(Agedge_t *));
+  s->adj = gv_calloc(nout + nin - nloops, sizeof(size_t));
+  s->adj_edge = gv_calloc(nout + nin - nloops, sizeof(Agedge_t *));
+
+  numbering_t num = numbering_new(s);
+  size_t k = 0;
+  for (i = 0; i < s->nnodes; ++i) {
+    Agnode_t *n = s->nodes[i];
+    size_t j = s->out_start[i];
+    for (Agedge_t *e = agfstout(g, n); e; e = agnxtout(g, e), ++j) {
+      s->out_edge[j] = e;
+      s->out_adj[j] = number(&num, aghead(e));
+    }
+    j = s->in_start[i];
+    for (Agedge_t *e = agfstin(g, n); e; e = agnxtin(g, e), ++j) {
+      s->in_edge[j] = e;
+      s->in_adj[j] = number(&num, agtail(e));
+    }
+
+    // all edges are the out-edges followed by the in-edges that are not loops,
+    // as agnxtedge visits them
+    for (j = s->out_start[i]; j < s->out_start[i + 1]; ++j, ++k) {
+      s->adj_edge[k] = s->out_edge[j];
+      s->adj[k] = s->out_adj[j];
+    }
+    for (j = s->in_start[i]; j < s->in_start[i + 1]; ++j) {
+      if (s->in_adj[j] == i) {
+        continue;
+      }
+      s->adj_edge[k] = s->in_edge[j];
+      s->adj[k] = s->in_adj[j];
+      ++k;
+    }
+    s->adj_start[i + 1] = k;
+  }
+  assert(k == nout + nin - nloops);
+  free(num.byseq);
+
+  return s;
+}
+
+size_t agsnapindex(const Agsnapshot_t *s, Agnode_t *n) {
+  return search(s, n);
+}
+
+void agsnapfree(Agsnapshot_t *s) {
+  if (s == NULL) {
+    return;
+  }
+  free(s->nodes);
+  free(s->out_start);
+  free(s->out_adj);
+  free(s->out_edge);
+  free(s->in_start);
+  free(s->in_adj);
+  free(s->in_edge);
+  free(s->adj_start);
+  free(s->adj);
+  free(s->adj_edge);
+  free(s);
+}
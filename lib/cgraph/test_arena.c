@@ -0,0 +1,97 @@
+// basic unit tester for arena.h
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <cgraph/arena.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// an arena should start in a known initial state
+static void test_init(void) {
+  arena_t a = {0};
+  assert(a.blocks == NULL);
+  assert(a.total == 0);
+}
+
+// reset of an initialized arena should be OK and idempotent
+static void test_init_reset(void) {
+  arena_t a = {0};
+  arena_reset(&a);
+  arena_reset(&a);
+  arena_reset(&a);
+}
+
+// allocations should be zeroed, aligned and not overlap
+static void test_alloc_many(void) {
+  arena_t a = {0};
+  unsigned char *prev = NULL;
+  size_t prev_size = 0;
+  for (size_t i = 1; i < 5000; ++i) {
+    size_t size = i % 97;
+    unsigned char *p = arena_alloc(&a, size);
+    assert(p != NULL);
+    assert((uintptr_t)p % sizeof(arena_align_t) == 0);
+    for (size_t j = 0; j < size; ++j)
+      assert(p[j] == 0);
+    memset(p, 0xff, size);
+    // within a block, allocations follow one another
+    assert(prev == NULL || p >= prev + prev_size || p + size <= prev);
+    prev = p;
+    prev_size = size;
+  }
+  arena_reset(&a);
+  assert(a.blocks == NULL);
+  assert(a.total == 0);
+}
+
+// a request larger than any block should still be satisfied
+static void test_alloc_large(void) {
+  arena_t a = {0};
+  (void)arena_alloc(&a, 10);
+  size_t size = 3 << 20;
+  unsigned char *p = arena_alloc(&a, size);
+  assert(p != NULL);
+  p[0] = 1;
+  p[size - 1] = 1;
+  unsigned char *q = arena_alloc(&a, 10);
+  assert(q != NULL);
+  assert(q + 10 <= p || q >= p + size);
+  arena_reset(&a);
+}
+
+// an arena should be usable again after a reset
+static void test_reuse(void) {
+  arena_t a = {0};
+  int *x = arena_alloc(&a, sizeof(int));
+  *x = 42;
+  arena_reset(&a);
+  int *y = arena_alloc(&a, sizeof(int));
+  assert(*y == 0);
+  arena_reset(&a);
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(init);
+  RUN(init_reset);
+  RUN(alloc_many);
+  RUN(alloc_large);
+  RUN(reuse);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
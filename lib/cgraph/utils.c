@@ -62,10 +62,26 @@ Dict_t *agdtopen(Agraph_t * g, Dtdisc_t * disc, Dtmethod_t * method)
     return d;
 }
 
+/* dictionaries with external holders allocate and free them on insertion
+ * and deletion, which must come from the graph's own memory discipline */
+int agdtinsert(Agraph_t * g, Dict_t * dict, void *obj)
+{
+    void *rv;
+
+    Ag_dictop_G = g;
+    rv = dtinsert(dict, obj);
+    Ag_dictop_G = NULL;
+    return rv != NULL;
+}
+
 int agdtdelete(Agraph_t * g, Dict_t * dict, void *obj)
 {
+    void *rv;
+
     Ag_dictop_G = g;
-    return dtdelete(dict, obj) != NULL;
+    rv = dtdelete(dict, obj);
+    Ag_dictop_G = NULL;
+    return rv != NULL;
 }
 
 int agdtclose(Agraph_t * g, Dict_t * dict)
@@ -256,6 +256,7 @@
  * Bit(s):  0     unused
  *          1-3   EDGETYPE_
  *          4     NEW_RANK
+ *          5     LARGE_GRAPH
  */
 
 /* edge types */
@@ -269,6 +270,9 @@
 
 /* New ranking is used */
 #define NEW_RANK    	(1 << 4)
+
+/* dot trades layout quality for speed, see largemode */
+#define LARGE_GRAPH    	(1 << 5)
 /******/
 
 /* user-specified node position: ND_pinned */
@@ -23,7 +23,7 @@
 #include <string.h>
 
 static char *usageFmt =
-    "Usage: %s [-Vv?] [-(GNE)name=val] [-(KTlso)<val>] <dot files>\n";
+    "Usage: %s [-Vv?] [-(GNE)name=val] [-(KMTlso)<val>] <dot files>\n";
 
 static char *genericItems = "\n\
  -V          - Print version and exit\n\
@@ -34,6 +34,7 @@ static char *genericItems = "\n\
  -Tv         - Set output format to 'v'\n\
  -Kv         - Set layout engine to 'v' (overrides default based on command name)\n\
  -lv         - Use external library 'v'\n\
+ -Mv         - Set memory allocator for input graphs to 'v' (arena, malloc)\n\
  -ofile      - Write output to 'file'\n\
  -O          - Automatically generate an output filename based on the input filename with a .'format' appended. (Causes all -ofile options to be ignored.) \n\
  -P          - Internally generate a graph of the current plugins. \n\
@@ -212,6 +213,9 @@ static int gvg_init(GVC_t *gvc, graph_t *g, char *fn, int gidx)
 
 static graph_t *P_graph;
 
+/* discipline for graphs read by gvNextInputGraph, as set by -M */
+static Agdisc_t *InputDisc;
+
 graph_t *gvPluginsGraph(GVC_t *gvc)
 {
     gvg_init(gvc, P_graph, "<internal>", 0);
@@ -368,6 +372,17 @@ int dotneato_args_initialize(GVC_t * gvc, int argc, char **argv)
 		}
 		use_library(gvc, val);
 		break;
+	    case 'M':
+		if (streq(rest, "arena"))
+		    InputDisc = &AgArenaDisc;
+		else if (streq(rest, "malloc"))
+		    InputDisc = NULL;
+		else {
+		    fprintf(stderr,
+			    "Invalid parameter \"%s\" for -M flag\n", rest);
+		    return (dotneato_usage(1));
+		}
+		break;
 	    case 'o':
 		val = getFlagOpt(argc, argv, &i);
 		if (!val) {
@@ -539,7 +554,7 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
 	    agsetfile(fn ? fn : "<stdin>");
 	    oldfp = fp;
 	}
-	g = agread(fp,NULL);
+	g = agread(fp,InputDisc);
 	if (g) {
 	    gvg_init(gvc, g, fn, gidx++);
 	    break;
@@ -831,6 +846,7 @@ void graph_cleanup(graph_t *g)
     free(GD_drawing(g));
     GD_drawing(g) = NULL;
     free_label(GD_label(g));
+    free_curved_cycles(g);
     //FIX HERE , STILL SHALLOW
     //memset(&(g->u), 0, sizeof(Agraphinfo_t));
     agclean(g, AGRAPH,"Agraphinfo_t");
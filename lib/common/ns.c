@@ -15,11 +15,13 @@
 
 #include <common/render.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
-static void dfs_cutval(node_t * v, edge_t * par);
-static int dfs_range_init(node_t * v, edge_t * par, int low);
-static int dfs_range(node_t * v, edge_t * par, int low);
-static int x_val(edge_t * e, node_t * v, int dir);
+static void dfs_cutval(ns_context_t * ctx, int v, int par);
+static int dfs_range_init(ns_context_t * ctx, int v, int par, int low);
+static int dfs_range(ns_context_t * ctx, int v, int par, int low);
+static int x_val(ns_context_t * ctx, int e, int v, int dir);
 #ifdef DEBUG
 static void check_cycles(graph_t * g);
 #endif
@@ -29,16 +31,47 @@ static void check_cycles(graph_t * g);
 #define SEQ(a,b,c)		((a) <= (b) && (b) <= (c))
 #define TREE_EDGE(e)	(ED_tree_index(e) >= 0)
 
-static graph_t *G;
-static int N_nodes, N_edges;
-static int Minrank, Maxrank;
-static int S_i;			/* search index for enter_edge */
-static int Search_size;
+/* the same, for edge ids of the dense arrays */
+#define SLACK_ID(ctx,e)	((ctx)->rank[(ctx)->head[e]] - (ctx)->rank[(ctx)->tail[e]] \
+			 - (ctx)->minlen[e])
+#define TREE_EDGE_ID(ctx,e)	((ctx)->tree_index[e] >= 0)
+
 #define SEARCHSIZE 30
-static nlist_t Tree_node;
-static elist Tree_edge;
 
-static int add_tree_edge(edge_t * e)
+/* state of a network simplex solver, see ns_context_new */
+struct ns_context_s {
+    graph_t *G;
+    int N_nodes, N_edges;
+    int Minrank, Maxrank;
+    int S_i;			/* search index for enter_edge */
+    int Search_size;
+    nlist_t Tree_node;
+    elist Tree_edge;
+    int Enter;			/* best entering edge found by enter_edge */
+    int Low, Lim, Slack;
+
+    /* Once the feasible tree is built, pivoting works on dense copies of
+     * the fields it needs, see load_arrays. Nodes are numbered in GD_nlist
+     * order and edges in ND_out order, so the out edges of node v are the
+     * ids out_start[v] to out_start[v+1]-1. The tree edges at v are kept in
+     * the slots of its out and in edges of tree_out and tree_in.
+     */
+    int n_alloc, e_alloc;	/* allocated numbers of nodes and edges */
+    node_t **node;		/* node of each node id */
+    edge_t **edge;		/* edge of each edge id */
+    int *rank, *low, *lim;	/* per node id */
+    int *par;			/* parent tree edge per node id, -1 at the root */
+    int *out_start, *in_start;	/* first adjacency slot per node id */
+    int *in_edge;		/* in edges, in ND_in order */
+    int *tree_out, *tree_in;	/* tree edges at each node */
+    int *n_tree_out, *n_tree_in;	/* number of tree edges at each node */
+    int *tail, *head, *minlen, *weight;	/* per edge id */
+    int *tree_index;		/* position in tree per edge id, -1 if none */
+    int *tree;			/* edge id of each tree edge */
+    int *cut;			/* cut value of each tree edge, as in tree */
+};
+
+static int add_tree_edge(ns_context_t * ctx, edge_t * e)
 {
     node_t *n;
     //fprintf(stderr,"add tree edge %p %s ", (void*)e, agnameof(agtail(e))) ; fprintf(stderr,"%s\n", agnameof(aghead(e))) ;
@@ -46,12 +79,12 @@ static int add_tree_edge(edge_t * e)
 	agerr(AGERR, "add_tree_edge: missing tree edge\n");
 	return -1;
     }
-    ED_tree_index(e) = Tree_edge.size;
-    Tree_edge.list[Tree_edge.size++] = e;
+    ED_tree_index(e) = ctx->Tree_edge.size;
+    ctx->Tree_edge.list[ctx->Tree_edge.size++] = e;
     if (!ND_mark(agtail(e)))
-	Tree_node.list[Tree_node.size++] = agtail(e);
+	ctx->Tree_node.list[ctx->Tree_node.size++] = agtail(e);
     if (!ND_mark(aghead(e)))
-	Tree_node.list[Tree_node.size++] = aghead(e);
+	ctx->Tree_node.list[ctx->Tree_node.size++] = aghead(e);
     n = agtail(e);
     ND_mark(n) = TRUE;
     ND_tree_out(n).list[ND_tree_out(n).size++] = e;
@@ -74,76 +107,73 @@ static int add_tree_edge(edge_t * e)
 /**
  * Invalidate DFS attributes by walking up the tree from to_node till lca
  * (inclusively). Called when updating tree to improve pruning in dfs_range().
- * Assigns ND_low(n) = -1 for the affected nodes.
+ * Assigns low = -1 for the affected nodes.
  */
-static void invalidate_path(node_t *lca, node_t *to_node) {
+static void invalidate_path(ns_context_t *ctx, int lca, int to_node) {
     while (true) {
-        if (ND_low(to_node) == -1)
+        if (ctx->low[to_node] == -1)
           break;
 
-        ND_low(to_node) = -1;
+        ctx->low[to_node] = -1;
 
-        edge_t *e = ND_par(to_node);
-        if (e == NULL)
+        int e = ctx->par[to_node];
+        if (e < 0)
           break;
 
-        if (ND_lim(to_node) >= ND_lim(lca)) {
+        if (ctx->lim[to_node] >= ctx->lim[lca]) {
           if (to_node != lca)
             agerr(AGERR, "invalidate_path: skipped over LCA\n");
           break;
         }
 
-        if (ND_lim(agtail(e)) > ND_lim(aghead(e)))
-          to_node = agtail(e);
+        if (ctx->lim[ctx->tail[e]] > ctx->lim[ctx->head[e]])
+          to_node = ctx->tail[e];
         else
-          to_node = aghead(e);
+          to_node = ctx->head[e];
     }
 }
 
-static void exchange_tree_edges(edge_t * e, edge_t * f)
+static void exchange_tree_edges(ns_context_t * ctx, int e, int f)
 {
-    int i, j;
-    node_t *n;
+    int i, j, n, *list;
 
-    ED_tree_index(f) = ED_tree_index(e);
-    Tree_edge.list[ED_tree_index(e)] = f;
-    ED_tree_index(e) = -1;
+    ctx->tree_index[f] = ctx->tree_index[e];
+    ctx->tree[ctx->tree_index[e]] = f;
+    ctx->tree_index[e] = -1;
 
-    n = agtail(e);
-    i = --ND_tree_out(n).size;
+    n = ctx->tail[e];
+    list = ctx->tree_out + ctx->out_start[n];
+    i = --ctx->n_tree_out[n];
     for (j = 0; j <= i; j++)
-	if (ND_tree_out(n).list[j] == e)
+	if (list[j] == e)
 	    break;
-    ND_tree_out(n).list[j] = ND_tree_out(n).list[i];
-    ND_tree_out(n).list[i] = NULL;
-    n = aghead(e);
-    i = --ND_tree_in(n).size;
+    list[j] = list[i];
+    n = ctx->head[e];
+    list = ctx->tree_in + ctx->in_start[n];
+    i = --ctx->n_tree_in[n];
     for (j = 0; j <= i; j++)
-	if (ND_tree_in(n).list[j] == e)
+	if (list[j] == e)
 	    break;
-    ND_tree_in(n).list[j] = ND_tree_in(n).list[i];
-    ND_tree_in(n).list[i] = NULL;
+    list[j] = list[i];
 
-    n = agtail(f);
-    ND_tree_out(n).list[ND_tree_out(n).size++] = f;
-    ND_tree_out(n).list[ND_tree_out(n).size] = NULL;
-    n = aghead(f);
-    ND_tree_in(n).list[ND_tree_in(n).size++] = f;
-    ND_tree_in(n).list[ND_tree_in(n).size] = NULL;
+    n = ctx->tail[f];
+    ctx->tree_out[ctx->out_start[n] + ctx->n_tree_out[n]++] = f;
+    n = ctx->head[f];
+    ctx->tree_in[ctx->in_start[n] + ctx->n_tree_in[n]++] = f;
 }
 
 static
-void init_rank(void)
+void init_rank(ns_context_t * ctx)
 {
     int i, ctr;
     nodequeue *Q;
     node_t *v;
     edge_t *e;
 
-    Q = new_queue(N_nodes);
+    Q = new_queue(ctx->N_nodes);
     ctr = 0;
 
-    for (v = GD_nlist(G); v; v = ND_next(v)) {
+    for (v = GD_nlist(ctx->G); v; v = ND_next(v)) {
 	if (ND_priority(v) == 0)
 	    enqueue(Q, v);
     }
@@ -158,126 +188,235 @@ void init_rank(void)
 		enqueue(Q, aghead(e));
 	}
     }
-    if (ctr != N_nodes) {
+    if (ctr != ctx->N_nodes) {
 	agerr(AGERR, "trouble in init_rank\n");
-	for (v = GD_nlist(G); v; v = ND_next(v))
+	for (v = GD_nlist(ctx->G); v; v = ND_next(v))
 	    if (ND_priority(v))
 		agerr(AGPREV, "\t%s %d\n", agnameof(v), ND_priority(v));
     }
     free_queue(Q);
 }
 
-static edge_t *leave_edge(void)
+/* next_negative:
+ * Return the first i in [from,end) with cut[i] < 0, or end if there is none.
+ * Most cut values are not negative, so they are checked a block at a time
+ * with a branch-free minimum that the compiler can vectorize.
+ */
+static int next_negative(const int *cut, int from, int end)
 {
-    edge_t *f, *rv = NULL;
-    int j, cnt = 0;
-
-    j = S_i;
-    while (S_i < Tree_edge.size) {
-	if (ED_cutvalue(f = Tree_edge.list[S_i]) < 0) {
-	    if (rv) {
-		if (ED_cutvalue(rv) > ED_cutvalue(f))
-		    rv = f;
-	    } else
-		rv = Tree_edge.list[S_i];
-	    if (++cnt >= Search_size)
-		return rv;
-	}
-	S_i++;
+    enum { BLOCK = 16 };
+    int i, k, m;
+
+    for (i = from; i + BLOCK <= end; i += BLOCK) {
+	m = 0;
+	for (k = 0; k < BLOCK; k++)
+	    m = MIN(m, cut[i + k]);
+	if (m < 0)
+	    break;
+    }
+    while (i < end && cut[i] >= 0)
+	i++;
+    return i;
+}
+
+static int leave_edge(ns_context_t * ctx)
+{
+    int j, cnt = 0, best = -1;
+    const int *cut = ctx->cut;
+    const int n_tree = ctx->Tree_edge.size;
+
+    j = ctx->S_i;
+    while ((ctx->S_i = next_negative(cut, ctx->S_i, n_tree)) < n_tree) {
+	if (best < 0 || cut[best] > cut[ctx->S_i])
+	    best = ctx->S_i;
+	if (++cnt >= ctx->Search_size)
+	    return ctx->tree[best];
+	ctx->S_i++;
     }
     if (j > 0) {
-	S_i = 0;
-	while (S_i < j) {
-	    if (ED_cutvalue(f = Tree_edge.list[S_i]) < 0) {
-		if (rv) {
-		    if (ED_cutvalue(rv) > ED_cutvalue(f))
-			rv = f;
-		} else
-		    rv = Tree_edge.list[S_i];
-		if (++cnt >= Search_size)
-		    return rv;
-	    }
-	    S_i++;
+	ctx->S_i = 0;
+	while ((ctx->S_i = next_negative(cut, ctx->S_i, j)) < j) {
+	    if (best < 0 || cut[best] > cut[ctx->S_i])
+		best = ctx->S_i;
+	    if (++cnt >= ctx->Search_size)
+		return ctx->tree[best];
+	    ctx->S_i++;
 	}
     }
-    return rv;
+    return best < 0 ? -1 : ctx->tree[best];
 }
 
-static edge_t *Enter;
-static int Low, Lim, Slack;
-
-static void dfs_enter_outedge(node_t * v)
+static void dfs_enter_outedge(ns_context_t * ctx, int v)
 {
-    int i, slack;
-    edge_t *e;
-
-    for (i = 0; (e = ND_out(v).list[i]); i++) {
-	if (!TREE_EDGE(e)) {
-	    if (!SEQ(Low, ND_lim(aghead(e)), Lim)) {
-		slack = SLACK(e);
-		if (slack < Slack || Enter == NULL) {
-		    Enter = e;
-		    Slack = slack;
+    int e, i, slack;
+    const int *tree_in = ctx->tree_in + ctx->in_start[v];
+
+    for (e = ctx->out_start[v]; e < ctx->out_start[v + 1]; e++) {
+	if (!TREE_EDGE_ID(ctx, e)) {
+	    if (!SEQ(ctx->Low, ctx->lim[ctx->head[e]], ctx->Lim)) {
+		slack = SLACK_ID(ctx, e);
+		if (slack < ctx->Slack || ctx->Enter < 0) {
+		    ctx->Enter = e;
+		    ctx->Slack = slack;
 		}
 	    }
-	} else if (ND_lim(aghead(e)) < ND_lim(v))
-	    dfs_enter_outedge(aghead(e));
+	} else if (ctx->lim[ctx->head[e]] < ctx->lim[v])
+	    dfs_enter_outedge(ctx, ctx->head[e]);
     }
-    for (i = 0; (e = ND_tree_in(v).list[i]) && (Slack > 0); i++)
-	if (ND_lim(agtail(e)) < ND_lim(v))
-	    dfs_enter_outedge(agtail(e));
+    for (i = 0; i < ctx->n_tree_in[v] && ctx->Slack > 0; i++)
+	if (ctx->lim[ctx->tail[tree_in[i]]] < ctx->lim[v])
+	    dfs_enter_outedge(ctx, ctx->tail[tree_in[i]]);
 }
 
-static void dfs_enter_inedge(node_t * v)
+static void dfs_enter_inedge(ns_context_t * ctx, int v)
 {
-    int i, slack;
-    edge_t *e;
-
-    for (i = 0; (e = ND_in(v).list[i]); i++) {
-	if (!TREE_EDGE(e)) {
-	    if (!SEQ(Low, ND_lim(agtail(e)), Lim)) {
-		slack = SLACK(e);
-		if (slack < Slack || Enter == NULL) {
-		    Enter = e;
-		    Slack = slack;
+    int e, i, slack;
+    const int *tree_out = ctx->tree_out + ctx->out_start[v];
+
+    for (i = ctx->in_start[v]; i < ctx->in_start[v + 1]; i++) {
+	e = ctx->in_edge[i];
+	if (!TREE_EDGE_ID(ctx, e)) {
+	    if (!SEQ(ctx->Low, ctx->lim[ctx->tail[e]], ctx->Lim)) {
+		slack = SLACK_ID(ctx, e);
+		if (slack < ctx->Slack || ctx->Enter < 0) {
+		    ctx->Enter = e;
+		    ctx->Slack = slack;
 		}
 	    }
-	} else if (ND_lim(agtail(e)) < ND_lim(v))
-	    dfs_enter_inedge(agtail(e));
+	} else if (ctx->lim[ctx->tail[e]] < ctx->lim[v])
+	    dfs_enter_inedge(ctx, ctx->tail[e]);
     }
-    for (i = 0; (e = ND_tree_out(v).list[i]) && Slack > 0; i++)
-	if (ND_lim(aghead(e)) < ND_lim(v))
-	    dfs_enter_inedge(aghead(e));
+    for (i = 0; i < ctx->n_tree_out[v] && ctx->Slack > 0; i++)
+	if (ctx->lim[ctx->head[tree_out[i]]] < ctx->lim[v])
+	    dfs_enter_inedge(ctx, ctx->head[tree_out[i]]);
 }
 
-static edge_t *enter_edge(edge_t * e)
+static int enter_edge(ns_context_t * ctx, int e)
 {
-    node_t *v;
+    int v;
     int outsearch;
 
     /* v is the down node */
-    if (ND_lim(agtail(e)) < ND_lim(aghead(e))) {
-	v = agtail(e);
+    if (ctx->lim[ctx->tail[e]] < ctx->lim[ctx->head[e]]) {
+	v = ctx->tail[e];
 	outsearch = FALSE;
     } else {
-	v = aghead(e);
+	v = ctx->head[e];
 	outsearch = TRUE;
     }
-    Enter = NULL;
-    Slack = INT_MAX;
-    Low = ND_low(v);
-    Lim = ND_lim(v);
+    ctx->Enter = -1;
+    ctx->Slack = INT_MAX;
+    ctx->Low = ctx->low[v];
+    ctx->Lim = ctx->lim[v];
     if (outsearch)
-	dfs_enter_outedge(v);
+	dfs_enter_outedge(ctx, v);
     else
-	dfs_enter_inedge(v);
-    return Enter;
+	dfs_enter_inedge(ctx, v);
+    return ctx->Enter;
+}
+
+/* load_arrays:
+ * Copy what pivoting needs of the graph and of the feasible tree into the
+ * dense arrays of ctx. While this runs, ND_low holds the id of a node and
+ * ED_cutvalue that of an edge; store_arrays puts the cut values back.
+ */
+static void load_arrays(ns_context_t * ctx)
+{
+    int i, v, id, n_in;
+    node_t *n;
+    edge_t *e;
+
+    if (ctx->N_nodes > ctx->n_alloc) {
+	ctx->n_alloc = ctx->N_nodes;
+	ctx->node = ALLOC(ctx->n_alloc, ctx->node, node_t *);
+	ctx->rank = ALLOC(ctx->n_alloc, ctx->rank, int);
+	ctx->low = ALLOC(ctx->n_alloc, ctx->low, int);
+	ctx->lim = ALLOC(ctx->n_alloc, ctx->lim, int);
+	ctx->par = ALLOC(ctx->n_alloc, ctx->par, int);
+	ctx->out_start = ALLOC(ctx->n_alloc + 1, ctx->out_start, int);
+	ctx->in_start = ALLOC(ctx->n_alloc + 1, ctx->in_start, int);
+	ctx->n_tree_out = ALLOC(ctx->n_alloc, ctx->n_tree_out, int);
+	ctx->n_tree_in = ALLOC(ctx->n_alloc, ctx->n_tree_in, int);
+	ctx->tree = ALLOC(ctx->n_alloc, ctx->tree, int);
+	ctx->cut = ALLOC(ctx->n_alloc, ctx->cut, int);
+    }
+    if (ctx->N_edges > ctx->e_alloc) {
+	ctx->e_alloc = ctx->N_edges;
+	ctx->edge = ALLOC(ctx->e_alloc, ctx->edge, edge_t *);
+	ctx->in_edge = ALLOC(ctx->e_alloc, ctx->in_edge, int);
+	ctx->tree_out = ALLOC(ctx->e_alloc, ctx->tree_out, int);
+	ctx->tree_in = ALLOC(ctx->e_alloc, ctx->tree_in, int);
+	ctx->tail = ALLOC(ctx->e_alloc, ctx->tail, int);
+	ctx->head = ALLOC(ctx->e_alloc, ctx->head, int);
+	ctx->minlen = ALLOC(ctx->e_alloc, ctx->minlen, int);
+	ctx->weight = ALLOC(ctx->e_alloc, ctx->weight, int);
+	ctx->tree_index = ALLOC(ctx->e_alloc, ctx->tree_index, int);
+    }
+
+    for (v = 0, n = GD_nlist(ctx->G); n; v++, n = ND_next(n)) {
+	ctx->node[v] = n;
+	ctx->rank[v] = ND_rank(n);
+	ND_low(n) = v;
+    }
+    for (id = 0, v = 0; v < ctx->N_nodes; v++) {
+	n = ctx->node[v];
+	ctx->out_start[v] = id;
+	for (i = 0; (e = ND_out(n).list[i]); i++, id++) {
+	    ctx->edge[id] = e;
+	    ctx->tail[id] = ND_low(agtail(e));
+	    ctx->head[id] = ND_low(aghead(e));
+	    ctx->minlen[id] = ED_minlen(e);
+	    ctx->weight[id] = ED_weight(e);
+	    ctx->tree_index[id] = ED_tree_index(e);
+	    if (TREE_EDGE(e))
+		ctx->tree[ED_tree_index(e)] = id;
+	    ED_cutvalue(e) = id;
+	}
+    }
+    ctx->out_start[ctx->N_nodes] = id;
+    for (n_in = 0, v = 0; v < ctx->N_nodes; v++) {
+	n = ctx->node[v];
+	ctx->in_start[v] = n_in;
+	for (i = 0; (e = ND_in(n).list[i]); i++)
+	    ctx->in_edge[n_in++] = ED_cutvalue(e);
+	ctx->n_tree_in[v] = ND_tree_in(n).size;
+	for (i = 0; i < ND_tree_in(n).size; i++)
+	    ctx->tree_in[ctx->in_start[v] + i] =
+		ED_cutvalue(ND_tree_in(n).list[i]);
+	ctx->n_tree_out[v] = ND_tree_out(n).size;
+	for (i = 0; i < ND_tree_out(n).size; i++)
+	    ctx->tree_out[ctx->out_start[v] + i] =
+		ED_cutvalue(ND_tree_out(n).list[i]);
+    }
+    ctx->in_start[ctx->N_nodes] = n_in;
+    assert(n_in == ctx->N_edges);
 }
 
-static void init_cutvalues(void)
+/* store_arrays:
+ * Write the results of pivoting back into the graph and into Tree_edge,
+ * which seeds the next warm start.
+ */
+static void store_arrays(ns_context_t * ctx)
 {
-    dfs_range_init(GD_nlist(G), NULL, 1);
-    dfs_cutval(GD_nlist(G), NULL);
+    int v, id, i;
+    edge_t *e;
+
+    for (v = 0; v < ctx->N_nodes; v++)
+	ND_rank(ctx->node[v]) = ctx->rank[v];
+    for (id = 0; id < ctx->N_edges; id++) {
+	e = ctx->edge[id];
+	i = ctx->tree_index[id];
+	ED_tree_index(e) = i;
+	ED_cutvalue(e) = i >= 0 ? ctx->cut[i] : 0;
+    }
+    for (i = 0; i < ctx->Tree_edge.size; i++)
+	ctx->Tree_edge.list[i] = ctx->edge[ctx->tree[i]];
+}
+
+static void init_cutvalues(ns_context_t * ctx)
+{
+    dfs_range_init(ctx, 0, -1, 1);
+    dfs_cutval(ctx, 0, -1);
 }
 
 /* functions for initial tight tree construction */
@@ -292,42 +431,98 @@ typedef struct subtree_s {
         struct subtree_s *par;  /* union find */
 } subtree_t;
 
-/* find initial tight subtrees */
-static int tight_subtree_search(Agnode_t *v, subtree_t *st)
+/* add the nodes joined to v by tree edges seeded by seed_tree() to st,
+ * appending them to list
+ */
+static void seeded_subtree(Agnode_t *v, subtree_t *st, nlist_t *list)
+{
+    Agedge_t *e;
+    Agnode_t *w;
+    int     i;
+
+    for (i = 0; (e = ND_tree_in(v).list[i]); i++) {
+        w = agtail(e);
+        if (ND_subtree(w) == 0) {
+            ND_subtree_set(w,st);
+            list->list = ALLOC(list->size + 1, list->list, node_t *);
+            list->list[list->size++] = w;
+            seeded_subtree(w, st, list);
+        }
+    }
+    for (i = 0; (e = ND_tree_out(v).list[i]); i++) {
+        w = aghead(e);
+        if (ND_subtree(w) == 0) {
+            ND_subtree_set(w,st);
+            list->list = ALLOC(list->size + 1, list->list, node_t *);
+            list->list[list->size++] = w;
+            seeded_subtree(w, st, list);
+        }
+    }
+}
+
+static int tight_subtree_search(ns_context_t * ctx, Agnode_t *v, subtree_t *st);
+
+/* extend st from v along tight edges */
+static int tight_edge_search(ns_context_t * ctx, Agnode_t *v, subtree_t *st)
 {
     Agedge_t *e;
     int     i;
     int     rv;
 
-    rv = 1;
-    ND_subtree_set(v,st);
+    rv = 0;
     for (i = 0; (e = ND_in(v).list[i]); i++) {
         if (TREE_EDGE(e)) continue;
         if (ND_subtree(agtail(e)) == 0 && SLACK(e) == 0) {
-               if (add_tree_edge(e) != 0) {
+               if (add_tree_edge(ctx, e) != 0) {
                    return -1;
                }
-               rv += tight_subtree_search(agtail(e),st);
+               rv += tight_subtree_search(ctx, agtail(e),st);
         }
     }
     for (i = 0; (e = ND_out(v).list[i]); i++) {
         if (TREE_EDGE(e)) continue;
         if (ND_subtree(aghead(e)) == 0 && SLACK(e) == 0) {
-               if (add_tree_edge(e) != 0) {
+               if (add_tree_edge(ctx, e) != 0) {
                    return -1;
                }
-               rv += tight_subtree_search(aghead(e),st);
+               rv += tight_subtree_search(ctx, aghead(e),st);
+        }
+    }
+    return rv;
+}
+
+/* find initial tight subtrees */
+static int tight_subtree_search(ns_context_t * ctx, Agnode_t *v, subtree_t *st)
+{
+    nlist_t seeded = {0};
+    int     i, n;
+    int     rv;
+
+    rv = 1;
+    ND_subtree_set(v,st);
+    /* All of a seeded tree must belong to st before any tight edge is
+     * added, or the tight edge could close a cycle with it.
+     */
+    seeded_subtree(v, st, &seeded);
+    rv += seeded.size;
+    for (i = -1; i < seeded.size; i++) {
+        n = tight_edge_search(ctx, i < 0 ? v : seeded.list[i], st);
+        if (n < 0) {
+            rv = -1;
+            break;
         }
+        rv += n;
     }
+    free(seeded.list);
     return rv;
 }
 
-static subtree_t *find_tight_subtree(Agnode_t *v)
+static subtree_t *find_tight_subtree(ns_context_t * ctx, Agnode_t *v)
 {
     subtree_t       *rv;
     rv = NEW(subtree_t);
     rv->rep = v;
-    rv->size = tight_subtree_search(v,rv);
+    rv->size = tight_subtree_search(ctx, v,rv);
     if (rv->size < 0) {
         free(rv);
         return NULL;
@@ -487,7 +682,7 @@ void tree_adjust(Agnode_t *v, Agnode_t *from, int delta)
 }
 
 static
-subtree_t *merge_trees(Agedge_t *e)   /* entering tree edge */
+subtree_t *merge_trees(ns_context_t * ctx, Agedge_t *e)   /* entering tree edge */
 {
   int       delta;
   subtree_t *t0, *t1, *rv;
@@ -497,7 +692,7 @@ subtree_t *merge_trees(Agedge_t *e)   /* entering tree edge */
   t0 = STsetFind(agtail(e));
   t1 = STsetFind(aghead(e));
 
-  //fprintf(stderr,"merge trees of %d %d of %d, delta %d\n",t0->size,t1->size,N_nodes,delta);
+  //fprintf(stderr,"merge trees of %d %d of %d, delta %d\n",t0->size,t1->size,ctx->N_nodes,delta);
 
   if (t0->heap_index == -1) {   // move t0
     delta = SLACK(e);
@@ -509,7 +704,7 @@ subtree_t *merge_trees(Agedge_t *e)   /* entering tree edge */
     if (delta != 0)
       tree_adjust(t1->rep,NULL,delta);
   }
-  if (add_tree_edge(e) != 0) {
+  if (add_tree_edge(ctx, e) != 0) {
     return NULL;
   }
   rv = STsetUnion(t0,t1);
@@ -523,7 +718,7 @@ subtree_t *merge_trees(Agedge_t *e)   /* entering tree edge */
  * Return 1 if input graph is not connected; 0 on success.
  */
 static
-int feasible_tree(void)
+int feasible_tree(ns_context_t * ctx)
 {
   Agnode_t *n;
   Agedge_t *ee;
@@ -533,15 +728,15 @@ int feasible_tree(void)
   int error = 0;
 
   /* initialization */
-  for (n = GD_nlist(G); n; n = ND_next(n)) {
+  for (n = GD_nlist(ctx->G); n; n = ND_next(n)) {
       ND_subtree_set(n,0);
   }
 
-  tree = N_NEW(N_nodes,subtree_t*);
+  tree = N_NEW(ctx->N_nodes,subtree_t*);
   /* given init_rank, find all tight subtrees */
-  for (n = GD_nlist(G); n; n = ND_next(n)) {
+  for (n = GD_nlist(ctx->G); n; n = ND_next(n)) {
         if (ND_subtree(n) == 0) {
-                tree[subtree_count] = find_tight_subtree(n);
+                tree[subtree_count] = find_tight_subtree(ctx, n);
                 if (tree[subtree_count] == NULL) {
                     error = 2;
                     goto end;
@@ -558,7 +753,7 @@ int feasible_tree(void)
       error = 1;
       break;
     }
-    tree1 = merge_trees(ee);
+    tree1 = merge_trees(ctx, ee);
     if (tree1 == NULL) {
       error = 2;
       break;
@@ -571,114 +766,113 @@ end:
   for (i = 0; i < subtree_count; i++) free(tree[i]);
   free(tree);
   if (error) return error;
-  assert(Tree_edge.size == N_nodes - 1);
-  init_cutvalues();
+  assert(ctx->Tree_edge.size == ctx->N_nodes - 1);
   return 0;
 }
 
 /* walk up from v to LCA(v,w), setting new cutvalues. */
-static Agnode_t *treeupdate(Agnode_t * v, Agnode_t * w, int cutvalue, int dir)
+static int treeupdate(ns_context_t * ctx, int v, int w, int cutvalue, int dir)
 {
-    edge_t *e;
-    int d;
+    int e, d;
 
-    while (!SEQ(ND_low(v), ND_lim(w), ND_lim(v))) {
-	e = ND_par(v);
-	if (v == agtail(e))
+    while (!SEQ(ctx->low[v], ctx->lim[w], ctx->lim[v])) {
+	e = ctx->par[v];
+	if (v == ctx->tail[e])
 	    d = dir;
 	else
 	    d = !dir;
 	if (d)
-	    ED_cutvalue(e) += cutvalue;
+	    ctx->cut[ctx->tree_index[e]] += cutvalue;
 	else
-	    ED_cutvalue(e) -= cutvalue;
-	if (ND_lim(agtail(e)) > ND_lim(aghead(e)))
-	    v = agtail(e);
+	    ctx->cut[ctx->tree_index[e]] -= cutvalue;
+	if (ctx->lim[ctx->tail[e]] > ctx->lim[ctx->head[e]])
+	    v = ctx->tail[e];
 	else
-	    v = aghead(e);
+	    v = ctx->head[e];
     }
     return v;
 }
 
-static void rerank(Agnode_t * v, int delta)
+static void rerank(ns_context_t * ctx, int v, int delta)
 {
-    int i;
-    edge_t *e;
-
-    ND_rank(v) -= delta;
-    for (i = 0; (e = ND_tree_out(v).list[i]); i++)
-	if (e != ND_par(v))
-	    rerank(aghead(e), delta);
-    for (i = 0; (e = ND_tree_in(v).list[i]); i++)
-	if (e != ND_par(v))
-	    rerank(agtail(e), delta);
+    int i, e;
+    const int *tree_out = ctx->tree_out + ctx->out_start[v];
+    const int *tree_in = ctx->tree_in + ctx->in_start[v];
+
+    ctx->rank[v] -= delta;
+    for (i = 0; i < ctx->n_tree_out[v]; i++)
+	if ((e = tree_out[i]) != ctx->par[v])
+	    rerank(ctx, ctx->head[e], delta);
+    for (i = 0; i < ctx->n_tree_in[v]; i++)
+	if ((e = tree_in[i]) != ctx->par[v])
+	    rerank(ctx, ctx->tail[e], delta);
 }
 
 /* e is the tree edge that is leaving and f is the nontree edge that
  * is entering.  compute new cut values, ranks, and exchange e and f.
  */
 static int
-update(edge_t * e, edge_t * f)
+update(ns_context_t * ctx, int e, int f)
 {
-    int cutvalue, delta;
-    Agnode_t *lca;
+    int cutvalue, delta, lca;
+    int t = ctx->tail[e], h = ctx->head[e];
 
-    delta = SLACK(f);
-    /* "for (v = in nodes in tail side of e) do ND_rank(v) -= delta;" */
+    delta = SLACK_ID(ctx, f);
+    /* "for (v = in nodes in tail side of e) do rank(v) -= delta;" */
     if (delta > 0) {
 	int s;
-	s = ND_tree_in(agtail(e)).size + ND_tree_out(agtail(e)).size;
+	s = ctx->n_tree_in[t] + ctx->n_tree_out[t];
 	if (s == 1)
-	    rerank(agtail(e), delta);
+	    rerank(ctx, t, delta);
 	else {
-	    s = ND_tree_in(aghead(e)).size + ND_tree_out(aghead(e)).size;
+	    s = ctx->n_tree_in[h] + ctx->n_tree_out[h];
 	    if (s == 1)
-		rerank(aghead(e), -delta);
+		rerank(ctx, h, -delta);
 	    else {
-		if (ND_lim(agtail(e)) < ND_lim(aghead(e)))
-		    rerank(agtail(e), delta);
+		if (ctx->lim[t] < ctx->lim[h])
+		    rerank(ctx, t, delta);
 		else
-		    rerank(aghead(e), -delta);
+		    rerank(ctx, h, -delta);
 	    }
 	}
     }
 
-    cutvalue = ED_cutvalue(e);
-    lca = treeupdate(agtail(f), aghead(f), cutvalue, 1);
-    if (treeupdate(aghead(f), agtail(f), cutvalue, 0) != lca) {
+    cutvalue = ctx->cut[ctx->tree_index[e]];
+    lca = treeupdate(ctx, ctx->tail[f], ctx->head[f], cutvalue, 1);
+    if (treeupdate(ctx, ctx->head[f], ctx->tail[f], cutvalue, 0) != lca) {
 	agerr(AGERR, "update: mismatched lca in treeupdates\n");
 	return 2;
     }
 
     // invalidate paths from LCA till affected nodes:
-    int lca_low = ND_low(lca);
-    invalidate_path(lca, aghead(f));
-    invalidate_path(lca, agtail(f));
-
-    ED_cutvalue(f) = -cutvalue;
-    ED_cutvalue(e) = 0;
-    exchange_tree_edges(e, f);
-    dfs_range(lca, ND_par(lca), lca_low);
+    int lca_low = ctx->low[lca];
+    invalidate_path(ctx, lca, ctx->head[f]);
+    invalidate_path(ctx, lca, ctx->tail[f]);
+
+    /* f takes over the position of e in the tree */
+    ctx->cut[ctx->tree_index[e]] = -cutvalue;
+    exchange_tree_edges(ctx, e, f);
+    dfs_range(ctx, lca, ctx->par[lca], lca_low);
     return 0;
 }
 
-static void scan_and_normalize(void)
+static void scan_and_normalize(ns_context_t * ctx)
 {
     node_t *n;
 
-    Minrank = INT_MAX;
-    Maxrank = -INT_MAX;
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
+    ctx->Minrank = INT_MAX;
+    ctx->Maxrank = -INT_MAX;
+    for (n = GD_nlist(ctx->G); n; n = ND_next(n)) {
 	if (ND_node_type(n) == NORMAL) {
-	    Minrank = MIN(Minrank, ND_rank(n));
-	    Maxrank = MAX(Maxrank, ND_rank(n));
+	    ctx->Minrank = MIN(ctx->Minrank, ND_rank(n));
+	    ctx->Maxrank = MAX(ctx->Maxrank, ND_rank(n));
 	}
     }
-    if (Minrank != 0) {
-	for (n = GD_nlist(G); n; n = ND_next(n))
-	    ND_rank(n) -= Minrank;
-	Maxrank -= Minrank;
-	Minrank = 0;
+    if (ctx->Minrank != 0) {
+	for (n = GD_nlist(ctx->G); n; n = ND_next(n))
+	    ND_rank(n) -= ctx->Minrank;
+	ctx->Maxrank -= ctx->Minrank;
+	ctx->Minrank = 0;
     }
 }
 
@@ -693,27 +887,25 @@ freeTreeList (graph_t* g)
     }
 }
 
-static void LR_balance(void)
+static void LR_balance(ns_context_t * ctx)
 {
-    int i, delta;
-    edge_t *e, *f;
-
-    for (i = 0; i < Tree_edge.size; i++) {
-	e = Tree_edge.list[i];
-	if (ED_cutvalue(e) == 0) {
-	    f = enter_edge(e);
-	    if (f == NULL)
+    int i, delta, e, f;
+
+    for (i = 0; i < ctx->Tree_edge.size; i++) {
+	if (ctx->cut[i] == 0) {
+	    e = ctx->tree[i];
+	    f = enter_edge(ctx, e);
+	    if (f < 0)
 		continue;
-	    delta = SLACK(f);
+	    delta = SLACK_ID(ctx, f);
 	    if (delta <= 1)
 		continue;
-	    if (ND_lim(agtail(e)) < ND_lim(aghead(e)))
-		rerank(agtail(e), delta / 2);
+	    if (ctx->lim[ctx->tail[e]] < ctx->lim[ctx->head[e]])
+		rerank(ctx, ctx->tail[e], delta / 2);
 	    else
-		rerank(aghead(e), -delta / 2);
+		rerank(ctx, ctx->head[e], -delta / 2);
 	}
     }
-    freeTreeList (G);
 }
 
 static int decreasingrankcmpf(node_t **n0, node_t **n1) {
@@ -736,7 +928,7 @@ static int increasingrankcmpf(node_t **n0, node_t **n1) {
   return 0;
 }
 
-static void TB_balance(void)
+static void TB_balance(ns_context_t * ctx)
 {
     node_t *n;
     edge_t *e;
@@ -745,44 +937,44 @@ static void TB_balance(void)
     int adj = 0;
     char *s;
 
-    scan_and_normalize();
+    scan_and_normalize(ctx);
 
     /* find nodes that are not tight and move to less populated ranks */
-    nrank = N_NEW(Maxrank + 1, int);
-    for (i = 0; i <= Maxrank; i++)
+    nrank = N_NEW(ctx->Maxrank + 1, int);
+    for (i = 0; i <= ctx->Maxrank; i++)
 	nrank[i] = 0;
-    if ( (s = agget(G,"TBbalance")) ) {
+    if ( (s = agget(ctx->G,"TBbalance")) ) {
          if (streq(s,"min")) adj = 1;
          else if (streq(s,"max")) adj = 2;
-         if (adj) for (n = GD_nlist(G); n; n = ND_next(n))
+         if (adj) for (n = GD_nlist(ctx->G); n; n = ND_next(n))
               if (ND_node_type(n) == NORMAL) {
                 if (ND_in(n).size == 0 && adj == 1) {
-                   ND_rank(n) = Minrank;
+                   ND_rank(n) = ctx->Minrank;
                 }
                 if (ND_out(n).size == 0 && adj == 2) {
-                   ND_rank(n) = Maxrank;
+                   ND_rank(n) = ctx->Maxrank;
                 }
               }
     }
-    for (ii = 0, n = GD_nlist(G); n; ii++, n = ND_next(n)) {
-      Tree_node.list[ii] = n;
+    for (ii = 0, n = GD_nlist(ctx->G); n; ii++, n = ND_next(n)) {
+      ctx->Tree_node.list[ii] = n;
     }
-    Tree_node.size = ii;
-    qsort(Tree_node.list, Tree_node.size, sizeof(Tree_node.list[0]),
+    ctx->Tree_node.size = ii;
+    qsort(ctx->Tree_node.list, ctx->Tree_node.size, sizeof(ctx->Tree_node.list[0]),
         adj > 1? (int(*)(const void*,const void*))decreasingrankcmpf
                : (int(*)(const void*,const void*))increasingrankcmpf);
-    for (i = 0; i < Tree_node.size; i++) {
-        n = Tree_node.list[i];
+    for (i = 0; i < ctx->Tree_node.size; i++) {
+        n = ctx->Tree_node.list[i];
         if (ND_node_type(n) == NORMAL)
           nrank[ND_rank(n)]++;
     }
-    for (ii = 0; ii < Tree_node.size; ii++) {
-      n = Tree_node.list[ii];
+    for (ii = 0; ii < ctx->Tree_node.size; ii++) {
+      n = ctx->Tree_node.list[ii];
       if (ND_node_type(n) != NORMAL)
         continue;
       inweight = outweight = 0;
       low = 0;
-      high = Maxrank;
+      high = ctx->Maxrank;
       for (i = 0; (e = ND_in(n).list[i]); i++) {
         inweight += ED_weight(e);
         low = MAX(low, ND_rank(agtail(e)) + ED_minlen(e));
@@ -815,25 +1007,25 @@ static void TB_balance(void)
     free(nrank);
 }
 
-static int init_graph(graph_t * g)
+static int init_graph(ns_context_t * ctx, graph_t * g)
 {
     int i, feasible;
     node_t *n;
     edge_t *e;
 
-    G = g;
-    N_nodes = N_edges = S_i = 0;
+    ctx->G = g;
+    ctx->N_nodes = ctx->N_edges = ctx->S_i = 0;
     for (n = GD_nlist(g); n; n = ND_next(n)) {
 	ND_mark(n) = FALSE;
-	N_nodes++;
+	ctx->N_nodes++;
 	for (i = 0; (e = ND_out(n).list[i]); i++)
-	    N_edges++;
+	    ctx->N_edges++;
     }
 
-    Tree_node.list = ALLOC(N_nodes, Tree_node.list, node_t *);
-    Tree_node.size = 0;
-    Tree_edge.list = ALLOC(N_nodes, Tree_edge.list, edge_t *);
-    Tree_edge.size = 0;
+    ctx->Tree_node.list = ALLOC(ctx->N_nodes, ctx->Tree_node.list, node_t *);
+    ctx->Tree_node.size = 0;
+    ctx->Tree_edge.list = ALLOC(ctx->N_nodes, ctx->Tree_edge.list, edge_t *);
+    ctx->Tree_edge.size = 0;
 
     feasible = TRUE;
     for (n = GD_nlist(g); n; n = ND_next(n)) {
@@ -855,6 +1047,108 @@ static int init_graph(graph_t * g)
     return feasible;
 }
 
+/* repair_ranks:
+ * Restore feasibility after edges were added to or changed in a graph
+ * whose ranks were feasible before. Only the heads of violated edges, and
+ * transitively the nodes below them, are moved down. Returns false if the
+ * ranks do not settle, which means the constraints are cyclic.
+ */
+static bool repair_ranks(ns_context_t * ctx)
+{
+    int i;
+    nodequeue *Q;
+    node_t *n, *v;
+    edge_t *e;
+    bool ok = true;
+
+    Q = new_queue(ctx->N_nodes + 1);
+    for (n = GD_nlist(ctx->G); n; n = ND_next(n)) {
+	ND_low(n) = 0;		/* number of times n was moved */
+	for (i = 0; (e = ND_in(n).list[i]); i++) {
+	    if (SLACK(e) < 0 && !ND_mark(n)) {
+		ND_mark(n) = TRUE;
+		enqueue(Q, n);
+	    }
+	}
+    }
+
+    while ((v = dequeue(Q))) {
+	ND_mark(v) = FALSE;
+	if (!ok)
+	    continue;
+	for (i = 0; (e = ND_in(v).list[i]); i++)
+	    ND_rank(v) = MAX(ND_rank(v), ND_rank(agtail(e)) + ED_minlen(e));
+	if (++ND_low(v) > ctx->N_nodes) {
+	    ok = false;
+	    continue;
+	}
+	for (i = 0; (e = ND_out(v).list[i]); i++) {
+	    n = aghead(e);
+	    if (SLACK(e) < 0 && !ND_mark(n)) {
+		ND_mark(n) = TRUE;
+		enqueue(Q, n);
+	    }
+	}
+    }
+    free_queue(Q);
+    return ok;
+}
+
+static int edgeptrcmpf(const void *x, const void *y)
+{
+    const edge_t *const *e0 = x;
+    const edge_t *const *e1 = y;
+    if (*e0 < *e1)
+	return -1;
+    if (*e0 > *e1)
+	return 1;
+    return 0;
+}
+
+static int uf_find(int *par, int i)
+{
+    while (par[i] != i)
+	i = par[i] = par[par[i]];
+    return i;
+}
+
+/* seed_tree:
+ * Start the feasible tree from the edges of a previous tree that are still
+ * in the graph and still tight. The old edges are given as a sorted array
+ * of pointers; these are only compared, never dereferenced, as some may
+ * have been deleted since.
+ */
+static int seed_tree(ns_context_t * ctx, edge_t ** old, size_t n_old)
+{
+    int i, j, k, *par;
+    node_t *n;
+    edge_t *e;
+
+    par = N_NEW(ctx->N_nodes, int);
+    for (k = 0, n = GD_nlist(ctx->G); n; k++, n = ND_next(n)) {
+	ND_low(n) = k;
+	par[k] = k;
+    }
+    for (n = GD_nlist(ctx->G); n; n = ND_next(n)) {
+	for (i = 0; (e = ND_out(n).list[i]); i++) {
+	    if (SLACK(e) != 0
+		|| !bsearch(&e, old, n_old, sizeof(old[0]), edgeptrcmpf))
+		continue;
+	    j = uf_find(par, ND_low(agtail(e)));
+	    k = uf_find(par, ND_low(aghead(e)));
+	    if (j == k)
+		continue;
+	    par[j] = k;
+	    if (add_tree_edge(ctx, e) != 0) {
+		free(par);
+		return 2;
+	    }
+	}
+    }
+    free(par);
+    return 0;
+}
+
 /* graphSize:
  * Compute no. of nodes and edges in the graph
  */
@@ -876,7 +1170,7 @@ graphSize (graph_t * g, int* nn, int* ne)
     *ne = nedges;
 }
 
-/* rank:
+/* ns_rank:
  * Apply network simplex to rank the nodes in a graph.
  * Uses ED_minlen as the internode constraint: if a->b with minlen=ml,
  * rank b - rank a >= ml.
@@ -887,12 +1181,18 @@ graphSize (graph_t * g, int* nn, int* ne)
  * The node rank values are stored in ND_rank.
  * Returns 0 if successful; returns 1 if the graph was not connected;
  * returns 2 if something seriously wrong;
+ * All working state lives in ctx, so solves using different contexts on
+ * different graphs may run concurrently.
+ * With warm set, the solve starts from the ranks already in g and from the
+ * tree left in ctx by its previous solve; see ns_rank_warm.
  */
-int rank2(graph_t * g, int balance, int maxiter, int search_size)
+static int solve(ns_context_t * ctx, graph_t * g, int balance, int maxiter,
+		 int search_size, bool warm)
 {
-    int iter = 0, feasible;
+    int iter = 0, feasible, e, f;
     char *ns = "network simplex: ";
-    edge_t *e, *f;
+    edge_t **old = NULL;
+    size_t n_old = 0;
 
 #ifdef DEBUG
     check_cycles(g);
@@ -904,17 +1204,31 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
 	    nn, ne, maxiter, balance);
 	start_timer();
     }
-    feasible = init_graph(g);
-    if (!feasible)
-	init_rank();
+    if (warm && ctx->Tree_edge.size > 0) {
+	n_old = (size_t)ctx->Tree_edge.size;
+	old = N_NEW(n_old, edge_t *);
+	memcpy(old, ctx->Tree_edge.list, n_old * sizeof(old[0]));
+	qsort(old, n_old, sizeof(old[0]), edgeptrcmpf);
+    }
+    feasible = init_graph(ctx, g);
+    if (!feasible && !(warm && repair_ranks(ctx)))
+	init_rank(ctx);
+    if (old) {
+	int err = seed_tree(ctx, old, n_old);
+	free(old);
+	if (err != 0) {
+	    freeTreeList (g);
+	    return err;
+	}
+    }
 
     if (search_size >= 0)
-	Search_size = search_size;
+	ctx->Search_size = search_size;
     else
-	Search_size = SEARCHSIZE;
+	ctx->Search_size = SEARCHSIZE;
 
     {
-	int err = feasible_tree();
+	int err = feasible_tree(ctx);
 	if (err != 0) {
 	    freeTreeList (g);
 	    return err;
@@ -925,11 +1239,14 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
 	return 0;
     }
 
-    while ((e = leave_edge())) {
+    load_arrays(ctx);
+    init_cutvalues(ctx);
+    while ((e = leave_edge(ctx)) >= 0) {
 	int err;
-	f = enter_edge(e);
-	err = update(e, f);
+	f = enter_edge(ctx, e);
+	err = update(ctx, e, f);
 	if (err != 0) {
+	    store_arrays(ctx);
 	    freeTreeList (g);
 	    return err;
 	}
@@ -946,25 +1263,92 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
     }
     switch (balance) {
     case 1:
-	TB_balance();
+	store_arrays(ctx);
+	TB_balance(ctx);
 	break;
     case 2:
-	LR_balance();
+	LR_balance(ctx);
+	store_arrays(ctx);
+	freeTreeList (ctx->G);
 	break;
     default:
-	scan_and_normalize();
-	freeTreeList (G);
+	store_arrays(ctx);
+	scan_and_normalize(ctx);
+	freeTreeList (ctx->G);
 	break;
     }
     if (Verbose) {
 	if (iter >= 100)
 	    fputc('\n', stderr);
 	fprintf(stderr, "%s%d nodes %d edges %d iter %.2f sec\n",
-		ns, N_nodes, N_edges, iter, elapsed_sec());
+		ns, ctx->N_nodes, ctx->N_edges, iter, elapsed_sec());
     }
     return 0;
 }
 
+int ns_rank(ns_context_t * ctx, graph_t * g, int balance, int maxiter,
+	    int search_size)
+{
+    return solve(ctx, g, balance, maxiter, search_size, false);
+}
+
+/* ns_rank_warm:
+ * As ns_rank, but for a graph that was ranked with ctx before and edited
+ * since. Instead of ranking from scratch, feasibility is repaired locally
+ * around the changed edges and pivoting resumes from what is left of the
+ * previous tree, so the number of pivots depends on the size of the edit.
+ */
+int ns_rank_warm(ns_context_t * ctx, graph_t * g, int balance, int maxiter,
+		 int search_size)
+{
+    return solve(ctx, g, balance, maxiter, search_size, true);
+}
+
+ns_context_t *ns_context_new(void)
+{
+    return NEW(ns_context_t);
+}
+
+void ns_context_free(ns_context_t * ctx)
+{
+    if (ctx == NULL)
+	return;
+    free(ctx->Tree_node.list);
+    free(ctx->Tree_edge.list);
+    free(ctx->node);
+    free(ctx->edge);
+    free(ctx->rank);
+    free(ctx->low);
+    free(ctx->lim);
+    free(ctx->par);
+    free(ctx->out_start);
+    free(ctx->in_start);
+    free(ctx->in_edge);
+    free(ctx->tree_out);
+    free(ctx->tree_in);
+    free(ctx->n_tree_out);
+    free(ctx->n_tree_in);
+    free(ctx->tail);
+    free(ctx->head);
+    free(ctx->minlen);
+    free(ctx->weight);
+    free(ctx->tree_index);
+    free(ctx->tree);
+    free(ctx->cut);
+    free(ctx);
+}
+
+/* rank2:
+ * As ns_rank, using a context of its own.
+ */
+int rank2(graph_t * g, int balance, int maxiter, int search_size)
+{
+    ns_context_t *ctx = ns_context_new();
+    int rv = ns_rank(ctx, g, balance, maxiter, search_size);
+    ns_context_free(ctx);
+    return rv;
+}
+
 int rank(graph_t * g, int balance, int maxiter)
 {
     char *s;
@@ -979,56 +1363,53 @@ int rank(graph_t * g, int balance, int maxiter)
 }
 
 /* set cut value of f, assuming values of edges on one side were already set */
-static void x_cutval(edge_t * f)
+static void x_cutval(ns_context_t * ctx, int f)
 {
-    node_t *v;
-    edge_t *e;
-    int i, sum, dir;
+    int v, i, sum, dir;
 
     /* set v to the node on the side of the edge already searched */
-    if (ND_par(agtail(f)) == f) {
-	v = agtail(f);
+    if (ctx->par[ctx->tail[f]] == f) {
+	v = ctx->tail[f];
 	dir = 1;
     } else {
-	v = aghead(f);
+	v = ctx->head[f];
 	dir = -1;
     }
 
     sum = 0;
-    for (i = 0; (e = ND_out(v).list[i]); i++)
-	sum += x_val(e, v, dir);
-    for (i = 0; (e = ND_in(v).list[i]); i++)
-	sum += x_val(e, v, dir);
-    ED_cutvalue(f) = sum;
+    for (i = ctx->out_start[v]; i < ctx->out_start[v + 1]; i++)
+	sum += x_val(ctx, i, v, dir);
+    for (i = ctx->in_start[v]; i < ctx->in_start[v + 1]; i++)
+	sum += x_val(ctx, ctx->in_edge[i], v, dir);
+    ctx->cut[ctx->tree_index[f]] = sum;
 }
 
-static int x_val(edge_t * e, node_t * v, int dir)
+static int x_val(ns_context_t * ctx, int e, int v, int dir)
 {
-    node_t *other;
-    int d, rv, f;
+    int other, d, rv, f;
 
-    if (agtail(e) == v)
-	other = aghead(e);
+    if (ctx->tail[e] == v)
+	other = ctx->head[e];
     else
-	other = agtail(e);
-    if (!(SEQ(ND_low(v), ND_lim(other), ND_lim(v)))) {
+	other = ctx->tail[e];
+    if (!(SEQ(ctx->low[v], ctx->lim[other], ctx->lim[v]))) {
 	f = 1;
-	rv = ED_weight(e);
+	rv = ctx->weight[e];
     } else {
 	f = 0;
-	if (TREE_EDGE(e))
-	    rv = ED_cutvalue(e);
+	if (TREE_EDGE_ID(ctx, e))
+	    rv = ctx->cut[ctx->tree_index[e]];
 	else
 	    rv = 0;
-	rv -= ED_weight(e);
+	rv -= ctx->weight[e];
     }
     if (dir > 0) {
-	if (aghead(e) == v)
+	if (ctx->head[e] == v)
 	    d = 1;
 	else
 	    d = -1;
     } else {
-	if (agtail(e) == v)
+	if (ctx->tail[e] == v)
 	    d = 1;
 	else
 	    d = -1;
@@ -1040,49 +1421,52 @@ static int x_val(edge_t * e, node_t * v, int dir)
     return rv;
 }
 
-static void dfs_cutval(node_t * v, edge_t * par)
+static void dfs_cutval(ns_context_t * ctx, int v, int par)
 {
-    int i;
-    edge_t *e;
-
-    for (i = 0; (e = ND_tree_out(v).list[i]); i++)
-	if (e != par)
-	    dfs_cutval(aghead(e), e);
-    for (i = 0; (e = ND_tree_in(v).list[i]); i++)
-	if (e != par)
-	    dfs_cutval(agtail(e), e);
-    if (par)
-	x_cutval(par);
+    int i, e;
+    const int *tree_out = ctx->tree_out + ctx->out_start[v];
+    const int *tree_in = ctx->tree_in + ctx->in_start[v];
+
+    for (i = 0; i < ctx->n_tree_out[v]; i++)
+	if ((e = tree_out[i]) != par)
+	    dfs_cutval(ctx, ctx->head[e], e);
+    for (i = 0; i < ctx->n_tree_in[v]; i++)
+	if ((e = tree_in[i]) != par)
+	    dfs_cutval(ctx, ctx->tail[e], e);
+    if (par >= 0)
+	x_cutval(ctx, par);
 }
 
 /*
 * Initializes DFS range attributes (par, low, lim) over tree nodes such that:
-* ND_par(n) - parent tree edge
-* ND_low(n) - min DFS index for nodes in sub-tree (>= 1)
-* ND_lim(n) - max DFS index for nodes in sub-tree
+* par[n] - parent tree edge
+* low[n] - min DFS index for nodes in sub-tree (>= 1)
+* lim[n] - max DFS index for nodes in sub-tree
 */
-static int dfs_range_init(node_t *v, edge_t *par, int low) {
+static int dfs_range_init(ns_context_t *ctx, int v, int par, int low) {
     int i, lim;
+    const int *tree_out = ctx->tree_out + ctx->out_start[v];
+    const int *tree_in = ctx->tree_in + ctx->in_start[v];
 
     lim = low;
-    ND_par(v) = par;
-    ND_low(v) = low;
+    ctx->par[v] = par;
+    ctx->low[v] = low;
 
-    for (i = 0; ND_tree_out(v).list[i]; i++) {
-        edge_t *e = ND_tree_out(v).list[i];
+    for (i = 0; i < ctx->n_tree_out[v]; i++) {
+        int e = tree_out[i];
         if (e != par) {
-            lim = dfs_range_init(aghead(e), e, lim);
+            lim = dfs_range_init(ctx, ctx->head[e], e, lim);
         }
     }
 
-    for (i = 0; ND_tree_in(v).list[i]; i++) {
-        edge_t *e = ND_tree_in(v).list[i];
+    for (i = 0; i < ctx->n_tree_in[v]; i++) {
+        int e = tree_in[i];
         if (e != par) {
-            lim = dfs_range_init(agtail(e), e, lim);
+            lim = dfs_range_init(ctx, ctx->tail[e], e, lim);
         }
     }
 
-    ND_lim(v) = lim;
+    ctx->lim[v] = lim;
 
     return lim + 1;
 }
@@ -1090,30 +1474,31 @@ static int dfs_range_init(node_t *v, edge_t *par, int low) {
 /*
  * Incrementally updates DFS range attributes
  */
-static int dfs_range(node_t * v, edge_t * par, int low)
+static int dfs_range(ns_context_t * ctx, int v, int par, int low)
 {
-    edge_t *e;
-    int i, lim;
+    int i, e, lim;
+    const int *tree_out = ctx->tree_out + ctx->out_start[v];
+    const int *tree_in = ctx->tree_in + ctx->in_start[v];
 
-    if (ND_par(v) == par && ND_low(v) == low) {
-	return ND_lim(v) + 1;
+    if (ctx->par[v] == par && ctx->low[v] == low) {
+	return ctx->lim[v] + 1;
     }
 
     lim = low;
-    ND_par(v) = par;
-    ND_low(v) = low;
-    for (i = 0; (e = ND_tree_out(v).list[i]); i++)
-	if (e != par)
-	    lim = dfs_range(aghead(e), e, lim);
-    for (i = 0; (e = ND_tree_in(v).list[i]); i++)
-	if (e != par)
-	    lim = dfs_range(agtail(e), e, lim);
-    ND_lim(v) = lim;
+    ctx->par[v] = par;
+    ctx->low[v] = low;
+    for (i = 0; i < ctx->n_tree_out[v]; i++)
+	if ((e = tree_out[i]) != par)
+	    lim = dfs_range(ctx, ctx->head[e], e, lim);
+    for (i = 0; i < ctx->n_tree_in[v]; i++)
+	if ((e = tree_in[i]) != par)
+	    lim = dfs_range(ctx, ctx->tail[e], e, lim);
+    ctx->lim[v] = lim;
     return lim + 1;
 }
 
 #ifdef DEBUG
-void tchk(void)
+void tchk(ns_context_t * ctx)
 {
     int i, n_cnt, e_cnt;
     node_t *n;
@@ -1121,7 +1506,7 @@ void tchk(void)
 
     n_cnt = 0;
     e_cnt = 0;
-    for (n = agfstnode(G); n; n = agnxtnode(G, n)) {
+    for (n = agfstnode(ctx->G); n; n = agnxtnode(ctx->G, n)) {
 	n_cnt++;
 	for (i = 0; (e = ND_tree_out(n).list[i]); i++) {
 	    e_cnt++;
@@ -1129,34 +1514,30 @@ void tchk(void)
 		fprintf(stderr, "not a tight tree %p", e);
 	}
     }
-    if (n_cnt != Tree_node.size || e_cnt != Tree_edge.size)
+    if (n_cnt != ctx->Tree_node.size || e_cnt != ctx->Tree_edge.size)
 	fprintf(stderr, "something missing\n");
 }
 
-void check_cutvalues(void)
+void check_cutvalues(ns_context_t * ctx)
 {
-    node_t *v;
-    edge_t *e;
     int i, save;
 
-    for (v = agfstnode(G); v; v = agnxtnode(G, v)) {
-	for (i = 0; (e = ND_tree_out(v).list[i]); i++) {
-	    save = ED_cutvalue(e);
-	    x_cutval(e);
-	    if (save != ED_cutvalue(e))
-		abort();
-	}
+    for (i = 0; i < ctx->Tree_edge.size; i++) {
+	save = ctx->cut[i];
+	x_cutval(ctx, ctx->tree[i]);
+	if (save != ctx->cut[i])
+	    abort();
     }
 }
 
-int check_ranks(void)
+int check_ranks(ns_context_t * ctx)
 {
     int cost = 0;
     node_t *n;
     edge_t *e;
 
-    for (n = agfstnode(G); n; n = agnxtnode(G, n)) {
-	for (e = agfstout(G, n); e; e = agnxtout(G, e)) {
+    for (n = agfstnode(ctx->G); n; n = agnxtnode(ctx->G, n)) {
+	for (e = agfstout(ctx->G, n); e; e = agnxtout(ctx->G, e)) {
 	    cost += (ED_weight(e)) * abs(LENGTH(e));
 	    if (ND_rank(aghead(e)) - ND_rank(agtail(e)) - ED_minlen(e) < 0)
 		abort();
@@ -1166,13 +1547,13 @@ int check_ranks(void)
     return cost;
 }
 
-void checktree(void)
+void checktree(ns_context_t * ctx)
 {
     int i, n = 0, m = 0;
     node_t *v;
     edge_t *e;
 
-    for (v = agfstnode(G); v; v = agnxtnode(G, v)) {
+    for (v = agfstnode(ctx->G); v; v = agnxtnode(ctx->G, v)) {
 	for (i = 0; (e = ND_tree_out(v).list[i]); i++)
 	    n++;
 	if (i != ND_tree_out(v).size)
@@ -1182,7 +1563,7 @@ void checktree(void)
 	if (i != ND_tree_in(v).size)
 	    abort();
     }
-    fprintf(stderr, "%d %d %d\n", Tree_edge.size, n, m);
+    fprintf(stderr, "%d %d %d\n", ctx->Tree_edge.size, n, m);
 }
 
 void check_fast_node(node_t * n)
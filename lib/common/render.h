@@ -45,6 +45,12 @@ extern "C" {
 	point offset;
     } epsf_t;
 
+    /// working state of the network simplex solver; see @ref ns_rank
+    typedef struct ns_context_s ns_context_t;
+
+    /// working storage of the spline router; see @ref routesplines_r
+    typedef struct route_context_s route_context_t;
+
 #ifdef GVDLL
 #ifdef GVC_EXPORTS
 #define RENDER_API __declspec(dllexport)
@@ -72,6 +78,7 @@ extern "C" {
     RENDER_API shape_desc *bind_shape(char *name, node_t *);
     RENDER_API void makeStraightEdge(graph_t * g, edge_t * e, int edgetype, splineInfo * info);
     RENDER_API void makeStraightEdges(graph_t* g, edge_t** edges, int e_cnt, int et, splineInfo* sinfo);
+    RENDER_API void free_curved_cycles(graph_t *g);
     RENDER_API void clip_and_install(edge_t * fe, node_t * hn,
 	pointf * ps, int pn, splineInfo * info);
     RENDER_API char* charsetToStr (int c);
@@ -119,12 +126,24 @@ extern "C" {
     RENDER_API obj_state_t* push_obj_state(GVJ_t *job);
     RENDER_API int rank(graph_t * g, int balance, int maxiter);
     RENDER_API int rank2(graph_t * g, int balance, int maxiter, int search_size);
+    RENDER_API ns_context_t *ns_context_new(void);
+    RENDER_API void ns_context_free(ns_context_t *ctx);
+    RENDER_API int ns_rank(ns_context_t *ctx, graph_t *g, int balance,
+                           int maxiter, int search_size);
+    RENDER_API int ns_rank_warm(ns_context_t *ctx, graph_t *g, int balance,
+                                int maxiter, int search_size);
     RENDER_API port resolvePort(node_t*  n, node_t* other, port* oldport);
     RENDER_API void resolvePorts (edge_t* e);
     RENDER_API void round_corners(GVJ_t * job, pointf * AF, int sides, int style, int filled);
     RENDER_API int routesplinesinit(void);
     RENDER_API pointf *routesplines(path *, int *);
     RENDER_API void routesplinesterm(void);
+    RENDER_API route_context_t *route_context_new(void);
+    RENDER_API void route_context_free(route_context_t *ctx);
+    RENDER_API pointf *routesplines_r(route_context_t *ctx, path *pp,
+                                      int *npoints);
+    RENDER_API pointf *routepolylines_r(route_context_t *ctx, path *pp,
+                                        int *npoints);
     RENDER_API pointf* simpleSplineRoute (pointf, pointf, Ppoly_t, int*, int);
     RENDER_API pointf *routepolylines(path* pp, int* npoints);
     RENDER_API double selfRightSpace(edge_t *e);
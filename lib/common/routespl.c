@@ -18,14 +18,20 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
-static int nedges, nboxes; /* total no. of edges and boxes used in routing */
+/* data used across multiple edges */
+struct route_context_s {
+    Pscratch_t *scratch;      /* working storage of the path planner */
+    Ppoint_t *polypoints;     /* vertices of polygon defined by boxes */
+    int polypointn;           /* size of polypoints[] */
+    Pedge_t *edges;           /* polygon edges passed to Proutespline */
+    int edgen;                /* size of edges[] */
+    int nedges, nboxes;       /* no. of edges and boxes routed */
+};
 
 static int routeinit;
-/* static data used across multiple edges */
-static Ppoint_t *polypoints;  /* vertices of polygon defined by boxes */
-static int polypointn;        /* size of polypoints[] */
-static Pedge_t *edges;        /* polygon edges passed to Proutespline */
-static int edgen;             /* size of edges[] */
+/* context of routesplines and routepolylines; its counters are the totals
+ * reported by routesplinesterm */
+static route_context_t shared;
 
 static int checkpath(int, boxf*, path*);
 static void printpath(path * pp);
@@ -229,17 +235,17 @@ simpleSplineRoute (pointf tp, pointf hp, Ppoly_t poly, int* n_spl_pts,
     if (polyline)
 	make_polyline (pl, &spl);
     else {
-	if (poly.pn > edgen) {
-	    edges = ALLOC(poly.pn, edges, Pedge_t);
-	    edgen = poly.pn;
+	if (poly.pn > shared.edgen) {
+	    shared.edges = ALLOC(poly.pn, shared.edges, Pedge_t);
+	    shared.edgen = poly.pn;
 	}
 	for (i = 0; i < poly.pn; i++) {
-	    edges[i].a = poly.ps[i];
-	    edges[i].b = poly.ps[(i + 1) % poly.pn];
+	    shared.edges[i].a = poly.ps[i];
+	    shared.edges[i].b = poly.ps[(i + 1) % poly.pn];
 	}
 	    evs[0].x = evs[0].y = 0;
 	    evs[1].x = evs[1].y = 0;
-	if (Proutespline(edges, poly.pn, pl, evs, &spl) < 0)
+	if (Proutespline(shared.edges, poly.pn, pl, evs, &spl) < 0)
             return NULL;
     }
 
@@ -272,8 +278,8 @@ routesplinesinit()
 	Show_cnt = 0;
     }
 #endif
-    nedges = 0;
-    nboxes = 0;
+    shared.nedges = 0;
+    shared.nboxes = 0;
     if (Verbose)
 	start_timer();
     return 0;
@@ -285,7 +291,24 @@ void routesplinesterm()
     if (Verbose)
 	fprintf(stderr,
 		"routesplines: %d edges, %d boxes %.2f sec\n",
-		nedges, nboxes, elapsed_sec());
+		shared.nedges, shared.nboxes, elapsed_sec());
+}
+
+route_context_t *route_context_new(void)
+{
+    return gv_alloc(sizeof(route_context_t));
+}
+
+void route_context_free(route_context_t *ctx)
+{
+    if (ctx == NULL)
+	return;
+    shared.nedges += ctx->nedges;
+    shared.nboxes += ctx->nboxes;
+    Pscratch_free(ctx->scratch);
+    free(ctx->polypoints);
+    free(ctx->edges);
+    free(ctx);
 }
 
 static void
@@ -350,7 +373,8 @@ limitBoxes (boxf* boxes, int boxn, const pointf *pps, int pn, int delta)
  *
  * If a catastrophic error, return NULL and npoints is 0.
  */
-static pointf *_routesplines(path * pp, int *npoints, int polyline)
+static pointf *_routesplines(route_context_t *ctx, path *pp, int *npoints,
+                             int polyline)
 {
     Ppoly_t poly;
     Ppolyline_t pl, spl;
@@ -367,8 +391,8 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
     bool unbounded;
 
     *npoints = 0;
-    nedges++;
-    nboxes += pp->nbox;
+    ctx->nedges++;
+    ctx->nboxes += pp->nbox;
 
     for (realedge = pp->data;
 	 realedge && ED_edge_type(realedge) != NORMAL;
@@ -393,10 +417,11 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
     }
 #endif
 
-    if (boxn * 8 > polypointn) {
-	polypoints = ALLOC(boxn * 8, polypoints, Ppoint_t);
-	polypointn = boxn * 8;
+    if (boxn * 8 > ctx->polypointn) {
+	ctx->polypoints = ALLOC(boxn * 8, ctx->polypoints, Ppoint_t);
+	ctx->polypointn = boxn * 8;
     }
+    Ppoint_t *polypoints = ctx->polypoints;
 
     if (boxn > 1 && boxes[0].LL.y > boxes[1].LL.y) {
         flip = true;
@@ -505,7 +530,7 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
     poly.ps = polypoints, poly.pn = pi;
     eps[0].x = pp->start.p.x, eps[0].y = pp->start.p.y;
     eps[1].x = pp->end.p.x, eps[1].y = pp->end.p.y;
-    if (Pshortestpath(&poly, eps, &pl) < 0) {
+    if (Pshortestpath_r(ctx->scratch, &poly, eps, &pl) < 0) {
 	agerr(AGERR, "in routesplines, Pshortestpath failed\n");
 	return NULL;
     }
@@ -517,16 +542,16 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 #endif
 
     if (polyline) {
-	make_polyline (pl, &spl);
+	make_polyline_r(ctx->scratch, pl, &spl);
     }
     else {
-	if (poly.pn > edgen) {
-	    edges = ALLOC(poly.pn, edges, Pedge_t);
-	    edgen = poly.pn;
+	if (poly.pn > ctx->edgen) {
+	    ctx->edges = ALLOC(poly.pn, ctx->edges, Pedge_t);
+	    ctx->edgen = poly.pn;
 	}
 	for (edgei = 0; edgei < poly.pn; edgei++) {
-	    edges[edgei].a = polypoints[edgei];
-	    edges[edgei].b = polypoints[(edgei + 1) % poly.pn];
+	    ctx->edges[edgei].a = polypoints[edgei];
+	    ctx->edges[edgei].b = polypoints[(edgei + 1) % poly.pn];
 	}
 	if (pp->start.constrained) {
 	    evs[0].x = cos(pp->start.theta);
@@ -539,7 +564,7 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	} else
 	    evs[1].x = evs[1].y = 0;
 
-	if (Proutespline(edges, poly.pn, pl, evs, &spl) < 0) {
+	if (Proutespline_r(ctx->scratch, ctx->edges, poly.pn, pl, evs, &spl) < 0) {
 	    agerr(AGERR, "in routesplines, Proutespline failed\n");
 	    return NULL;
 	}
@@ -594,7 +619,7 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	 */
 	Ppolyline_t polyspl;
 	agerr(AGWARN, "Unable to reclaim box space in spline routing for edge \"%s\" -> \"%s\". Something is probably seriously wrong.\n", agnameof(agtail(realedge)), agnameof(aghead(realedge)));
-	make_polyline (pl, &polyspl);
+	make_polyline_r(ctx->scratch, pl, &polyspl);
 	limitBoxes (boxes, boxn, polyspl.ps, polyspl.pn, INIT_DELTA);
     }
 
@@ -614,12 +639,30 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 
 pointf *routesplines(path * pp, int *npoints)
 {
-    return _routesplines (pp, npoints, 0);
+    return routesplines_r(&shared, pp, npoints);
 }
 
 pointf *routepolylines(path * pp, int *npoints)
 {
-    return _routesplines (pp, npoints, 1);
+    return routepolylines_r(&shared, pp, npoints);
+}
+
+/* routesplines_r, routepolylines_r:
+ * As routesplines and routepolylines, but keeping all working storage in
+ * ctx. Threads using distinct contexts may route concurrently.
+ */
+pointf *routesplines_r(route_context_t *ctx, path *pp, int *npoints)
+{
+    if (ctx->scratch == NULL)
+	ctx->scratch = Pscratch_new();
+    return _routesplines(ctx, pp, npoints, 0);
+}
+
+pointf *routepolylines_r(route_context_t *ctx, path *pp, int *npoints)
+{
+    if (ctx->scratch == NULL)
+	ctx->scratch = Pscratch_new();
+    return _routesplines(ctx, pp, npoints, 1);
 }
 
 static int overlap(int i0, int i1, int j0, int j1)
@@ -804,245 +847,137 @@ static pointf get_centroid(Agraph_t *g)
     return sum;
 }
 
-//generic vector structure
-typedef struct _tag_vec
-{
-    void** _mem;
-    size_t _elems;
-    size_t _capelems;
-} vec;
-
-static vec* vec_new(void)
-{
-    vec* pvec = malloc(sizeof(vec));
-    pvec->_capelems = 10;
-    pvec->_elems = 0;
-    pvec->_mem = malloc(pvec->_capelems * sizeof(void*));
-    return pvec;
-}
-
-static size_t vec_length(const vec* pvec)
-{
-    return pvec->_elems;
-}
-
-static void* vec_get(vec* pvec, size_t index)
-{
-    assert(index < pvec->_elems);
-    return pvec->_mem[index];
-}
-
-static void vec_delete(vec* pvec)
-{
-    free(pvec->_mem);
-    free(pvec);
-}
-
-// cycles is assumed to be a vec of vec of nodes.
-static void cycles_delete(vec* cycles) {
-  for (size_t i = 0; i < vec_length(cycles); ++i) {
-    vec_delete(vec_get(cycles, i));
-  }
-  vec_delete(cycles);
-}
-
-static void vec_push_back(vec* pvec, void* data)
-{
-    if (pvec->_elems == pvec->_capelems) {
-		pvec->_capelems += 10;
-		pvec->_mem = realloc(pvec->_mem, pvec->_capelems * sizeof(void*));
-	}
-    pvec->_mem[pvec->_elems++] = data;  
-}
-
-static void* vec_pop(vec* pvec)
-{
-	if (pvec->_elems > 0)
-		return pvec->_mem[--pvec->_elems];
-	return NULL;
-}
-
-static bool vec_contains(vec* pvec, void* item)
-{
-	for (size_t i=0; i < pvec->_elems; ++i) {
-		if (pvec->_mem[i] == item)
-			return true;
-	}
-
-	return false;
-}
-
-static vec* vec_copy(vec* pvec)
-{
-    vec* nvec = malloc(sizeof(vec));
-    nvec->_capelems = pvec->_capelems;
-    nvec->_elems = pvec->_elems;
-    nvec->_mem = malloc(pvec->_capelems * sizeof(void*));
-	memcpy(nvec->_mem, pvec->_mem, pvec->_elems * sizeof(void*));
-    return nvec;
-}
-//end generic vector structure
-
-static bool cycle_contains_edge(vec* cycle, edge_t* edge)
-{
-	node_t* start = agtail(edge);
-	node_t* end = aghead(edge);
-	node_t* c_start;
-	node_t* c_end;
-
-	size_t cycle_len = vec_length(cycle);
-
-	for (size_t i=0; i < cycle_len; ++i) {
-		if (i == 0) {
-			c_start = vec_get(cycle, cycle_len-1);
-		} else {
-			c_start = vec_get(cycle, i-1);
-		}
-	
-		c_end = vec_get(cycle, i);
-
-		if (c_start == start && c_end == end)
-			return true;
-	}
-
-
-	return false;
-}
-
-static bool is_cycle_unique(vec* cycles, vec* cycle)
+/// tag of the record holding a \ref cycles_t on a root graph
+#define CYCLES_TAG "cycles_t"
+
+/// number of edges a search for a cycle looks at before giving up
+enum { CYCLE_SEARCH_LIMIT = 10000 };
+
+/// the out-edges of a graph in compact form, for finding cycles through them
+///
+/// This is built by the first curved edge of a layout and kept on the root
+/// graph, so that each further edge only pays for its own search. Nodes are
+/// indexed by their sequence number.
+typedef struct {
+    Agrec_t hdr;
+    int n_nodes;      ///< `agnnodes` of the graph when this was built
+    int n_edges;      ///< `agnedges` of the graph when this was built
+    size_t size;      ///< one more than the largest node index
+    node_t **nodes;   ///< node of each index, NULL for unused ones
+    size_t *first;    ///< out-neighbors of `i` are `heads[first[i]..first[i+1]]`
+    size_t *heads;    ///< indices of edge heads
+    size_t *parent;   ///< index each node was reached from by the last search
+    unsigned *seen;   ///< last search that reached each node
+    unsigned search;  ///< number of searches so far
+    size_t *queue;
+} cycles_t;
+
+void free_curved_cycles(graph_t *g)
 {
-	size_t cycle_len = vec_length(cycle);
-	size_t n_cycles = vec_length(cycles);
-	size_t c; //cycles counter
-	size_t i; //node counter
-
-	vec* cur_cycle;
-	size_t cur_cycle_len;
-	void* cur_cycle_item;
-	bool all_items_match;
-
-	for (c=0; c < n_cycles; ++c) {
-		cur_cycle = vec_get(cycles, c);
-		cur_cycle_len = vec_length(cur_cycle);
-
-		//if all the items match in equal length cycles then we're not unique
-		if (cur_cycle_len == cycle_len) {
-			all_items_match = true;
-			for (i=0; i < cur_cycle_len; ++i) {
-				cur_cycle_item = vec_get(cur_cycle, i);
-				if (!vec_contains(cycle, cur_cycle_item)) {
-					all_items_match = false;
-					break;
-				}
-			}
-			if (all_items_match)
-				return false;
-		}
-	}
-
-	return true;
-}
-
-static void dfs(graph_t *g, node_t* search, vec* visited, node_t* end, vec* cycles)
-{
-	edge_t* e;
-	node_t* n;
-
-	if (vec_contains(visited, search)) {
-		if (search == end) {
-			if (is_cycle_unique(cycles, visited)) {
-				vec* cycle = vec_copy(visited);
-				vec_push_back(cycles, cycle);
-			}
-		}
-	} else {
-		vec_push_back(visited, search);
-		for (e = agfstout(g, search); e; e = agnxtout(g, e)) {
-			n = aghead(e);
-			dfs(g, n, visited, end, cycles);
-		}
-		vec_pop(visited);
-	}
+    cycles_t *c = (cycles_t *)aggetrec(g, CYCLES_TAG, 0);
+    if (c == NULL)
+	return;
+    free(c->nodes);
+    free(c->first);
+    free(c->heads);
+    free(c->parent);
+    free(c->seen);
+    free(c->queue);
+    agdelrec(g, CYCLES_TAG);
 }
 
-// Returns a vec of vec of nodes (aka a vector of cycles), which must be freed using cycles_delete.
-static vec* find_all_cycles(graph_t *g)
+static cycles_t *get_cycles(graph_t *root)
 {
-    node_t *n;
-
-    vec* alloced_cycles = vec_new(); //vector of vectors of nodes -- AKA cycles to delete
-    vec* cycles = vec_new(); //vector of vectors of nodes AKA a vector of cycles
-    vec* cycle;
-
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-		cycle = vec_new();
-		vec_push_back(alloced_cycles, cycle); //keep track of all items we allocate to clean up at the end of this function
-		
-		dfs(g, n, cycle, n, cycles);
-	}
-	
-	cycles_delete(alloced_cycles); //cycles contains copied vecs
-    return cycles;
-}
+    cycles_t *c = (cycles_t *)aggetrec(root, CYCLES_TAG, 0);
+    if (c != NULL && c->n_nodes == agnnodes(root)
+	    && c->n_edges == agnedges(root))
+	return c;
+    free_curved_cycles(root);
+
+    c = agbindrec(root, CYCLES_TAG, sizeof(cycles_t), false);
+    c->n_nodes = agnnodes(root);
+    c->n_edges = agnedges(root);
+    for (node_t *n = agfstnode(root); n; n = agnxtnode(root, n))
+	c->size = MAX(c->size, (size_t)AGSEQ(n) + 1);
+
+    c->nodes = gv_calloc(c->size, sizeof(node_t *));
+    c->first = gv_calloc(c->size + 1, sizeof(size_t));
+    c->heads = gv_calloc((size_t)c->n_edges, sizeof(size_t));
+    for (node_t *n = agfstnode(root); n; n = agnxtnode(root, n)) {
+	c->nodes[AGSEQ(n)] = n;
+	for (edge_t *e = agfstout(root, n); e; e = agnxtout(root, e))
+	    c->first[AGSEQ(n) + 1]++;
+    }
+    for (size_t i = 0; i < c->size; ++i)
+	c->first[i + 1] += c->first[i];
+    for (node_t *n = agfstnode(root); n; n = agnxtnode(root, n)) {
+	size_t k = c->first[AGSEQ(n)];
+	for (edge_t *e = agfstout(root, n); e; e = agnxtout(root, e))
+	    c->heads[k++] = AGSEQ(aghead(e));
+    }
 
-static vec* find_shortest_cycle_with_edge(vec* cycles, edge_t* edge, size_t min_size)
-{
-	size_t c; //cycle counter
-	size_t cycles_len = vec_length(cycles);
-	vec* cycle;
-	size_t cycle_len; 
-	vec* shortest = 0;
-
-	for (c=0; c < cycles_len; ++c) {
-		cycle = vec_get(cycles, c);
-		cycle_len = vec_length(cycle);
-
-		if (cycle_len < min_size)
-			continue;
-
-		if (!shortest || vec_length(shortest) > cycle_len) {
-			if (cycle_contains_edge(cycle, edge)) {
-				shortest = cycle;
-			}
-		}
-	}
-	return shortest;
+    c->parent = gv_calloc(c->size, sizeof(size_t));
+    c->seen = gv_calloc(c->size, sizeof(unsigned));
+    c->queue = gv_calloc(c->size, sizeof(size_t));
+    return c;
 }
 
+/* get_cycle_centroid:
+ * Return the center of the shortest cycle of at least 3 nodes containing
+ * edge, or of the graph if there is none. Cycles of 2 nodes are not
+ * considered as edge bundles bend by themselves.
+ *
+ * The cycle is found by a breadth-first search for a path from the head of
+ * edge back to its tail. This gives up after CYCLE_SEARCH_LIMIT edges, so
+ * the cost of a curved edge does not grow with the size of the graph.
+ */
 static pointf get_cycle_centroid(graph_t *g, edge_t* edge)
 {
-	vec* cycles = find_all_cycles(g);
+    cycles_t *c = get_cycles(agroot(g));
+    size_t tail = AGSEQ(agtail(edge));
+    size_t head = AGSEQ(aghead(edge));
 
-	//find the center of the shortest cycle containing this edge
-	//cycles of length 2 do their own thing, we want 3 or
-	vec* cycle = find_shortest_cycle_with_edge(cycles, edge, 3);
-	size_t cycle_len;
-	size_t cnt = 0;
-    pointf sum = {0.0, 0.0};
-	size_t idx; //edge index
-	node_t *n;
+    if (tail == head || tail >= c->size || head >= c->size)
+	return get_centroid(g);
 
-	if (cycle == NULL) {
-		if (cycles != NULL)
-			cycles_delete(cycles);
+    if (++c->search == 0) {
+	memset(c->seen, 0, c->size * sizeof(unsigned));
+	c->search = 1;
+    }
+    c->seen[head] = c->search;
+    c->queue[0] = head;
+    size_t n_queue = 1;
+    size_t scanned = 0;
+
+    for (size_t i = 0; i < n_queue; ++i) {
+	size_t v = c->queue[i];
+	for (size_t j = c->first[v]; j < c->first[v + 1]; ++j) {
+	    if (++scanned > CYCLE_SEARCH_LIMIT)
 		return get_centroid(g);
+	    size_t w = c->heads[j];
+	    if (c->seen[w] == c->search)
+		continue;
+	    if (w == tail) {
+		if (v == head)
+		    continue;
+		pointf sum = ND_coord(c->nodes[tail]);
+		size_t cnt = 1;
+		for (size_t u = v; ; u = c->parent[u]) {
+		    sum = add_pointf(sum, ND_coord(c->nodes[u]));
+		    cnt++;
+		    if (u == head)
+			break;
+		}
+		sum.x /= cnt;
+		sum.y /= cnt;
+		return sum;
+	    }
+	    c->seen[w] = c->search;
+	    c->parent[w] = v;
+	    c->queue[n_queue++] = w;
 	}
-
-	cycle_len = vec_length(cycle);
-
-	for (idx=0; idx < cycle_len; ++idx) {
-		n = vec_get(cycle, idx);
-		sum.x += ND_coord(n).x;
-        sum.y += ND_coord(n).y;
-        cnt++;
-	}
-
-	if (cycles != NULL)
-		cycles_delete(cycles);
-
-	sum.x /= cnt;
-    sum.y /= cnt;
-    return sum;
+    }
+    return get_centroid(g);
 }
 
 static void bend(pointf spl[4], pointf centroid)
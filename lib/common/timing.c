@@ -13,6 +13,7 @@
 #include	<sys/types.h>
 #include	<sys/times.h>
 #include	<sys/param.h>
+#include	<time.h>
 
 
 
@@ -26,6 +27,7 @@ typedef struct tms mytime_t;
 #else
 
 #include	<time.h>
+#include	<windows.h>
 
 typedef clock_t mytime_t;
 #define GET_TIME(S) S = clock()
@@ -52,3 +54,22 @@ double elapsed_sec(void)
     rv = DIFF_IN_SECS(S, T);
     return rv;
 }
+
+/* wall_sec:
+ * Return the wall clock time in seconds since an arbitrary origin. Unlike
+ * elapsed_sec, this does not depend on a shared start time, so it may be
+ * called from several threads. Only differences of its values are meaningful.
+ */
+double wall_sec(void)
+{
+#ifndef _WIN32
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#endif
+}
@@ -306,6 +306,8 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 	graph_t **clust;	/* clusters are in clust[1..n_cluster] !!! */
 	graph_t *dotroot;
 	node_t *nlist;
+	struct arena_s *vnodes;	/* storage of virtual nodes, kept on the root */
+	struct arena_s *auxarena;	/* storage of auxiliary nodes and edges, kept on the root */
 	rank_t *rank;
 	graph_t *parent;        /* containing cluster (not parent subgraph) */
 	int level;		/* cluster nesting level (not node level!) */
@@ -405,18 +407,62 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 #define GD_spring(g) (((Agraphinfo_t*)AGDATA(g))->spring)
 #define GD_sum_t(g) (((Agraphinfo_t*)AGDATA(g))->sum_t)
 #define GD_t(g) (((Agraphinfo_t*)AGDATA(g))->t)
+#define GD_vnodes(g) (((Agraphinfo_t*)AGDATA(g))->vnodes)
+#define GD_auxarena(g) (((Agraphinfo_t*)AGDATA(g))->auxarena)
 
     typedef struct Agnodeinfo_t {
 	Agrec_t hdr;
+
+	/* Fields read in the inner loops of the layout engines come first, so
+	 * that a node's hot data shares as few cache lines as possible. They
+	 * are ordered roughly by how often dot and neato touch them.
+	 */
+#ifndef NEATO_ONLY
+	/* fast graph */
+	char node_type;
+	char onstack;
+	char ranktype;
+	char weight_class;
+	int rank;
+	int order;	/* initially, order = 1 for ordered edges */
+	double mval;
+	size_t mark;
+	elist in;
+	elist out;
+	elist flat_out;
+	elist flat_in;
+	graph_t *clust;
+	node_t *next;
+	node_t *prev;
+#endif
+	pointf coord;
+	double ht;
+	double lw;
+	double rw;
+#ifndef DOT_ONLY
+	unsigned char pinned;
+	int id;
+	int heapindex;
+	int hops;
+	double *pos;
+	double dist;
+#endif
+#ifndef NEATO_ONLY
+	/* for network-simplex */
+	int low;
+	int lim;
+	edge_t *par;
+	elist tree_in;
+	elist tree_out;
+	int priority;
+#endif
+
+	/* colder data, mostly set up before and used after layout */
 	shape_desc *shape;
 	void *shape_info;
-	pointf coord;
 	double width;   /* inches */
 	double height;  /* inches */
 	boxf bb;
-	double ht;
-	double lw;
-	double rw;
 	double outline_width;  /* width in points with penwidth taken into account */
 	double outline_height; /* height in points with penwidth taken into account */
 	textlabel_t *label;
@@ -426,34 +472,12 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 	unsigned char gui_state; /* Node state for GUI ops */
 	bool clustnode;
 
-#ifndef DOT_ONLY
-	unsigned char pinned;
-	int id;
-	int heapindex;
-	int hops;
-	double *pos;
-	double dist;
-#endif
 #ifndef NEATO_ONLY
 	unsigned char showboxes;
 	bool  has_port;
 	node_t* rep;
 	node_t *set;
-
-	/* fast graph */
-	char node_type;
-	size_t mark;
-	char onstack;
-	char ranktype;
-	char weight_class;
-	node_t *next;
-	node_t *prev;
-	elist in;
-	elist out;
-	elist flat_out;
-	elist flat_in;
 	elist other;
-	graph_t *clust;
 
 	/* for union-find and collapsing nodes */
 	int UF_size;
@@ -462,20 +486,9 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 	node_t *outleaf;
 
 	/* for placing nodes */
-	int rank;
-	int order;	/* initially, order = 1 for ordered edges */
-	double mval;
 	elist save_in;
 	elist save_out;
 
-	/* for network-simplex */
-	elist tree_in;
-	elist tree_out;
-	edge_t *par;
-	int low;
-	int lim;
-	int priority;
-
 	double pad[1];
 #endif
 
@@ -542,36 +555,45 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 
     typedef struct Agedgeinfo_t {
 	Agrec_t hdr;
-	splines *spl;
+
+	/* fields read in the inner loops of the layout engines first, as in
+	 * Agnodeinfo_t
+	 */
+	char edge_type;
+	char adjacent;          /* true for flat edge with adjacent nodes */
+#ifndef NEATO_ONLY
+	bool conc_opp_flag;
+	short xpenalty;
+	short count;
+	unsigned short minlen;
+	int weight;
+	int cutvalue;
+	int tree_index;
+	edge_t *to_virt;
+#endif
+	edge_t *to_orig;	/* for dot's shapes.c    */
+#ifndef DOT_ONLY
+	double factor;
+	double dist;
+#endif
 	port tail_port;
 	port head_port;
+
+	/* colder data, mostly used after layout */
+	splines *spl;
 	textlabel_t *label;
 	textlabel_t *head_label;
 	textlabel_t *tail_label;
 	textlabel_t *xlabel;
-	char edge_type;
 	char compound;
-	char adjacent;          /* true for flat edge with adjacent nodes */
 	char label_ontop;
 	unsigned char gui_state; /* Edge state for GUI ops */
-	edge_t *to_orig;	/* for dot's shapes.c    */
+#ifndef NEATO_ONLY
+	unsigned char showboxes;
+#endif
 	void *alg;
-
 #ifndef DOT_ONLY
-	double factor;
-	double dist;
 	Ppolyline_t path;
-#endif
-#ifndef NEATO_ONLY
-	unsigned char showboxes;
-	bool conc_opp_flag;
-	short xpenalty;
-	int weight;
-	int cutvalue;
-	int tree_index;
-	short count;
-	unsigned short minlen;
-	edge_t *to_virt;
 #endif
     } Agedgeinfo_t;
 
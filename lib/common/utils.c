@@ -65,15 +65,73 @@ node_t *dequeue(nodequeue * q)
     return n;
 }
 
+/* Tags of the values late_int, late_double and late_bool keep with
+ * agxsetparsed, so an attribute string of an object is only parsed once.
+ * Strings that are not numbers are remembered too.
+ */
+enum { PARSED_INT = 1, PARSED_NOT_INT, PARSED_DOUBLE, PARSED_NOT_DOUBLE,
+       PARSED_BOOL };
+
+unsigned long HITS, MISSES;
+#include <stdio.h>
+__attribute__((destructor)) static void rep(void){fprintf(stderr,"hits %lu misses %lu\n",HITS,MISSES);}
+static bool parse_int(void *obj, attrsym_t *attr, long *value) {
+    double cached;
+    switch (agxgetparsed(obj, attr, &cached)) {
+    case PARSED_INT:
+        HITS++;
+        *value = (long)cached;
+        return true;
+    case PARSED_NOT_INT:
+        return false;
+    default:
+        break;
+    }
+    MISSES++;
+    char *p = ag_xget(obj, attr);
+    if (p && p[0] != '\0') {
+        char *endp;
+        long rv = strtol(p, &endp, 10);
+        if (p != endp && rv <= INT_MAX) {
+            agxsetparsed(obj, attr, PARSED_INT, (double)rv);
+            *value = rv;
+            return true;
+        }
+    }
+    agxsetparsed(obj, attr, PARSED_NOT_INT, 0);
+    return false;
+}
+
+static bool parse_double(void *obj, attrsym_t *attr, double *value) {
+    switch (agxgetparsed(obj, attr, value)) {
+    case PARSED_DOUBLE:
+        HITS++;
+        return true;
+    case PARSED_NOT_DOUBLE:
+        return false;
+    default:
+        break;
+    }
+    MISSES++;
+    char *p = ag_xget(obj, attr);
+    if (p && p[0] != '\0') {
+        char *endp;
+        double rv = strtod(p, &endp);
+        if (p != endp) {
+            agxsetparsed(obj, attr, PARSED_DOUBLE, rv);
+            *value = rv;
+            return true;
+        }
+    }
+    agxsetparsed(obj, attr, PARSED_NOT_DOUBLE, 0);
+    return false;
+}
+
 int late_int(void *obj, attrsym_t *attr, int defaultValue, int minimum) {
     if (attr == NULL)
         return defaultValue;
-    char *p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-        return defaultValue;
-    char *endp;
-    long rv = strtol(p, &endp, 10);
-    if (p == endp || rv > INT_MAX)
+    long rv;
+    if (!parse_int(obj, attr, &rv))
         return defaultValue; /* invalid int format */
     if (rv < minimum)
         return minimum;
@@ -84,12 +142,8 @@ double late_double(void *obj, attrsym_t *attr, double defaultValue,
                    double minimum) {
     if (!attr || !obj)
         return defaultValue;
-    char *p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-        return defaultValue;
-    char *endp;
-    double rv = strtod(p, &endp);
-    if (p == endp)
+    double rv;
+    if (!parse_double(obj, attr, &rv))
         return defaultValue; /* invalid double format */
     if (rv < minimum)
         return minimum;
@@ -128,7 +182,12 @@ bool late_bool(void *obj, attrsym_t *attr, bool defaultValue) {
     if (attr == NULL)
         return defaultValue;
 
-    return mapbool(agxget(obj, attr));
+    double cached;
+    if (agxgetparsed(obj, attr, &cached) == PARSED_BOOL)
+        return cached != 0;
+    bool rv = mapbool(agxget(obj, attr));
+    agxsetparsed(obj, attr, PARSED_BOOL, rv);
+    return rv;
 }
 
 /* union-find */
@@ -135,6 +135,7 @@ UTILS_API double drand48(void);
 /* from timing.c */
 UTILS_API void start_timer(void);
 UTILS_API double elapsed_sec(void);
+UTILS_API double wall_sec(void);
 
 /* from psusershape.c */
 UTILS_API void cat_libfile(GVJ_t *job, const char **arglib,
@@ -10,11 +10,16 @@
 
 
 /*
- * Break cycles in a directed graph by depth-first search.
+ * Break cycles in a directed graph, either by depth-first search or,
+ * with cyclebreak=els, by the greedy heuristic of Eades, Lin and Smyth.
  */
 
+#include <cgraph/alloc.h>
+#include <cgraph/list.h>
 #include <dotgen/dot.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 void reverse_edge(edge_t * e)
 {
@@ -27,42 +32,253 @@ void reverse_edge(edge_t * e)
 	virtual_edge(aghead(e), agtail(e), e);
 }
 
-static void 
-dfs(node_t * n)
-{
+/// a node being visited by \ref dfs and the next of its out edges to look at
+typedef struct {
+    node_t *n;
     int i;
-    edge_t *e;
-    node_t *w;
+} frame_t;
 
+DEFINE_LIST(frames, frame_t)
+
+/* dfs:
+ * Reverse the edges leading back to a node on the search path. The search
+ * keeps its own stack, as paths may be as long as the graph is large.
+ */
+static void 
+dfs(frames_t *stack, node_t * n)
+{
     if (ND_mark(n))
 	return;
     ND_mark(n) = TRUE;
     ND_onstack(n) = true;
-    for (i = 0; (e = ND_out(n).list[i]); i++) {
-	w = aghead(e);
+    frames_push(stack, (frame_t){n, 0});
+
+    while (!frames_is_empty(stack)) {
+	frame_t *top = frames_at(stack, frames_size(stack) - 1);
+	edge_t *e = ND_out(top->n).list[top->i];
+	if (e == NULL) {
+	    ND_onstack(top->n) = false;
+	    (void)frames_pop(stack);
+	    continue;
+	}
+	node_t *w = aghead(e);
 	if (ND_onstack(w)) {
+	    /* e is replaced by another out edge of top->n, looked at next */
 	    reverse_edge(e);
-	    i--;
+	    continue;
+	}
+	top->i++;
+	if (!ND_mark(w)) {
+	    ND_mark(w) = TRUE;
+	    ND_onstack(w) = true;
+	    frames_push(stack, (frame_t){w, 0});
+	}
+    }
+}
+
+/// candidate of \ref els for the next node, valid while `delta` is current
+typedef struct {
+    int64_t delta;
+    int id;
+} cand_t;
+
+DEFINE_LIST(cands, cand_t)
+DEFINE_LIST(ids, int)
+DEFINE_LIST(edges, edge_t *)
+
+/// should `a` be taken before `b`?
+static bool cand_before(cand_t a, cand_t b)
+{
+    return a.delta > b.delta || (a.delta == b.delta && a.id < b.id);
+}
+
+static void heap_push(cands_t *heap, cand_t c)
+{
+    cands_push(heap, c);
+    for (size_t i = cands_size(heap) - 1; i > 0; ) {
+	size_t parent = (i - 1) / 2;
+	if (!cand_before(cands_get(heap, i), cands_get(heap, parent)))
+	    break;
+	cand_t t = cands_get(heap, i);
+	cands_set(heap, i, cands_get(heap, parent));
+	cands_set(heap, parent, t);
+	i = parent;
+    }
+}
+
+static cand_t heap_pop(cands_t *heap)
+{
+    cand_t top = cands_get(heap, 0);
+    cand_t last = cands_pop(heap);
+    size_t n = cands_size(heap);
+    if (n == 0)
+	return top;
+    cands_set(heap, 0, last);
+    for (size_t i = 0; ; ) {
+	size_t best = i;
+	for (size_t c = 2 * i + 1; c <= 2 * i + 2 && c < n; c++)
+	    if (cand_before(cands_get(heap, c), cands_get(heap, best)))
+		best = c;
+	if (best == i)
+	    break;
+	cand_t t = cands_get(heap, i);
+	cands_set(heap, i, cands_get(heap, best));
+	cands_set(heap, best, t);
+	i = best;
+    }
+    return top;
+}
+
+/// working state of \ref els, indexed by node ids kept in `ND_low`
+typedef struct {
+    node_t **node;
+    int *indeg, *outdeg;  ///< number of edges from and to remaining nodes
+    int64_t *delta;       ///< weight of out edges less that of in edges
+    int *pos;             ///< place in the order, -1 while remaining
+    int lo, hi;           ///< next free places at the front and the back
+    ids_t sources, sinks;
+    cands_t heap;
+} els_t;
+
+/* els_place:
+ * Put node v at the given place of the order and update the degrees of
+ * its remaining neighbors.
+ */
+static void els_place(els_t *st, int v, int pos)
+{
+    edge_t *e;
+    int i;
+
+    st->pos[v] = pos;
+    for (i = 0; (e = ND_out(st->node[v]).list[i]); i++) {
+	int w = ND_low(aghead(e));
+	if (st->pos[w] >= 0)
+	    continue;
+	st->delta[w] += ED_weight(e);
+	if (--st->indeg[w] == 0)
+	    ids_push(&st->sources, w);
+	heap_push(&st->heap, (cand_t){st->delta[w], w});
+    }
+    for (i = 0; (e = ND_in(st->node[v]).list[i]); i++) {
+	int u = ND_low(agtail(e));
+	if (st->pos[u] >= 0)
+	    continue;
+	st->delta[u] -= ED_weight(e);
+	if (--st->outdeg[u] == 0)
+	    ids_push(&st->sinks, u);
+	heap_push(&st->heap, (cand_t){st->delta[u], u});
+    }
+}
+
+/* els:
+ * Order the nodes of the current component by repeatedly moving sinks to
+ * the back, sources to the front and otherwise the node whose out edges
+ * outweigh its in edges the most to the front, then reverse the edges
+ * pointing backwards in this order. See P. Eades, X. Lin and W. F. Smyth,
+ * "A fast and effective heuristic for the feedback arc set problem", 1993.
+ * This usually reverses fewer edges than depth-first search, whose choices
+ * depend on the order in which the nodes and edges are visited.
+ */
+static void els(graph_t * g)
+{
+    node_t *n;
+    edge_t *e;
+    int i, nn = 0;
+
+    for (n = GD_nlist(g); n; n = ND_next(n))
+	nn++;
+
+    els_t st = {0};
+    st.node = gv_calloc(nn, sizeof(node_t *));
+    st.indeg = gv_calloc(nn, sizeof(int));
+    st.outdeg = gv_calloc(nn, sizeof(int));
+    st.delta = gv_calloc(nn, sizeof(int64_t));
+    st.pos = gv_calloc(nn, sizeof(int));
+    st.lo = 0;
+    st.hi = nn - 1;
+
+    i = 0;
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	ND_low(n) = i;
+	st.node[i++] = n;
+    }
+    for (i = 0; i < nn; i++) {
+	n = st.node[i];
+	st.pos[i] = -1;
+	st.outdeg[i] = ND_out(n).size;
+	st.indeg[i] = ND_in(n).size;
+	for (int j = 0; (e = ND_out(n).list[j]); j++)
+	    st.delta[i] += ED_weight(e);
+	for (int j = 0; (e = ND_in(n).list[j]); j++)
+	    st.delta[i] -= ED_weight(e);
+	if (st.outdeg[i] == 0)
+	    ids_push(&st.sinks, i);
+	else if (st.indeg[i] == 0)
+	    ids_push(&st.sources, i);
+	heap_push(&st.heap, (cand_t){st.delta[i], i});
+    }
+
+    while (st.lo <= st.hi) {
+	if (!ids_is_empty(&st.sinks)) {
+	    int v = ids_pop(&st.sinks);
+	    if (st.pos[v] < 0)
+		els_place(&st, v, st.hi--);
+	} else if (!ids_is_empty(&st.sources)) {
+	    int v = ids_pop(&st.sources);
+	    if (st.pos[v] < 0)
+		els_place(&st, v, st.lo++);
 	} else {
-	    if (!ND_mark(w))
-		dfs(w);
+	    cand_t c = heap_pop(&st.heap);
+	    if (st.pos[c.id] < 0 && c.delta == st.delta[c.id])
+		els_place(&st, c.id, st.lo++);
+	}
+    }
+
+    /* reversing edges changes the out lists, so collect them first */
+    edges_t back = {0};
+    for (i = 0; i < nn; i++) {
+	for (int j = 0; (e = ND_out(st.node[i]).list[j]); j++) {
+	    if (st.pos[ND_low(aghead(e))] < st.pos[i])
+		edges_append(&back, e);
 	}
     }
-    ND_onstack(n) = false;
+    for (size_t k = 0; k < edges_size(&back); k++)
+	reverse_edge(edges_get(&back, k));
+
+    edges_free(&back);
+    ids_free(&st.sources);
+    ids_free(&st.sinks);
+    cands_free(&st.heap);
+    free(st.pos);
+    free(st.delta);
+    free(st.outdeg);
+    free(st.indeg);
+    free(st.node);
 }
 
+static bool use_els(graph_t * g)
+{
+    char *s = agget(dot_root(g), "cyclebreak");
+    return s && streq(s, "els");
+}
 
 void acyclic(graph_t * g)
 {
     int c;
     node_t *n;
+    frames_t stack = {0};
+    bool greedy = use_els(g);
 
     for (c = 0; c < GD_comp(g).size; c++) {
 	GD_nlist(g) = GD_comp(g).list[c];
+	if (greedy) {
+	    els(g);
+	    continue;
+	}
 	for (n = GD_nlist(g); n; n = ND_next(n))
 	    ND_mark(n) = FALSE;
 	for (n = GD_nlist(g); n; n = ND_next(n))
-	    dfs(n);
+	    dfs(&stack, n);
     }
+    frames_free(&stack);
 }
-
@@ -0,0 +1,765 @@
+/// \file
+/// \brief Brandes–Köpf horizontal coordinate assignment
+///
+/// An alternative to the network simplex formulation used by position.c to
+/// choose x coordinates, selected with `xcoord=bk`. It follows U. Brandes and
+/// B. Köpf, “Fast and Simple Horizontal Coordinate Assignment”, GD 2001. Nodes
+/// are aligned with a median neighbor into vertical blocks four times, once
+/// for each combination of top/bottom and left/right sweep. Each alignment is
+/// compacted horizontally and the four layouts are then balanced into one.
+/// Time and space are linear in the size of the ranked graph, where network
+/// simplex needs an auxiliary graph several times larger than it.
+///
+/// Separation between nodes is that of `make_LR_constraints`. Each cluster
+/// gets a left and a right boundary, placed during compaction like a node of
+/// its own under the constraints `pos_clusters` would give network simplex.
+/// Blocks are not allowed to wrap around a cluster, which would make these
+/// constraints contradictory.
+
+#include <assert.h>
+#include <cgraph/alloc.h>
+#include <cgraph/list.h>
+#include <dotgen/dot.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/// a minimum distance between the positions of two nodes or boundaries
+typedef struct {
+  int a, b; ///< indices of the nodes, `a` being on the left
+  int gap;
+} sep_t;
+
+DEFINE_LIST(seps, sep_t)
+
+/// how much of the layout to give up when constraints contradict each other
+typedef enum {
+  KEEP_ALL,       ///< nothing
+  DROP_LABELS,    ///< placement of flat edge labels between their endpoints
+  DROP_ALIGNMENT, ///< straight blocks of nodes
+  DROP_KEEPOUT,   ///< keeping nodes and clusters out of other clusters
+} relax_t;
+
+typedef struct {
+  graph_t *g;
+  int nranks;
+  int n;           ///< number of nodes over all ranks
+  int nclust;      ///< number of clusters, whose boundaries follow the nodes
+  node_t **node;   ///< nodes by index, rank by rank, left to right
+  int *rank_start; ///< index of the first node of each rank, plus a sentinel
+  int *rank;       ///< rank of each node, counted from 0
+
+  graph_t **clust;   ///< clusters by number, 0 being the root graph
+  int *clust_parent; ///< number of the parent of each cluster
+  int *clust_of;     ///< number of the lowest cluster containing each node
+  int *left_before;  ///< clusters ending left of a node, see `can_align`
+  int *left_after;
+
+  /// neighbors on the adjacent ranks, sorted left to right
+  int *up_start, *up;
+  bool *up_mark; ///< is the edge to this neighbor in a type 1 conflict?
+  int *down_start, *down;
+  bool *down_mark;
+
+  int *gap;   ///< separation from each node to its right neighbor
+  seps_t sep; ///< other separations, in the order of relax_t
+  size_t nsep_local;   ///< leading entries of `sep` kept at DROP_KEEPOUT
+  size_t nsep_keepout; ///< leading entries of `sep` kept at DROP_LABELS
+
+  int *root, *align; ///< blocks of the alignment being compacted
+} bk_t;
+
+/// index of the left or right boundary of cluster `c`
+static int left_of(bk_t *bk, int c) { return bk->n + 2 * (c - 1); }
+static int right_of(bk_t *bk, int c) { return bk->n + 2 * (c - 1) + 1; }
+
+static int index_of(bk_t *bk, node_t *v) {
+  int i = bk->rank_start[ND_rank(v) - GD_minrank(bk->g)] + ND_order(v);
+  assert(bk->node[i] == v);
+  return i;
+}
+
+static void add_sep(bk_t *bk, int a, int b, double gap) {
+  seps_append(&bk->sep, (sep_t){a, b, ROUND(gap)});
+}
+
+/* add_self_width:
+ * Widen the right side of nodes with loops, saving the original in ND_mval,
+ * as make_LR_constraints does.
+ */
+static void add_self_width(node_t *u) {
+  ND_mval(u) = ND_rw(u);
+  if (ND_other(u).size > 0) {
+    double sw = 0;
+    edge_t *e;
+    for (int k = 0; (e = ND_other(u).list[k]); k++) {
+      if (agtail(e) == aghead(e))
+        sw += selfRightSpace(e);
+    }
+    ND_rw(u) += sw;
+  }
+}
+
+static int intcmp(const void *x, const void *y) {
+  const int *a = x;
+  const int *b = y;
+  return (*a > *b) - (*a < *b);
+}
+
+/* count_clusters:
+ * Number the clusters below g in preorder, starting from next.
+ */
+static int count_clusters(bk_t *bk, graph_t *g, int parent, int next) {
+  for (int c = 1; c <= GD_n_cluster(g); c++) {
+    graph_t *subg = GD_clust(g)[c];
+    int id = next++;
+    if (bk->clust) {
+      bk->clust[id] = subg;
+      bk->clust_parent[id] = parent;
+    }
+    next = count_clusters(bk, subg, id, next);
+  }
+  return next;
+}
+
+/* slice:
+ * The nodes of cluster c on rank r, as a range of indices.
+ */
+static bool slice(bk_t *bk, int c, int r, int *first, int *last) {
+  graph_t *subg = bk->clust[c];
+  int rank = r + GD_minrank(bk->g);
+  if (rank < GD_minrank(subg) || rank > GD_maxrank(subg) ||
+      GD_rank(subg)[rank].n == 0)
+    return false;
+  *first = index_of(bk, GD_rank(subg)[rank].v[0]);
+  *last = *first + GD_rank(subg)[rank].n - 1;
+  return true;
+}
+
+/* build_clusters:
+ * Find the lowest cluster of every node and, for each pair of adjacent
+ * ranks, how many of the clusters on both end left of each node.
+ */
+static void build_clusters(bk_t *bk) {
+  bk->nclust = count_clusters(bk, bk->g, 0, 1) - 1;
+  bk->clust = gv_calloc((size_t)bk->nclust + 1, sizeof(graph_t *));
+  bk->clust_parent = gv_calloc((size_t)bk->nclust + 1, sizeof(int));
+  bk->clust[0] = bk->g;
+  count_clusters(bk, bk->g, 0, 1);
+
+  bk->clust_of = gv_calloc((size_t)bk->n, sizeof(int));
+  bk->left_before = gv_calloc((size_t)bk->n, sizeof(int));
+  bk->left_after = gv_calloc((size_t)bk->n, sizeof(int));
+  /* in preorder, so that subclusters overwrite their parents */
+  for (int c = 1; c <= bk->nclust; c++) {
+    for (int r = 0; r < bk->nranks; r++) {
+      int first, last, f, l;
+      if (!slice(bk, c, r, &first, &last))
+        continue;
+      for (int i = first; i <= last; i++)
+        bk->clust_of[i] = c;
+      /* ends of clusters present on this rank and the next */
+      if (r + 1 < bk->nranks && slice(bk, c, r + 1, &f, &l)) {
+        bk->left_before[last]++;
+        bk->left_after[l]++;
+      }
+    }
+  }
+  /* turn them into counts of ends strictly left of each node */
+  for (int r = 0; r < bk->nranks; r++) {
+    int before = 0, after = 0;
+    for (int i = bk->rank_start[r]; i < bk->rank_start[r + 1]; i++) {
+      int b = bk->left_before[i], a = bk->left_after[i];
+      bk->left_before[i] = before;
+      bk->left_after[i] = after;
+      before += b;
+      after += a;
+    }
+  }
+}
+
+/* can_align:
+ * Can node u on some rank and node v on the next one be part of a block?
+ * They must belong to the same clusters and be on the same side of any
+ * other cluster present on both ranks; otherwise the block would have to
+ * cross the boundary of a cluster.
+ */
+static bool can_align(bk_t *bk, int u, int v) {
+  return bk->clust_of[u] == bk->clust_of[v] &&
+         bk->left_before[u] == bk->left_after[v];
+}
+
+/* skip_node:
+ * Nodes holding the labels of flat edges are kept out of alignments, so
+ * that they can be placed between the endpoints of their edge.
+ */
+static bool skip_node(node_t *v) { return ND_alg(v) != NULL; }
+
+/* build_adjacency:
+ * Fill up/down with the neighbors of every node on the adjacent ranks.
+ */
+static void build_adjacency(bk_t *bk) {
+  bk->up_start = gv_calloc((size_t)bk->n + 1, sizeof(int));
+  bk->down_start = gv_calloc((size_t)bk->n + 1, sizeof(int));
+
+  for (int pass = 0; pass < 2; pass++) {
+    int nup = 0, ndown = 0;
+    for (int i = 0; i < bk->n; i++) {
+      node_t *v = bk->node[i];
+      bk->up_start[i] = nup;
+      bk->down_start[i] = ndown;
+      for (int k = 0; k < ND_in(v).size; k++) {
+        node_t *u = agtail(ND_in(v).list[k]);
+        if (ND_rank(u) != ND_rank(v) - 1 || skip_node(u) || skip_node(v))
+          continue;
+        if (pass)
+          bk->up[nup] = index_of(bk, u);
+        nup++;
+      }
+      for (int k = 0; k < ND_out(v).size; k++) {
+        node_t *w = aghead(ND_out(v).list[k]);
+        if (ND_rank(w) != ND_rank(v) + 1 || skip_node(v) || skip_node(w))
+          continue;
+        if (pass)
+          bk->down[ndown] = index_of(bk, w);
+        ndown++;
+      }
+    }
+    bk->up_start[bk->n] = nup;
+    bk->down_start[bk->n] = ndown;
+    if (!pass) {
+      bk->up = gv_calloc((size_t)nup + 1, sizeof(int));
+      bk->up_mark = gv_calloc((size_t)nup + 1, sizeof(bool));
+      bk->down = gv_calloc((size_t)ndown + 1, sizeof(int));
+      bk->down_mark = gv_calloc((size_t)ndown + 1, sizeof(bool));
+    }
+  }
+
+  for (int i = 0; i < bk->n; i++) {
+    qsort(bk->up + bk->up_start[i], (size_t)(bk->up_start[i + 1] -
+          bk->up_start[i]), sizeof(int), intcmp);
+    qsort(bk->down + bk->down_start[i], (size_t)(bk->down_start[i + 1] -
+          bk->down_start[i]), sizeof(int), intcmp);
+  }
+}
+
+static bool is_virtual(bk_t *bk, int i) {
+  return ND_node_type(bk->node[i]) == VIRTUAL;
+}
+
+/* inner_upper:
+ * If v is the lower end of an inner segment, i.e. an edge between two
+ * virtual nodes, return the upper end, else -1.
+ */
+static int inner_upper(bk_t *bk, int v) {
+  if (!is_virtual(bk, v))
+    return -1;
+  for (int k = bk->up_start[v]; k < bk->up_start[v + 1]; k++) {
+    if (is_virtual(bk, bk->up[k]))
+      return bk->up[k];
+  }
+  return -1;
+}
+
+static void mark_edge(bk_t *bk, int k, int v) {
+  int u = bk->up[k];
+  bk->up_mark[k] = true;
+  for (int j = bk->down_start[u]; j < bk->down_start[u + 1]; j++) {
+    if (bk->down[j] == v)
+      bk->down_mark[j] = true;
+  }
+}
+
+/* mark_conflicts:
+ * Mark edges crossing an inner segment, so that long edges are kept
+ * straight in preference to short ones. Edges that cannot be part of a block
+ * at all are marked too.
+ */
+static void mark_conflicts(bk_t *bk) {
+  for (int r = 1; r < bk->nranks; r++) {
+    int upper = bk->rank_start[r - 1];
+    int start = bk->rank_start[r];
+    int end = bk->rank_start[r + 1];
+    int k0 = 0;
+    int l = start;
+    for (int l1 = start; l1 < end; l1++) {
+      int w = inner_upper(bk, l1);
+      if (l1 != end - 1 && w < 0)
+        continue;
+      int k1 = w >= 0 ? w - upper : start - 1 - upper;
+      for (; l <= l1; l++) {
+        for (int k = bk->up_start[l]; k < bk->up_start[l + 1]; k++) {
+          int pos = bk->up[k] - upper;
+          if (pos < k0 || pos > k1 || !can_align(bk, bk->up[k], l))
+            mark_edge(bk, k, l);
+        }
+      }
+      k0 = k1;
+    }
+  }
+}
+
+static int margin_of(bk_t *bk, int c) {
+  return late_int(bk->clust[c], G_margin, CL_OFFSET, 0);
+}
+
+/* sibling_gap:
+ * If u and v, neighbors on a rank, are in different subclusters of the
+ * same cluster, separate those subclusters.
+ */
+static void sibling_gap(bk_t *bk, int u, int v) {
+  int cu = bk->clust_of[u], cv = bk->clust_of[v];
+  int su = 0, sv = 0; /* children of the common ancestor */
+  while (cu != cv) {
+    /* preorder numbers grow with depth along a path from the root */
+    if (cu > cv) {
+      su = cu;
+      cu = bk->clust_parent[cu];
+    } else {
+      sv = cv;
+      cv = bk->clust_parent[cv];
+    }
+  }
+  if (su && sv)
+    add_sep(bk, right_of(bk, su), left_of(bk, sv), margin_of(bk, cu));
+}
+
+/* build_separation:
+ * Fill gap and sep with the minimum distances between nodes and cluster
+ * boundaries.
+ */
+static void build_separation(bk_t *bk) {
+  graph_t *g = bk->g;
+  int sep[2];
+
+  /* Use smaller separation on odd ranks if g has edge labels */
+  if (GD_has_labels(g->root) & EDGE_LABEL) {
+    sep[0] = GD_nodesep(g);
+    sep[1] = 5;
+  } else {
+    sep[1] = sep[0] = GD_nodesep(g);
+  }
+
+  bk->gap = gv_calloc((size_t)bk->n, sizeof(int));
+  for (int r = 0; r < bk->nranks; r++) {
+    int nodesep = sep[(r + GD_minrank(g)) & 1];
+    for (int i = bk->rank_start[r]; i + 1 < bk->rank_start[r + 1]; i++) {
+      node_t *u = bk->node[i];
+      node_t *v = bk->node[i + 1];
+      bk->gap[i] = ROUND(ND_rw(u) + ND_lw(v) + nodesep);
+    }
+  }
+
+  /* flat edges */
+  for (int i = 0; i < bk->n; i++) {
+    node_t *u = bk->node[i];
+    for (int k = 0; k < ND_flat_out(u).size; k++) {
+      edge_t *e = ND_flat_out(u).list[k];
+      node_t *t0 = agtail(e), *h0 = aghead(e);
+      if (ND_order(t0) > ND_order(h0)) {
+        node_t *tmp = t0;
+        t0 = h0;
+        h0 = tmp;
+      }
+      double width = ND_rw(t0) + ND_lw(h0);
+      double m0 = ED_minlen(e) * GD_nodesep(g) + width;
+      int a = index_of(bk, t0);
+      int b = index_of(bk, h0);
+      if (b == a + 1) {
+        m0 = MAX(m0, width + GD_nodesep(g) + ROUND(ED_dist(e)));
+        bk->gap[a] = MAX(bk->gap[a], ROUND(m0));
+      } else if (!ED_label(e)) {
+        add_sep(bk, a, b, m0);
+      }
+    }
+  }
+
+  /* nodes and subclusters within clusters, as contain_nodes and
+   * contain_subclust do
+   */
+  for (int c = 1; c <= bk->nclust; c++) {
+    graph_t *subg = bk->clust[c];
+    int ln = left_of(bk, c), rn = right_of(bk, c);
+    int margin = margin_of(bk, c);
+    for (int r = 0; r < bk->nranks; r++) {
+      int first, last;
+      if (!slice(bk, c, r, &first, &last))
+        continue;
+      add_sep(bk, ln, first, ND_lw(bk->node[first]) + margin +
+              GD_border(subg)[LEFT_IX].x);
+      add_sep(bk, last, rn, ND_rw(bk->node[last]) + margin +
+              GD_border(subg)[RIGHT_IX].x);
+    }
+    int p = bk->clust_parent[c];
+    if (p) {
+      graph_t *parent = bk->clust[p];
+      int pmargin = margin_of(bk, p);
+      add_sep(bk, left_of(bk, p), ln, pmargin + GD_border(parent)[LEFT_IX].x);
+      add_sep(bk, rn, right_of(bk, p), pmargin +
+              GD_border(parent)[RIGHT_IX].x);
+    }
+    if (GD_label(subg) && !GD_flip(agroot(subg)))
+      add_sep(bk, ln, rn, MAX(GD_border(subg)[BOTTOM_IX].x,
+                              GD_border(subg)[TOP_IX].x));
+  }
+  bk->nsep_local = seps_size(&bk->sep);
+
+  /* everything else out of clusters, as keepout_othernodes and
+   * separate_subclust do
+   */
+  for (int c = 1; c <= bk->nclust; c++) {
+    int margin = margin_of(bk, c);
+    for (int r = 0; r < bk->nranks; r++) {
+      int first, last;
+      if (!slice(bk, c, r, &first, &last))
+        continue;
+      if (first > bk->rank_start[r])
+        add_sep(bk, first - 1, left_of(bk, c),
+                margin + ND_rw(bk->node[first - 1]));
+      if (last + 1 < bk->rank_start[r + 1])
+        add_sep(bk, right_of(bk, c), last + 1,
+                margin + ND_lw(bk->node[last + 1]));
+    }
+  }
+  for (int r = 0; r < bk->nranks && bk->nclust > 0; r++) {
+    for (int i = bk->rank_start[r]; i + 1 < bk->rank_start[r + 1]; i++)
+      sibling_gap(bk, i, i + 1);
+  }
+  bk->nsep_keepout = seps_size(&bk->sep);
+
+  /* labels of flat edges, on the rank above the edge */
+  for (int i = 0; i < bk->n; i++) {
+    node_t *u = bk->node[i];
+    edge_t *e = ND_alg(u);
+    if (e == NULL || ND_out(u).size < 2)
+      continue;
+    edge_t *e0 = ND_out(u).list[0];
+    edge_t *e1 = ND_out(u).list[1];
+    if (ND_order(aghead(e0)) > ND_order(aghead(e1))) {
+      edge_t *ff = e0;
+      e0 = e1;
+      e1 = ff;
+    }
+    int m0 = (ED_minlen(e) * GD_nodesep(g)) / 2;
+    add_sep(bk, index_of(bk, aghead(e0)), i,
+            m0 + ND_rw(aghead(e0)) + ND_lw(u));
+    add_sep(bk, i, index_of(bk, aghead(e1)),
+            m0 + ND_rw(u) + ND_lw(aghead(e1)));
+  }
+}
+
+/* pos:
+ * Position of node i within its rank, counted from the side
+ * the current sweep starts at.
+ */
+static int pos(bk_t *bk, int i, bool right) {
+  int r = bk->rank[i];
+  return right ? bk->rank_start[r + 1] - 1 - i : i - bk->rank_start[r];
+}
+
+/* vertical_alignment:
+ * Group nodes into blocks by aligning each with a median neighbor on the
+ * previous rank of the sweep, never crossing a marked edge or an earlier
+ * alignment.
+ */
+static void vertical_alignment(bk_t *bk, bool bottom, bool right,
+                               relax_t relax) {
+  int size = bk->n + 2 * bk->nclust;
+  for (int i = 0; i < size; i++)
+    bk->root[i] = bk->align[i] = i;
+  if (relax >= DROP_ALIGNMENT)
+    return;
+
+  int *start = bottom ? bk->down_start : bk->up_start;
+  int *adj = bottom ? bk->down : bk->up;
+  bool *mark = bottom ? bk->down_mark : bk->up_mark;
+
+  for (int s = 1; s < bk->nranks; s++) {
+    int r = bottom ? bk->nranks - 1 - s : s;
+    int len = bk->rank_start[r + 1] - bk->rank_start[r];
+    int last = -1;
+    for (int j = 0; j < len; j++) {
+      int v = right ? bk->rank_start[r + 1] - 1 - j : bk->rank_start[r] + j;
+      int d = start[v + 1] - start[v];
+      if (d == 0)
+        continue;
+      for (int m = (d - 1) / 2; m <= d / 2; m++) {
+        if (bk->align[v] != v)
+          break;
+        int k = start[v] + (right ? d - 1 - m : m);
+        int u = adj[k];
+        if (!mark[k] && last < pos(bk, u, right)) {
+          bk->align[u] = v;
+          bk->root[v] = bk->root[u];
+          bk->align[v] = bk->root[v];
+          last = pos(bk, u, right);
+        }
+      }
+    }
+  }
+}
+
+/* block_edge:
+ * The k-th separation constraint as an edge between blocks, leading away
+ * from the side the sweep starts at. Returns false if there is no such
+ * constraint, i.e. k refers to the last node of a rank.
+ */
+static bool block_edge(bk_t *bk, size_t k, bool right, int *a, int *b,
+                       int *gap) {
+  size_t n = (size_t)bk->n;
+  if (k < n - 1) {
+    if (bk->rank[k] != bk->rank[k + 1])
+      return false;
+    *a = (int)k;
+    *b = (int)k + 1;
+    *gap = bk->gap[k];
+  } else {
+    const sep_t *s = seps_at(&bk->sep, k - (n - 1));
+    *a = s->a;
+    *b = s->b;
+    *gap = s->gap;
+  }
+  if (right) {
+    int t = *a;
+    *a = *b;
+    *b = t;
+  }
+  *a = bk->root[*a];
+  *b = bk->root[*b];
+  return true;
+}
+
+/* horizontal_compaction:
+ * Place the blocks as close to each other as the separation constraints
+ * allow, working from the side the sweep starts at, and set x for every node
+ * and cluster boundary. If the constraints between blocks form a cycle,
+ * nothing is placed and false is returned.
+ */
+static bool horizontal_compaction(bk_t *bk, bool right, relax_t relax,
+                                  int *x) {
+  int n = bk->n + 2 * bk->nclust;
+  size_t nsep = (size_t)bk->n - 1;
+  if (relax >= DROP_KEEPOUT)
+    nsep += bk->nsep_local;
+  else if (relax >= DROP_LABELS)
+    nsep += bk->nsep_keepout;
+  else
+    nsep += seps_size(&bk->sep);
+  int *out_start = gv_calloc((size_t)n + 1, sizeof(int));
+  int *indeg = gv_calloc((size_t)n, sizeof(int));
+  int a, b, gap;
+
+  /* the block graph, as adjacency lists */
+  for (size_t k = 0; k < nsep; k++) {
+    if (block_edge(bk, k, right, &a, &b, &gap)) {
+      out_start[a + 1]++;
+      indeg[b]++;
+    }
+  }
+  for (int i = 0; i < n; i++)
+    out_start[i + 1] += out_start[i];
+  int *fill = gv_calloc((size_t)n, sizeof(int));
+  int *to = gv_calloc((size_t)out_start[n] + 1, sizeof(int));
+  int *len = gv_calloc((size_t)out_start[n] + 1, sizeof(int));
+  for (size_t k = 0; k < nsep; k++) {
+    if (block_edge(bk, k, right, &a, &b, &gap)) {
+      int slot = out_start[a] + fill[a]++;
+      to[slot] = b;
+      len[slot] = gap;
+    }
+  }
+  free(fill);
+
+  /* longest paths from the sources, in topological order */
+  int *order = gv_calloc((size_t)n, sizeof(int));
+  int head = 0, tail = 0, nblocks = 0;
+  for (int i = 0; i < n; i++) {
+    if (bk->root[i] != i)
+      continue;
+    nblocks++;
+    x[i] = 0;
+    if (indeg[i] == 0)
+      order[tail++] = i;
+  }
+  while (head < tail) {
+    a = order[head++];
+    for (int k = out_start[a]; k < out_start[a + 1]; k++) {
+      b = to[k];
+      x[b] = MAX(x[b], x[a] + len[k]);
+      if (--indeg[b] == 0)
+        order[tail++] = b;
+    }
+  }
+  const bool acyclic = tail == nblocks;
+
+  if (acyclic) {
+    /* pull blocks towards their successors to close any slack */
+    for (int h = tail - 1; h >= 0; h--) {
+      a = order[h];
+      int lim = INT_MAX;
+      for (int k = out_start[a]; k < out_start[a + 1]; k++)
+        lim = MIN(lim, x[to[k]] - len[k]);
+      if (lim != INT_MAX)
+        x[a] = MAX(x[a], lim);
+    }
+    /* every node goes where the root of its block went */
+    for (int i = 0; i < n; i++)
+      x[i] = x[bk->root[i]];
+    if (right) {
+      for (int i = 0; i < n; i++)
+        x[i] = -x[i];
+    }
+  }
+
+  free(order);
+  free(to);
+  free(len);
+  free(out_start);
+  free(indeg);
+  return acyclic;
+}
+
+/* compact_all:
+ * Align and compact in each of the four directions.
+ */
+static bool compact_all(bk_t *bk, relax_t relax, int *xs[4]) {
+  for (int d = 0; d < 4; d++) {
+    bool bottom = d & 2;
+    bool right = d & 1;
+    vertical_alignment(bk, bottom, right, relax);
+    if (!horizontal_compaction(bk, right, relax, xs[d]))
+      return false;
+  }
+  return true;
+}
+
+static double lw_of(bk_t *bk, int i) {
+  return i < bk->n ? ND_lw(bk->node[i]) : 0;
+}
+
+static double rw_of(bk_t *bk, int i) {
+  return i < bk->n ? ND_rw(bk->node[i]) : 0;
+}
+
+/* balance:
+ * Combine the four layouts. Each is shifted to line up with the narrowest on
+ * the side its sweep started from, and every node takes the average of its
+ * two median coordinates. Separation constraints survive this, as they hold
+ * for each order statistic of the four.
+ */
+static void balance(bk_t *bk, int *xs[4], int *x) {
+  int n = bk->n + 2 * bk->nclust;
+  double lo[4], hi[4];
+  int best = 0;
+  for (int d = 0; d < 4; d++) {
+    lo[d] = INT_MAX;
+    hi[d] = -INT_MAX;
+    for (int i = 0; i < n; i++) {
+      lo[d] = MIN(lo[d], xs[d][i] - lw_of(bk, i));
+      hi[d] = MAX(hi[d], xs[d][i] + rw_of(bk, i));
+    }
+    if (hi[d] - lo[d] < hi[best] - lo[best])
+      best = d;
+  }
+  for (int d = 0; d < 4; d++) {
+    bool right = d & 1;
+    int shift = right ? ROUND(hi[best] - hi[d]) : ROUND(lo[best] - lo[d]);
+    for (int i = 0; i < n; i++)
+      xs[d][i] += shift;
+  }
+
+  for (int i = 0; i < n; i++) {
+    int v[4] = {xs[0][i], xs[1][i], xs[2][i], xs[3][i]};
+    qsort(v, 4, sizeof(int), intcmp);
+    int s = v[1] + v[2];
+    x[i] = (s - (s < 0)) / 2; /* round down, also for negative sums */
+  }
+}
+
+/* dot_bk_xcoords:
+ * Choose x coordinates for the nodes of the ranks of g, which are left in
+ * ND_rank for set_xcoords as network simplex would. The x extent of each
+ * cluster is left in the x coordinates of its bounding box. Loops widen
+ * ND_rw as in make_LR_constraints.
+ */
+void dot_bk_xcoords(graph_t *g) {
+  bk_t bk = {.g = g};
+  bk.nranks = GD_maxrank(g) - GD_minrank(g) + 1;
+  bk.rank_start = gv_calloc((size_t)bk.nranks + 1, sizeof(int));
+  for (int r = 0; r < bk.nranks; r++) {
+    bk.rank_start[r] = bk.n;
+    bk.n += GD_rank(g)[r + GD_minrank(g)].n;
+  }
+  bk.rank_start[bk.nranks] = bk.n;
+  if (bk.n == 0) {
+    free(bk.rank_start);
+    return;
+  }
+
+  bk.node = gv_calloc((size_t)bk.n, sizeof(node_t *));
+  bk.rank = gv_calloc((size_t)bk.n, sizeof(int));
+  for (int r = 0; r < bk.nranks; r++) {
+    rank_t *rk = &GD_rank(g)[r + GD_minrank(g)];
+    for (int j = 0; j < rk->n; j++) {
+      bk.node[bk.rank_start[r] + j] = rk->v[j];
+      bk.rank[bk.rank_start[r] + j] = r;
+      add_self_width(rk->v[j]);
+    }
+  }
+
+  build_clusters(&bk);
+  build_adjacency(&bk);
+  mark_conflicts(&bk);
+  build_separation(&bk);
+
+  size_t size = (size_t)bk.n + 2 * (size_t)bk.nclust;
+  bk.root = gv_calloc(size, sizeof(int));
+  bk.align = gv_calloc(size, sizeof(int));
+  int *xs[4];
+  for (int d = 0; d < 4; d++)
+    xs[d] = gv_calloc(size, sizeof(int));
+  /* constraints may contradict each other, e.g. with clusters ordered
+   * differently on different ranks; give up on as little as possible
+   */
+  relax_t relax = KEEP_ALL;
+  while (!compact_all(&bk, relax, xs)) {
+    assert(relax < DROP_KEEPOUT);
+    ++relax;
+  }
+  if (relax >= DROP_KEEPOUT)
+    agwarningf("xcoord=bk: clusters of %s may overlap\n", agnameof(g));
+
+  int *x = bk.root; /* no longer needed */
+  balance(&bk, xs, x);
+
+  int min_x = INT_MAX;
+  for (int i = 0; i < bk.n; i++)
+    min_x = MIN(min_x, x[i]);
+  for (int i = 0; i < bk.n; i++)
+    ND_rank(bk.node[i]) = x[i] - min_x;
+  for (int c = 1; c <= bk.nclust; c++) {
+    GD_bb(bk.clust[c]).LL.x = x[left_of(&bk, c)] - min_x;
+    GD_bb(bk.clust[c]).UR.x = x[right_of(&bk, c)] - min_x;
+  }
+
+  for (int d = 0; d < 4; d++)
+    free(xs[d]);
+  free(bk.align);
+  free(bk.root);
+  seps_free(&bk.sep);
+  free(bk.gap);
+  free(bk.up_start);
+  free(bk.up);
+  free(bk.up_mark);
+  free(bk.down_start);
+  free(bk.down);
+  free(bk.down_mark);
+  free(bk.left_after);
+  free(bk.left_before);
+  free(bk.clust_of);
+  free(bk.clust_parent);
+  free(bk.clust);
+  free(bk.rank);
+  free(bk.node);
+  free(bk.rank_start);
+}
@@ -0,0 +1,185 @@
+/// \file
+/// \brief Implementation of the cluster layout cache declared in clustcache.h
+
+#include <cgraph/alloc.h>
+#include <dotgen/clustcache.h>
+#include <dotgen/dot.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// number of entries beyond which the cache is emptied rather than grown
+enum { MAX_ENTRIES = 4096 };
+
+/// FNV-1a
+static const uint64_t HASH_INIT = 0xcbf29ce484222325ull;
+
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t len) {
+  const unsigned char *p = data;
+  for (size_t i = 0; i < len; ++i) {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+/// mix in a string, NULL being told apart by a byte UTF-8 never uses
+static uint64_t hash_str(uint64_t h, const char *s) {
+  if (s == NULL)
+    return hash_bytes(h, "\xff", 1);
+  return hash_bytes(h, s, strlen(s) + 1);
+}
+
+static uint64_t hash_int(uint64_t h, int v) {
+  return hash_bytes(h, &v, sizeof(v));
+}
+
+/// attributes dot writes back into the graph, which do not affect layout
+static bool is_output_attr(const char *name) {
+  static const char *const outputs[] = {
+      "bb",       "lp",      "lwidth",   "lheight",  "pos",     "xlp",
+      "head_lp",  "tail_lp", "_draw_",   "_ldraw_",  "_hdraw_", "_tdraw_",
+      "_hldraw_", "_tldraw_"};
+  for (size_t i = 0; i < sizeof(outputs) / sizeof(outputs[0]); ++i) {
+    if (strcmp(name, outputs[i]) == 0)
+      return true;
+  }
+  return false;
+}
+
+/// mix in the attributes of the given kind of `obj`
+static uint64_t hash_attrs(uint64_t h, Agraph_t *root, int kind, void *obj) {
+  for (Agsym_t *sym = agnxtattr(root, kind, NULL); sym;
+       sym = agnxtattr(root, kind, sym)) {
+    if (is_output_attr(sym->name))
+      continue;
+    h = hash_str(h, sym->name);
+    h = hash_str(h, agxget(obj, sym));
+  }
+  return h;
+}
+
+/// hash of a subgraph's name, attributes and members
+///
+/// Subgraphs are not kept in input order, so those of `g` are combined in a
+/// way that does not depend on the order of their visit.
+static uint64_t hash_subgraph(Agraph_t *root, Agraph_t *g) {
+  // anonymous subgraphs are named after a counter that keeps running from
+  // one graph to the next
+  const char *name = agnameof(g);
+  uint64_t h = hash_str(HASH_INIT, name[0] == '%' ? NULL : name);
+  h = hash_attrs(h, root, AGRAPH, g);
+  h = hash_int(h, agnnodes(g));
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n))
+    h = hash_str(h, agnameof(n));
+  uint64_t subgraphs = 0;
+  for (Agraph_t *sg = agfstsubg(g); sg; sg = agnxtsubg(sg))
+    subgraphs += hash_subgraph(root, sg);
+  return hash_bytes(h, &subgraphs, sizeof(subgraphs));
+}
+
+bool dot_cluster_cache_enabled(Agraph_t *g) {
+  return mapbool(agget(agroot(g), "clustercache"));
+}
+
+uint64_t dot_cluster_hash(Agraph_t *clust) {
+  Agraph_t *root = agroot(clust);
+
+  uint64_t h = hash_attrs(HASH_INIT, root, AGRAPH, root);
+  h = hash_int(h, GD_has_labels(dot_root(clust)));
+  uint64_t structure = hash_subgraph(root, clust);
+  h = hash_bytes(h, &structure, sizeof(structure));
+
+  for (Agnode_t *n = agfstnode(clust); n; n = agnxtnode(clust, n)) {
+    h = hash_attrs(h, root, AGNODE, n);
+    for (Agedge_t *e = agfstout(root, n); e; e = agnxtout(root, e)) {
+      if (!agcontains(clust, aghead(e)))
+        continue;
+      h = hash_str(h, agnameof(aghead(e)));
+      h = hash_str(h, agnameof(e));
+      h = hash_attrs(h, root, AGEDGE, e);
+    }
+    h = hash_str(h, NULL);
+  }
+  return h;
+}
+
+uint64_t dot_node_signature(Agnode_t *v) {
+  if (ND_node_type(v) == NORMAL)
+    return hash_str(hash_bytes(HASH_INIT, "n", 1), agnameof(v));
+
+  Agraph_t *clust = ND_clust(v);
+  if (clust && GD_rankleader(clust) && GD_rankleader(clust)[ND_rank(v)] == v)
+    return hash_str(hash_bytes(HASH_INIT, "c", 1), agnameof(clust));
+
+  // follow the chain to the edge it was made for
+  Agedge_t *e = NULL;
+  if (ND_out(v).size > 0)
+    e = ND_out(v).list[0];
+  else if (ND_in(v).size > 0)
+    e = ND_in(v).list[0];
+  while (e && ED_to_orig(e))
+    e = ED_to_orig(e);
+  if (e == NULL || ND_node_type(agtail(e)) != NORMAL ||
+      ND_node_type(aghead(e)) != NORMAL)
+    return hash_bytes(HASH_INIT, "v", 1);
+
+  uint64_t h = hash_bytes(HASH_INIT, "e", 1);
+  h = hash_str(h, agnameof(agtail(e)));
+  h = hash_str(h, agnameof(aghead(e)));
+  h = hash_str(h, ED_tail_port(e).name);
+  return hash_str(h, ED_head_port(e).name);
+}
+
+static void free_entry(Dt_t *d, void *obj, Dtdisc_t *disc) {
+  (void)d;
+  (void)disc;
+
+  clust_entry_t *ent = obj;
+  free(ent->ranks);
+  free(ent->rank_size);
+  free(ent->order);
+  free(ent);
+}
+
+static int cmp_key(Dt_t *d, void *key1, void *key2, Dtdisc_t *disc) {
+  (void)d;
+  (void)disc;
+
+  const uint64_t *k1 = key1;
+  const uint64_t *k2 = key2;
+  if (*k1 < *k2)
+    return -1;
+  if (*k1 > *k2)
+    return 1;
+  return 0;
+}
+
+static Dtdisc_t entry_disc = {
+    .key = offsetof(clust_entry_t, key),
+    .size = sizeof(uint64_t),
+    .link = offsetof(clust_entry_t, link),
+    .freef = free_entry,
+    .comparf = cmp_key,
+};
+
+static Dt_t *cache;
+
+clust_entry_t *dot_cluster_cache(uint64_t key, bool create) {
+  if (cache == NULL) {
+    if (!create)
+      return NULL;
+    cache = dtopen(&entry_disc, Dtoset);
+  }
+
+  clust_entry_t *ent = dtmatch(cache, &key);
+  if (ent != NULL || !create)
+    return ent;
+
+  if (dtsize(cache) >= MAX_ENTRIES)
+    dtclear(cache);
+  ent = gv_alloc(sizeof(clust_entry_t));
+  ent->key = key;
+  dtinsert(cache, ent);
+  return ent;
+}
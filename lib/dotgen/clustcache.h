@@ -0,0 +1,62 @@
+/// \file
+/// \brief Cache of per-cluster layout results across dot layouts
+///
+/// When the `clustercache` graph attribute is true, dot remembers the local
+/// ranking and the node ordering it computed for each cluster, keyed by a
+/// hash of the cluster's contents. A later layout in the same process that
+/// meets a cluster with the same hash reuses these instead of running network
+/// simplex and crossing minimization on it again. This pays off when the same
+/// graphs are laid out repeatedly with small changes confined to a few
+/// clusters.
+///
+/// The cache is process wide and not synchronized; it is only accessed from
+/// the serial parts of dot.
+
+#pragma once
+
+#include <cdt.h>
+#include <cgraph/cgraph.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/// what is remembered of a cluster laid out before
+typedef struct {
+  uint64_t key;   ///< \ref dot_cluster_hash of the cluster
+  Dtlink_t link;
+
+  /// rank of each node of the cluster, in `agfstnode` order, relative to the
+  /// cluster's top rank
+  int *ranks;
+  int n_ranks; ///< number of entries in `ranks`, 0 if none recorded
+
+  /// number of nodes on each rank of the cluster during crossing minimization
+  int *rank_size;
+  int n_rank_size; ///< number of entries in `rank_size`, 0 if none recorded
+  /// \ref dot_node_signature of those nodes, rank by rank, left to right
+  uint64_t *order;
+} clust_entry_t;
+
+/// should layout results of the clusters of `g` be cached?
+bool dot_cluster_cache_enabled(Agraph_t *g);
+
+/// hash of everything about a cluster that its local layout depends on
+///
+/// This covers the attributes of the root graph, the cluster and its
+/// subgraphs, the cluster's nodes with their attributes, and the edges of the
+/// root graph joining two of these nodes with their attributes. Objects are
+/// identified by name and visited in sequence order, so the hash is the same
+/// across separate readings of the same input.
+uint64_t dot_cluster_hash(Agraph_t *clust);
+
+/// look up the cache entry for `key`
+///
+/// \param key A value returned by \ref dot_cluster_hash
+/// \param create Add an empty entry if there is none
+/// \return The entry, or NULL if there is none and `create` is false
+clust_entry_t *dot_cluster_cache(uint64_t key, bool create);
+
+/// a name for a node of the rank arrays stable across layouts
+///
+/// Real nodes are identified by name, the rank leaders of collapsed clusters
+/// by the cluster's name, and the virtual nodes of an edge chain by the edge.
+uint64_t dot_node_signature(Agnode_t *v);
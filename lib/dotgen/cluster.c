@@ -280,21 +280,20 @@ remove_rankleaders(graph_t * g)
 	delete_fast_node(dot_root(g), v);
 	free(ND_in(v).list);
 	free(ND_out(v).list);
-	free(v->base.data);
-	free(v);
+	/* the node itself goes with the other virtual nodes in dot_cleanup */
 	GD_rankleader(g)[r] = NULL;
     }
 }
 
 /* delete virtual nodes of a cluster, and install real nodes or sub-clusters */
-void expand_cluster(graph_t * subg)
+void expand_cluster(mincross_state_t * st, graph_t * subg)
 {
     /* build internal structure of the cluster */
     class2(subg);
     GD_comp(subg).size = 1;
     GD_comp(subg).list[0] = GD_nlist(subg);
     allocate_ranks(subg);
-    build_ranks(subg, 0);
+    build_ranks(st, subg, 0);
     merge_ranks(subg);
 
     /* build external structure of the cluster */
@@ -384,7 +383,8 @@ void build_skeleton(graph_t * g, graph_t * subg)
     }
 }
 
-void install_cluster(graph_t * g, node_t * n, int pass, nodequeue * q)
+void install_cluster(mincross_state_t * st, graph_t * g, node_t * n, int pass,
+		     nodequeue * q)
 {
     int r;
     graph_t *clust;
@@ -392,7 +392,7 @@ void install_cluster(graph_t * g, node_t * n, int pass, nodequeue * q)
     clust = ND_clust(n);
     if (GD_installed(clust) != pass + 1) {
 	for (r = GD_minrank(clust); r <= GD_maxrank(clust); r++)
-	    install_in_rank(g, GD_rankleader(clust)[r]);
+	    install_in_rank(st, g, GD_rankleader(clust)[r]);
 	for (r = GD_minrank(clust); r <= GD_maxrank(clust); r++)
 	    enqueue_neighbors(q, GD_rankleader(clust)[r], pass);
 	GD_installed(clust) = pass + 1;
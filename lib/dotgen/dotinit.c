@@ -10,10 +10,12 @@
 
 #include <assert.h>
 #include <time.h>
+#include <cgraph/arena.h>
 #include <dotgen/dot.h>
 #include <pack/pack.h>
 #include <dotgen/aspect.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 static void
 dot_init_subg(graph_t * g, graph_t* droot)
@@ -127,8 +129,6 @@ static void free_virtual_node_list(node_t * vn)
 	if (ND_node_type(vn) == VIRTUAL) {
 	    free_list(ND_out(vn));
 	    free_list(ND_in(vn));
-	    free(vn->base.data);
-	    free(vn);
 	}
 	vn = next_vn;
     }
@@ -173,6 +173,12 @@ void dot_cleanup(graph_t * g)
 	}
 	dot_cleanup_node(n);
     }
+    if (GD_vnodes(g)) {
+	arena_reset(GD_vnodes(g));
+	free(GD_vnodes(g));
+	GD_vnodes(g) = NULL;
+    }
+    free_aux_graph(g);
     dot_cleanup_graph(g);
 }
 
@@ -278,13 +284,43 @@ attach_phase_attrs (Agraph_t * g, int maxphase)
     }
 }
 
+/* isLarge:
+ * Should dot trade layout quality for speed on g? This is so if largemode
+ * is true, or a number no larger than the count of nodes and edges of g.
+ */
+static bool isLarge(Agraph_t * g)
+{
+    char *s = agget(g, "largemode");
+    char *end;
+    long threshold;
+
+    if (!s || *s == '\0')
+	return false;
+    threshold = strtol(s, &end, 10);
+    if (end == s)
+	return mapbool(s);
+    return agnnodes(g) + agnedges(g) >= threshold;
+}
+
 static void dotLayout(Agraph_t * g)
 {
     aspect_t aspect;
     aspect_t* asp;
     int maxphase = late_int(g, agfindgraphattr(g,"phase"), -1, 1);
 
-    setEdgeType (g, EDGETYPE_SPLINE);
+    if (isLarge(g)) {
+	/* cheaper defaults, each giving way to the attribute if it is set */
+	GD_flags(g) |= LARGE_GRAPH;
+	setEdgeType (g, EDGETYPE_LINE);
+	if (Verbose) {
+	    fprintf(stderr, "dot %s: large graph mode for %d nodes, %d edges\n",
+		    agnameof(g), agnnodes(g), agnedges(g));
+	    if (agget(g, "splines") == NULL)
+		fprintf(stderr, "dot %s: large graph, drawing long edges as lines\n",
+			agnameof(g));
+	}
+    } else
+	setEdgeType (g, EDGETYPE_SPLINE);
     asp = setAspect (g, &aspect);
 
     dot_init_subg(g,g);
@@ -16,10 +16,14 @@ extern "C" {
 
 #include <dotgen/aspect.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+    typedef struct mincross_state_s mincross_state_t;
 
     extern void acyclic(Agraph_t *);
     extern void allocate_ranks(Agraph_t *);
-    extern void build_ranks(Agraph_t *, int);
+    extern void *aux_alloc(Agraph_t *, size_t);
+    extern void build_ranks(mincross_state_t *, Agraph_t *, int);
     extern void build_skeleton(Agraph_t *, Agraph_t *);
     extern void checkLabelOrder (graph_t* g);
     extern void class1(Agraph_t *);
@@ -33,16 +37,18 @@ extern "C" {
     extern void dot_init_node_edge(graph_t * g);
     extern void dot_scan_ranks(graph_t * g);
     extern void enqueue_neighbors(nodequeue * q, node_t * n0, int pass);
-    extern void expand_cluster(Agraph_t *);
+    extern void expand_cluster(mincross_state_t *, Agraph_t *);
     extern Agedge_t *fast_edge(Agedge_t *);
     extern void fast_node(Agraph_t *, Agnode_t *);
     extern void fast_nodeapp(Agnode_t *, Agnode_t *);
     extern Agedge_t *find_fast_edge(Agnode_t *, Agnode_t *);
     extern Agedge_t *find_flat_edge(Agnode_t *, Agnode_t *);
+    extern void free_aux_graph(Agraph_t *);
     extern void flat_edge(Agraph_t *, Agedge_t *);
     extern int flat_edges(Agraph_t *);
-    extern void install_cluster(Agraph_t *, Agnode_t *, int, nodequeue *);
-    extern void install_in_rank(Agraph_t *, Agnode_t *);
+    extern void install_cluster(mincross_state_t *, Agraph_t *, Agnode_t *, int,
+                                nodequeue *);
+    extern void install_in_rank(mincross_state_t *, Agraph_t *, Agnode_t *);
     extern bool is_cluster(Agraph_t *);
     extern void dot_compoundEdges(Agraph_t *);
     extern Agedge_t *make_aux_edge(Agnode_t *, Agnode_t *, double, int);
@@ -51,7 +57,7 @@ extern "C" {
     extern int mergeable(edge_t * e, edge_t * f);
     extern void merge_chain(Agraph_t *, Agedge_t *, Agedge_t *, int);
     extern void merge_oneway(Agedge_t *, Agedge_t *);
-    extern int ncross(Agraph_t *);
+    extern int ncross(mincross_state_t *);
     extern Agedge_t *new_virtual_edge(Agnode_t *, Agnode_t *, Agedge_t *);
     extern int nonconstraint_edge(Agedge_t *);
     extern void other_edge(Agedge_t *);
@@ -66,10 +72,12 @@ extern "C" {
     extern void unmerge_oneway(Agedge_t *);
     extern Agedge_t *virtual_edge(Agnode_t *, Agnode_t *, Agedge_t *);
     extern Agnode_t *virtual_node(Agraph_t *);
+    extern Agnode_t *slack_node(Agraph_t *);
     extern void virtual_weight(Agedge_t *);
     extern void zapinlist(elist *, Agedge_t *);
 
     extern Agraph_t* dot_root(void *);
+    extern void dot_bk_xcoords(Agraph_t *);
     extern void dot_concentrate(Agraph_t *);
     extern void dot_mincross(Agraph_t *, int);
     extern void dot_position(Agraph_t *, aspect_t*);
@@ -15,8 +15,10 @@
 
 #include <assert.h>
 #include <cgraph/alloc.h>
+#include <cgraph/list.h>
 #include <common/boxes.h>
 #include <dotgen/dot.h>
+#include <dotgen/workers.h>
 #include <limits.h>
 #include <math.h>
 #include <stdbool.h>
@@ -61,22 +63,52 @@ typedef struct {
     boxf* Rank_box;
 } spline_info_t;
 
+/* a call of resize_vn to be made later */
+typedef struct {
+    node_t *vn;
+    int lx, cx, rx;
+} resize_t;
+
+DEFINE_LIST(resizes, resize_t)
+
+/* working state of a thread routing regular edges */
+typedef struct {
+    path *P;
+    route_context_t *ctx;
+    pointf *pointfs, *pointfs2;	/* spline points of the current edge */
+    int numpts, numpts2;
+    /* If non-NULL, other threads are routing at the same time. Virtual
+     * nodes are then not resized by recover_slack, which would change the
+     * space seen by the other threads, but the resizing is recorded here to
+     * be done once all edges are routed.
+     */
+    resizes_t *deferred;
+} router_t;
+
+/* a group of equivalent edges, edges[ind] to edges[ind + cnt - 1] */
+typedef struct {
+    int ind, cnt;
+} edge_group_t;
+
+DEFINE_LIST(edge_groups, edge_group_t)
+
 static void adjustregularpath(path *, int, int);
 static Agedge_t *bot_bound(Agedge_t *, int);
 static bool pathscross(Agnode_t *, Agnode_t *, Agedge_t *, Agedge_t *);
 static Agraph_t *cl_bound(graph_t*, Agnode_t *, Agnode_t *);
 static bool cl_vninside(Agraph_t *, Agnode_t *);
 static void completeregularpath(path *, Agedge_t *, Agedge_t *,
-				pathend_t *, pathend_t *, boxf *, int, int);
+				pathend_t *, pathend_t *, boxf *, int, int,
+				bool);
 static int edgecmp(Agedge_t **, Agedge_t **);
 static void make_flat_edge(graph_t*, spline_info_t*, path *, Agedge_t **, int, int, int);
-static void make_regular_edge(graph_t* g, spline_info_t*, path *, Agedge_t **, int, int, int);
+static void make_regular_edge(graph_t* g, spline_info_t*, router_t *, Agedge_t **, int, int, int);
 static boxf makeregularend(boxf, int, double);
 static boxf maximal_bbox(graph_t* g, spline_info_t*, Agnode_t *, Agedge_t *, Agedge_t *);
 static Agnode_t *neighbor(graph_t*, Agnode_t *, Agedge_t *, Agedge_t *, int);
 static void place_vnlabel(Agnode_t *);
 static boxf rank_box(spline_info_t* sp, Agraph_t *, int);
-static void recover_slack(Agedge_t *, path *);
+static void recover_slack(Agedge_t *, path *, resizes_t *);
 static void resize_vn(Agnode_t *, int, int, int);
 static void setflags(Agedge_t *, int, int, int);
 static int straight_len(Agnode_t *);
@@ -253,6 +285,81 @@ setEdgeLabelPos (graph_t * g)
     }
 }
 
+typedef struct {
+    graph_t *g;
+    spline_info_t *sp;
+    edge_t **edges;
+    int et;
+    size_t nboxes;		/* capacity of each thread's path */
+    const edge_groups_t *groups;
+    size_t nchunks;
+    resizes_t *deferred;	/* resizes of each chunk of groups */
+} regular_job_t;
+
+/* route_regular_chunk:
+ * Route one of the ranges into which route_regular splits the edge groups.
+ */
+static void route_regular_chunk(void *arg, size_t chunk)
+{
+    regular_job_t *job = arg;
+    size_t n = edge_groups_size(job->groups);
+    path P = {.boxes = gv_calloc(job->nboxes, sizeof(boxf))};
+    router_t rt = {.P = &P, .ctx = route_context_new(),
+		   .deferred = &job->deferred[chunk]};
+
+    for (size_t i = n * chunk / job->nchunks;
+	 i < n * (chunk + 1) / job->nchunks; i++) {
+	const edge_group_t grp = edge_groups_get(job->groups, i);
+	make_regular_edge(job->g, job->sp, &rt, job->edges, grp.ind, grp.cnt,
+			  job->et);
+    }
+
+    dot_lock(); /* route_context_free updates global statistics */
+    route_context_free(rt.ctx);
+    dot_unlock();
+    free(rt.pointfs);
+    free(rt.pointfs2);
+    free(P.boxes);
+}
+
+/* route_regular:
+ * Route the given groups of regular edges using up to nthreads threads.
+ * All routes see the virtual nodes as positioned before routing; the
+ * slack each route leaves around its virtual nodes is recovered afterwards,
+ * in the order of the groups. The result thus does not depend on the
+ * number of threads, though it may differ from routing the edges one
+ * after the other.
+ */
+static void route_regular(graph_t *g, spline_info_t *sp, edge_t **edges,
+			  const edge_groups_t *groups, int et, int nthreads,
+			  size_t nboxes)
+{
+    size_t n = edge_groups_size(groups);
+    if (n == 0)
+	return;
+
+    /* fill in the rank boxes, which rank_box otherwise computes lazily */
+    for (int r = GD_minrank(g); r < GD_maxrank(g); r++)
+	rank_box(sp, g, r);
+
+    regular_job_t job = {.g = g, .sp = sp, .edges = edges, .et = et,
+			 .nboxes = nboxes, .groups = groups};
+    /* several chunks per thread to even out the load */
+    job.nchunks = MIN(n, (size_t)nthreads * 8);
+    job.deferred = gv_calloc(job.nchunks, sizeof(resizes_t));
+
+    dot_parallel_for(nthreads, job.nchunks, route_regular_chunk, &job);
+
+    for (size_t c = 0; c < job.nchunks; c++) {
+	for (size_t i = 0; i < resizes_size(&job.deferred[c]); i++) {
+	    const resize_t r = resizes_get(&job.deferred[c], i);
+	    resize_vn(r.vn, r.lx, r.cx, r.rx);
+	}
+	resizes_free(&job.deferred[c]);
+    }
+    free(job.deferred);
+}
+
 /* _dot_splines:
  * Main spline routing code.
  * The normalize parameter allows this function to be called by the
@@ -268,8 +375,15 @@ static void _dot_splines(graph_t * g, int normalize)
     Agedgepair_t fwdedgea, fwdedgeb;
     edge_t *e, *e0, *e1, *ea, *eb, *le0, *le1, **edges = NULL;
     path P = {0};
+    router_t R = {.P = &P};
+    edge_groups_t regular = {0};
     spline_info_t sd;
     int et = EDGE_TYPE(g);
+    /* With more than one thread, regular edges are routed after all others,
+     * concurrently. The layout must not depend on whether threads are
+     * actually available, so this is decided on the requested number alone.
+     */
+    int nthreads = dot_threads(g);
     fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
     fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
 
@@ -297,6 +411,7 @@ static void _dot_splines(graph_t * g, int normalize)
 
     mark_lowclusters(g);
     if (routesplinesinit()) return;
+    R.ctx = route_context_new();
     /* FlatHeight = 2 * GD_nodesep(g); */
     sd.Splinesep = GD_nodesep(g) / 4;
     sd.Multisep = GD_nodesep(g);
@@ -458,10 +573,16 @@ static void _dot_splines(graph_t * g, int normalize)
 	else if (ND_rank(agtail(e0)) == ND_rank(aghead(e0))) {
 	    make_flat_edge(g, &sd, &P, edges, ind, cnt, et);
 	}
+	else if (nthreads > 1)
+	    edge_groups_append(&regular, (edge_group_t){ind, cnt});
 	else
-	    make_regular_edge(g, &sd, &P, edges, ind, cnt, et);
+	    make_regular_edge(g, &sd, &R, edges, ind, cnt, et);
     }
 
+    route_regular(g, &sd, edges, &regular, et, nthreads,
+		  n_nodes + 20 * 2 * NSUB);
+    edge_groups_free(&regular);
+
     /* place regular edge labels */
     for (n = GD_nlist(g); n; n = ND_next(n)) {
 	if (ND_node_type(n) == VIRTUAL && ND_label(n)) {
@@ -502,6 +623,9 @@ finish :
     }
     /* end vladimir */
 
+    free(R.pointfs);
+    free(R.pointfs2);
+    route_context_free(R.ctx);
 #ifdef ORTHO
     if (et != EDGETYPE_ORTHO && et != EDGETYPE_CURVED)  {
 #else
@@ -1755,13 +1879,29 @@ makeLineEdge(graph_t* g, edge_t* fe, pointf* points, node_t** hp)
     return pn;
 }
 
+/* install_spline:
+ * Clip the spline to the end nodes and attach it to the edge. Clipping
+ * consults shape data and attributes that are not safe to access from
+ * several threads at once.
+ */
+static void install_spline(router_t *rt, edge_t *fe, node_t *hn, pointf *ps,
+			   int pn)
+{
+    if (rt->deferred)
+	dot_lock();
+    clip_and_install(fe, hn, ps, pn, &sinfo);
+    if (rt->deferred)
+	dot_unlock();
+}
+
 #define NUMPTS 2000
 
 /* make_regular_edge:
  */
 static void
-make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int ind, int cnt, int et)
+make_regular_edge(graph_t* g, spline_info_t* sp, router_t *rt, edge_t ** edges, int ind, int cnt, int et)
 {
+    path *P = rt->P;
     node_t *tn, *hn;
     Agedgeinfo_t fwdedgeai, fwdedgebi, fwdedgei;
     Agedgepair_t fwdedgea, fwdedgeb, fwdedge;
@@ -1769,22 +1909,20 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
     pathend_t tend, hend;
     boxf b;
     int sl, si, smode, i, j, dx, hackflag, longedge;
-    static pointf* pointfs;
-    static pointf* pointfs2;
-    static int numpts;
-    static int numpts2;
     int pointn;
 
     fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
     fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
     fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
 
-    if (!pointfs) {
-	pointfs = gv_calloc(NUMPTS, sizeof(pointf));
-   	pointfs2 = gv_calloc(NUMPTS, sizeof(pointf));
-	numpts = NUMPTS;
-	numpts2 = NUMPTS;
+    if (!rt->pointfs) {
+	rt->pointfs = gv_calloc(NUMPTS, sizeof(pointf));
+	rt->pointfs2 = gv_calloc(NUMPTS, sizeof(pointf));
+	rt->numpts = NUMPTS;
+	rt->numpts2 = NUMPTS;
     }
+    pointf *pointfs = rt->pointfs;
+    pointf *pointfs2 = rt->pointfs2;
     sl = 0;
     e = edges[ind];
     hackflag = FALSE;
@@ -1869,12 +2007,12 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    P->end.theta = M_PI / 2, P->end.constrained = true;
 	    assert(boxes.size <= (size_t)INT_MAX && "integer overflow");
 	    completeregularpath(P, segfirst, e, &tend, &hend, boxes.data,
-	                        (int)boxes.size, 1);
+	                        (int)boxes.size, 1, rt->deferred != NULL);
 	    pointf *ps = NULL;
 	    int pn = 0;
-	    if (is_spline) ps = routesplines(P, &pn);
+	    if (is_spline) ps = routesplines_r(rt->ctx, P, &pn);
 	    else {
-		ps = routepolylines (P, &pn);
+		ps = routepolylines_r(rt->ctx, P, &pn);
 		if (et == EDGETYPE_LINE && pn > 4) {
 		    ps[1] = ps[0];
 		    ps[3] = ps[2] = ps[pn-1];
@@ -1887,19 +2025,19 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	        return;
 	    }
 	
-	    if (pointn + pn > numpts) {
+	    if (pointn + pn > rt->numpts) {
                 /* This should be enough to include 3 extra points added by
                  * straight_path below.
                  */
-		numpts = 2*(pointn+pn); 
-		pointfs = RALLOC(numpts, pointfs, pointf);
+		rt->numpts = 2*(pointn+pn); 
+		pointfs = rt->pointfs = RALLOC(rt->numpts, pointfs, pointf);
 	    }
 	    for (i = 0; i < pn; i++) {
 		pointfs[pointn++] = ps[i];
 	    }
 	    free(ps);
 	    e = straight_path(ND_out(hn).list[0], sl, pointfs, &pointn);
-	    recover_slack(segfirst, P);
+	    recover_slack(segfirst, P, rt->deferred);
 	    segfirst = e;
 	    tn = agtail(e);
 	    hn = aghead(e);
@@ -1925,12 +2063,12 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    hend.boxes[hend.boxn++] = b;
 	assert(boxes.size <= (size_t)INT_MAX && "integer overflow");
 	completeregularpath(P, segfirst, e, &tend, &hend, boxes.data, (int)boxes.size,
-	                    longedge);
+	                    longedge, rt->deferred != NULL);
 	boxes_free(&boxes);
 	pointf *ps = NULL;
 	int pn = 0;
-	if (is_spline) ps = routesplines(P, &pn);
-	else ps = routepolylines (P, &pn);
+	if (is_spline) ps = routesplines_r(rt->ctx, P, &pn);
+	else ps = routepolylines_r(rt->ctx, P, &pn);
 	if (et == EDGETYPE_LINE && pn > 4) {
 	    /* Here we have used the polyline case to handle
 	     * an edge between two nodes on adjacent ranks. If the
@@ -1944,35 +2082,35 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    free(ps);
 	    return;
 	}
-	if (pointn + pn > numpts) {
-	    numpts = 2*(pointn+pn); 
-	    pointfs = RALLOC(numpts, pointfs, pointf);
+	if (pointn + pn > rt->numpts) {
+	    rt->numpts = 2*(pointn+pn); 
+	    pointfs = rt->pointfs = RALLOC(rt->numpts, pointfs, pointf);
 	}
 	for (i = 0; i < pn; i++) {
 	    pointfs[pointn++] = ps[i];
 	}
 	free(ps);
-	recover_slack(segfirst, P);
+	recover_slack(segfirst, P, rt->deferred);
 	hn = hackflag ? aghead(&fwdedgeb.out) : aghead(e);
     }
 
     /* make copies of the spline points, one per multi-edge */
 
     if (cnt == 1) {
-	clip_and_install(fe, hn, pointfs, pointn, &sinfo);
+	install_spline(rt, fe, hn, pointfs, pointn);
 	return;
     }
     dx = sp->Multisep * (cnt - 1) / 2;
     for (i = 1; i < pointn - 1; i++)
 	pointfs[i].x -= dx;
 
-    if (numpts > numpts2) {
-	numpts2 = numpts; 
-	pointfs2 = RALLOC(numpts2, pointfs2, pointf);
+    if (rt->numpts > rt->numpts2) {
+	rt->numpts2 = rt->numpts; 
+	pointfs2 = rt->pointfs2 = RALLOC(rt->numpts2, pointfs2, pointf);
     }
     for (i = 0; i < pointn; i++)
 	pointfs2[i] = pointfs[i];
-    clip_and_install(fe, hn, pointfs2, pointn, &sinfo);
+    install_spline(rt, fe, hn, pointfs2, pointn);
     for (j = 1; j < cnt; j++) {
 	e = edges[ind + j];
 	if (ED_tree_index(e) & BWDEDGE) {
@@ -1983,7 +2121,7 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    pointfs[i].x += sp->Multisep;
 	for (i = 0; i < pointn; i++)
 	    pointfs2[i] = pointfs[i];
-	clip_and_install(e, aghead(e), pointfs2, pointn, &sinfo);
+	install_spline(rt, e, aghead(e), pointfs2, pointn);
     }
 }
 
@@ -1994,7 +2132,7 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 static void
 completeregularpath(path * P, edge_t * first, edge_t * last,
 		    pathend_t * tendp, pathend_t * hendp, boxf * boxes,
-		    int boxn, int flag)
+		    int boxn, int flag, bool concurrent)
 {
     // this implementation of completeregularpath ignores the flag
     (void)flag;
@@ -2005,7 +2143,10 @@ completeregularpath(path * P, edge_t * first, edge_t * last,
 
     fb = lb = -1;
     uleft = uright = NULL;
-    uleft = top_bound(first, -1), uright = top_bound(first, 1);
+    /* the splines of neighboring edges may be in the making on other
+     * threads, so they can only be checked when routing one edge at a time */
+    if (!concurrent)
+	uleft = top_bound(first, -1), uright = top_bound(first, 1);
     if (uleft) {
 	if (!(spl = getsplinepoints(uleft))) return;
     }
@@ -2013,7 +2154,8 @@ completeregularpath(path * P, edge_t * first, edge_t * last,
 	if (!(spl = getsplinepoints(uright))) return;
     }
     lleft = lright = NULL;
-    lleft = bot_bound(last, -1), lright = bot_bound(last, 1);
+    if (!concurrent)
+	lleft = bot_bound(last, -1), lright = bot_bound(last, 1);
     if (lleft) {
 	if (!(spl = getsplinepoints(lleft))) return;
     }
@@ -2038,7 +2180,7 @@ void refineregularends(edge_t * left, edge_t * right, pathend_t * endp,
 static void
 completeregularpath(path * P, edge_t * first, edge_t * last,
 		    pathend_t * tendp, pathend_t * hendp, boxf * boxes,
-		    int boxn, int flag)
+		    int boxn, int flag, bool concurrent)
 {
     edge_t *uleft, *uright, *lleft, *lright;
     boxf uboxes[NSUB], lboxes[NSUB];
@@ -2047,11 +2189,13 @@ completeregularpath(path * P, edge_t * first, edge_t * last,
 
     fb = lb = -1;
     uleft = uright = NULL;
-    if (flag || ND_rank(agtail(first)) + 1 != ND_rank(aghead(last)))
+    if (!concurrent
+	&& (flag || ND_rank(agtail(first)) + 1 != ND_rank(aghead(last))))
 	uleft = top_bound(first, -1), uright = top_bound(first, 1);
     refineregularends(uleft, uright, tendp, 1, boxes[0], uboxes, &uboxn);
     lleft = lright = NULL;
-    if (flag || ND_rank(agtail(first)) + 1 != ND_rank(aghead(last)))
+    if (!concurrent
+	&& (flag || ND_rank(agtail(first)) + 1 != ND_rank(aghead(last))))
 	lleft = bot_bound(last, -1), lright = bot_bound(last, 1);
     refineregularends(lleft, lright, hendp, -1, boxes[boxn - 1], lboxes,
 		      &lboxn);
@@ -2307,7 +2451,7 @@ static edge_t *straight_path(edge_t * e, int cnt, pointf * plist, int *np)
     return f;
 }
 
-static void recover_slack(edge_t * e, path * p)
+static void recover_slack(edge_t * e, path * p, resizes_t *deferred)
 {
     int b;
     node_t *vn;
@@ -2322,13 +2466,18 @@ static void recover_slack(edge_t * e, path * p)
 	    break;
 	if (p->boxes[b].UR.y < ND_coord(vn).y)
 	    continue;
-	if (ND_label(vn))
-	    resize_vn(vn, p->boxes[b].LL.x, p->boxes[b].UR.x,
-		      p->boxes[b].UR.x + ND_rw(vn));
+	resize_t r = {.vn = vn, .lx = p->boxes[b].LL.x};
+	if (ND_label(vn)) {
+	    r.cx = p->boxes[b].UR.x;
+	    r.rx = p->boxes[b].UR.x + ND_rw(vn);
+	} else {
+	    r.cx = (p->boxes[b].LL.x + p->boxes[b].UR.x) / 2;
+	    r.rx = p->boxes[b].UR.x;
+	}
+	if (deferred)
+	    resizes_append(deferred, r);
 	else
-	    resize_vn(vn, p->boxes[b].LL.x, (p->boxes[b].LL.x +
-					     p->boxes[b].UR.x) / 2,
-		      p->boxes[b].UR.x);
+	    resize_vn(vn, r.lx, r.cx, r.rx);
     }
 }
 
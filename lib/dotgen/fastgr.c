@@ -8,6 +8,8 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <cgraph/alloc.h>
+#include <cgraph/arena.h>
 #include <cgraph/unused.h>
 #include <dotgen/dot.h>
 #include <stdbool.h>
@@ -236,36 +238,91 @@ void delete_fast_node(graph_t * g, node_t * n)
 	GD_nlist(g) = ND_next(n);
 }
 
-static node_t *named_virtual_node(graph_t * g, char *s)
+/* a virtual node together with its layout record */
+typedef struct {
+    node_t node;
+    Agnodeinfo_t info;
+} vnode_t;
+
+static node_t *init_virtual_node(graph_t * g, vnode_t * vn)
 {
-    node_t *n;
+    node_t *n = &vn->node;
 
-    n = NEW(node_t);
     AGTYPE(n) = AGNODE;
-    n->base.data = (Agrec_t*)NEW(Agnodeinfo_t);
+    n->base.data = (Agrec_t*)&vn->info;
     n->root = agroot(g);
     ND_node_type(n) = VIRTUAL;
     ND_lw(n) = ND_rw(n) = 1;
     ND_ht(n) = 1;
     ND_UF_size(n) = 1;
-    if (s) ND_alg(n) = s;
-    alloc_elist(4, ND_in(n));
-    alloc_elist(4, ND_out(n));
+    /* lists grow one edge at a time, so there is no point reserving room */
+    alloc_elist(0, ND_in(n));
+    alloc_elist(0, ND_out(n));
     fast_node(g, n);
     GD_n_nodes(g)++;
     return n;
 }
 
+/* virtual_node:
+ * Virtual nodes are carved out of an arena kept on the root graph, as
+ * there may be many of them for long edges, and they are all released
+ * together by dot_cleanup.
+ */
 node_t *virtual_node(graph_t * g)
 {
-  return named_virtual_node(g,0);
+    graph_t *root = agroot(g);
+
+    if (!GD_vnodes(root))
+	GD_vnodes(root) = gv_alloc(sizeof(arena_t));
+    return init_virtual_node(g, arena_alloc(GD_vnodes(root), sizeof(vnode_t)));
+}
+
+/* aux_alloc:
+ * Nodes and edges of the auxiliary graphs that constrain ranking and x
+ * coordinate assignment are carved out of an arena kept on the root graph,
+ * as there may be millions of them for large graphs with clusters. They
+ * are all released together by free_aux_graph.
+ */
+void *aux_alloc(graph_t * g, size_t size)
+{
+    graph_t *root = agroot(g);
+
+    if (!GD_auxarena(root))
+	GD_auxarena(root) = gv_alloc(sizeof(arena_t));
+    return arena_alloc(GD_auxarena(root), size);
+}
+
+void free_aux_graph(graph_t * g)
+{
+    graph_t *root = agroot(g);
+
+    if (GD_auxarena(root)) {
+	arena_reset(GD_auxarena(root));
+	free(GD_auxarena(root));
+	GD_auxarena(root) = NULL;
+    }
+}
+
+/* slack_node:
+ * Nodes of the auxiliary graph of x coordinate assignment only live
+ * until remove_aux_edges, which releases them with free_aux_graph.
+ */
+node_t *slack_node(graph_t * g)
+{
+    node_t *n = init_virtual_node(g, aux_alloc(g, sizeof(vnode_t)));
+    ND_node_type(n) = SLACKNODE;
+    return n;
 }
 
 void flat_edge(graph_t * g, edge_t * e)
 {
     elist_append(e, ND_flat_out(agtail(e)));
     elist_append(e, ND_flat_in(aghead(e)));
-    GD_has_flat_edges(dot_root(g)) = GD_has_flat_edges(g) = true;
+    /* only store when needed; mincross may reach here from several threads */
+    if (!GD_has_flat_edges(g))
+	GD_has_flat_edges(g) = true;
+    if (!GD_has_flat_edges(dot_root(g)))
+	GD_has_flat_edges(dot_root(g)) = true;
 }
 
 void delete_flat_edge(edge_t * e)
@@ -17,10 +17,14 @@
  */
 
 #include <assert.h>
+#include <cgraph/alloc.h>
 #include <cgraph/cgraph.h>
 #include <cgraph/exit.h>
+#include <dotgen/clustcache.h>
 #include <dotgen/dot.h>
+#include <dotgen/workers.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,24 +33,99 @@
 #define MARK(v)		(ND_mark(v))
 #define saveorder(v)	(ND_coord(v)).x
 #define flatindex(v)	ND_low(v)
+#define LARGE_SWEEPS	2	/* transpose sweeps in large graph mode */
+#define PAR_WIDTH	1024	/* nodes of a rank worth spreading over threads */
+#define PAR_CHUNK	256	/* nodes per job of parallel medians */
+
+/* far end of an edge, as seen when counting crossings */
+typedef struct {
+    int order;			/* order of the far endpoint */
+    double port;		/* port x coordinate at the far endpoint */
+    int weight;			/* crossing penalty of the edge */
+} endpoint_t;
+
+/* sorted endpoints of the in and out edges of one node */
+typedef struct {
+    int in, nin;		/* offset and count of in edge endpoints */
+    int out, nout;		/* offset and count of out edge endpoints */
+} endpoints_t;
+
+/* scratch space of rank_endpoints */
+typedef struct {
+    endpoint_t *ep;		/* sorted endpoints of the rank */
+    int nep;			/* allocated size of ep */
+    endpoints_t *eps;		/* per position index into ep */
+    int neps;			/* allocated size of eps */
+} endpoint_scratch_t;
+
+/* State of one crossing minimization run.
+ * The root graph is ordered using a single instance of this. When connected
+ * components are ordered concurrently, each component gets its own instance
+ * whose rank arrays are private until they are merged back into the root.
+ */
+struct mincross_state_s {
+    graph_t *Root;		/* graph owning the global rank structure */
+    rank_t *rank;		/* rank arrays in use for Root */
+    node_t *nlist;		/* fast node list of the component being ordered */
+    adjmatrix_t **stash;	/* flat matrices of components ordered earlier */
+
+	/* mincross parameters */
+    int MinQuit;
+    int MaxIter;
+    double Convergence;
+    int Starts;			/* initial orders tried, see mincross_starts */
+    int MaxSweeps;		/* sweeps of one transpose, 0 if unbounded */
+    unsigned Seed;		/* shuffles build_ranks if nonzero */
+    double Deadline;		/* wall_sec() at which to stop, 0 if none */
+    bool TimedOut;		/* Deadline was reached */
+    Agsym_t *SeedPos;		/* node pos to seed orders from, see seed_ranks */
+    Agsym_t *SeedEdgePos;	/* edge pos to place virtual nodes by */
+    int SeedRankdir;		/* rankdir the positions were laid out with */
+    bool Seeded;		/* the last build_ranks took order from pos */
+
+    int GlobalMinRank, GlobalMaxRank;
+    bool ReMincross;
+    edge_t **TE_list;
+    int *TI_list;
+    int *Count;			/* scratch counts for rcross() */
+    int C;			/* allocated size of Count */
+    endpoint_scratch_t sc;	/* scratch endpoints for transpose_step() */
+    int Threads;		/* threads spent on ranks of PAR_WIDTH nodes */
+    bool locked;		/* serialize cgraph lookups with other threads */
+    graph_t *Clust;		/* if set, ncross only counts what its order affects */
+};
+
+/* rank arrays of g as seen by st */
+#define RANK(st,g)	((g) == (st)->Root ? (st)->rank : GD_rank(g))
 
 	/* forward declarations */
-static bool medians(graph_t * g, int r0, int r1);
+static bool medians(mincross_state_t * st, graph_t * g, int r0, int r1);
 static int nodeposcmpf(node_t ** n0, node_t ** n1);
 static int edgeidcmpf(edge_t ** e0, edge_t ** e1);
-static void flat_breakcycles(graph_t * g);
-static void flat_reorder(graph_t * g);
-static void flat_search(graph_t * g, node_t * v);
-static void init_mincross(graph_t * g);
-static void merge2(graph_t * g);
-static void init_mccomp(graph_t * g, int c);
-static void cleanup2(graph_t * g, int nc);
-static int mincross_clust(graph_t * g, int);
-static int mincross(graph_t * g, int startpass, int endpass, int);
-static void mincross_step(graph_t * g, int pass);
-static void mincross_options(graph_t * g);
-static void save_best(graph_t * g);
-static void restore_best(graph_t * g);
+static void flat_breakcycles(mincross_state_t * st, graph_t * g);
+static void flat_reorder(mincross_state_t * st, graph_t * g);
+static void flat_search(mincross_state_t * st, graph_t * g, node_t * v);
+static void init_mincross(mincross_state_t * st, graph_t * g);
+static void merge2(mincross_state_t * st, graph_t * g);
+static void init_mccomp(mincross_state_t * st, graph_t * g, int c);
+static void cleanup2(mincross_state_t * st, graph_t * g, int nc);
+static void scratch_free(endpoint_scratch_t * sc);
+static int mincross_clust(mincross_state_t * st, graph_t * g, int);
+static int mincross_clusters(mincross_state_t * st, graph_t * g, int);
+static int mincross(mincross_state_t * st, graph_t * g, int startpass,
+		    int endpass, int);
+static int mincross_starts(mincross_state_t * st, graph_t * g, int doBalance);
+static void flat_make_lr(mincross_state_t * st, graph_t * g, int r);
+static void save_clust_order(mincross_state_t * st, graph_t * g,
+			     clust_entry_t * ent);
+static bool restore_clust_order(mincross_state_t * st, graph_t * g,
+				const clust_entry_t * ent);
+static void mincross_step(mincross_state_t * st, graph_t * g, int pass);
+static bool out_of_time(mincross_state_t * st);
+static bool seed_ranks(mincross_state_t * st, graph_t * g, node_t * nlist);
+static void mincross_options(mincross_state_t * st, graph_t * g);
+static void save_best(mincross_state_t * st, graph_t * g);
+static void restore_best(mincross_state_t * st, graph_t * g);
 static adjmatrix_t *new_matrix(int i, int j);
 static void free_matrix(adjmatrix_t * p);
 static int ordercmpf(int *i0, int *i1);
@@ -58,22 +137,11 @@ static rank_t *gd_rank(Agraph_t *g, int r) {return &GD_rank(g)[r];}
 static int nd_order(Agnode_t *v) { return ND_order(v); }
 #endif
 void check_rs(graph_t * g, int null_ok);
-void check_order(void);
+void check_order(graph_t * g);
 void check_vlists(graph_t * g);
 void node_in_root_vlist(node_t * n);
 #endif
 
-
-	/* mincross parameters */
-static int MinQuit;
-static double Convergence;
-
-static graph_t *Root;
-static int GlobalMinRank, GlobalMaxRank;
-static edge_t **TE_list;
-static int *TI_list;
-static bool ReMincross;
-
 #if defined(DEBUG) && DEBUG > 1
 static void indent(graph_t* g)
 {
@@ -329,15 +397,172 @@ checkLabelOrder (graph_t* g)
     }
 }
 
+/* components_separable:
+ * Components can only be ordered in rank arrays of their own if the nodes
+ * build_ranks installs for a component are exactly those on its fast node
+ * list. Apart from ordinary and virtual nodes, the only nodes expected there
+ * are the rank leaders of collapsed clusters.
+ */
+static bool components_separable(graph_t * g)
+{
+    int c;
+    node_t *n;
+    graph_t *clust;
+
+    for (c = 0; c < GD_comp(g).size; c++) {
+	for (n = GD_comp(g).list[c]; n; n = ND_next(n)) {
+	    if (ND_ranktype(n) != CLUSTER)
+		continue;
+	    clust = ND_clust(n);
+	    if (!clust || !GD_rankleader(clust)
+		|| ND_rank(n) < GD_minrank(clust)
+		|| ND_rank(n) > GD_maxrank(clust)
+		|| GD_rankleader(clust)[ND_rank(n)] != n)
+		return false;
+	}
+    }
+    return true;
+}
+
+/* wide_component:
+ * Does some component of g have PAR_WIDTH nodes on one rank? Such ranks
+ * are better served by all threads in turn than by one thread each, see
+ * transpose_parallel.
+ */
+static bool wide_component(graph_t * g)
+{
+    int c, *count = gv_calloc((size_t)GD_maxrank(g) + 1, sizeof(int));
+    node_t *n;
+    bool wide = false;
+
+    for (c = 0; c < GD_comp(g).size && !wide; c++) {
+	for (n = GD_comp(g).list[c]; n; n = ND_next(n))
+	    if (++count[ND_rank(n)] >= PAR_WIDTH)
+		wide = true;
+	for (n = GD_comp(g).list[c]; n; n = ND_next(n))
+	    count[ND_rank(n)] = 0;
+    }
+    free(count);
+    return wide;
+}
+
+/* give cs, a state of its own for part of the work of st, st's options */
+static void inherit_options(mincross_state_t * cs, const mincross_state_t * st)
+{
+    cs->Root = st->Root;
+    cs->MinQuit = st->MinQuit;
+    cs->MaxIter = st->MaxIter;
+    cs->Convergence = st->Convergence;
+    cs->Starts = st->Starts;
+    cs->MaxSweeps = st->MaxSweeps;
+    cs->Deadline = st->Deadline;
+    cs->SeedPos = st->SeedPos;
+    cs->SeedEdgePos = st->SeedEdgePos;
+    cs->SeedRankdir = st->SeedRankdir;
+    cs->GlobalMinRank = st->GlobalMinRank;
+    cs->GlobalMaxRank = st->GlobalMaxRank;
+    cs->locked = true;
+}
+
+typedef struct {
+    mincross_state_t *st;	/* one state per component */
+    graph_t *g;
+    int doBalance;
+    int *nc;			/* crossings per component */
+} mccomp_job_t;
+
+static void mincross_comp_job(void *arg, size_t c)
+{
+    mccomp_job_t *job = arg;
+    job->nc[c] = mincross_starts(&job->st[c], job->g, job->doBalance);
+}
+
+/* mincross_components:
+ * Order the connected components of g concurrently, using up to nthreads
+ * threads. Each component is installed in rank arrays of its own, sized from
+ * its node list. Afterwards these are copied into the rank arrays of g in
+ * component order, which is exactly where the serial loop in dot_mincross
+ * would have installed them.
+ */
+static int mincross_components(mincross_state_t * st, graph_t * g,
+			       int nthreads, int doBalance)
+{
+    int r, nc, deg;
+    size_t c, ncomp = (size_t)GD_comp(g).size;
+    int minr = GD_minrank(g), maxr = GD_maxrank(g);
+    mincross_state_t *cst = gv_calloc(ncomp, sizeof(mincross_state_t));
+    int *cnc = gv_calloc(ncomp, sizeof(int));
+    int *off = gv_calloc((size_t)maxr + 2, sizeof(int));
+    node_t *n;
+
+    for (c = 0; c < ncomp; c++) {
+	mincross_state_t *cs = &cst[c];
+	inherit_options(cs, st);
+	cs->nlist = GD_comp(g).list[c];
+	cs->rank = gv_calloc((size_t)maxr + 2, sizeof(rank_t));
+	deg = 0;
+	for (n = cs->nlist; n; n = ND_next(n)) {
+	    cs->rank[ND_rank(n)].an++;
+	    deg = MAX(deg, MAX(ND_in(n).size, ND_out(n).size));
+	}
+	cs->TI_list = gv_calloc((size_t)deg + 1, sizeof(int));
+	for (r = minr; r <= maxr; r++)
+	    cs->rank[r].av = cs->rank[r].v =
+		gv_calloc((size_t)cs->rank[r].an + 1, sizeof(node_t *));
+    }
+
+    mccomp_job_t job = {.st = cst, .g = g, .doBalance = doBalance, .nc = cnc};
+    dot_parallel_for(nthreads, ncomp, mincross_comp_job, &job);
+
+    nc = 0;
+    for (c = 0; c < ncomp; c++) {
+	mincross_state_t *cs = &cst[c];
+	nc += cnc[c];
+	st->TimedOut |= cs->TimedOut;
+	for (r = minr; r <= maxr; r++) {
+	    rank_t *rk = &GD_rank(g)[r];
+	    rank_t *crk = &cs->rank[r];
+	    assert(off[r] + crk->n <= rk->an);
+	    rk->v = rk->av + off[r];
+	    rk->n = crk->n;
+	    memcpy(rk->v, crk->v, (size_t)crk->n * sizeof(node_t *));
+	    off[r] += crk->n;
+	    rk->valid = crk->valid;
+	    rk->cache_nc = crk->cache_nc;
+	    rk->candidate = crk->candidate;
+	    if (crk->flat) {
+		free_matrix(rk->flat);
+		rk->flat = crk->flat;
+	    }
+	    free(crk->av);
+	}
+	free(cs->rank);
+	free(cs->TI_list);
+	free(cs->Count);
+	scratch_free(&cs->sc);
+    }
+    GD_nlist(g) = GD_comp(g).list[ncomp - 1];
+
+    free(off);
+    free(cnc);
+    free(cst);
+    return nc;
+}
+
 /* dot_mincross:
  * Minimize edge crossings
  * Note that nodes are not placed into GD_rank(g) until mincross()
  * is called.
+ * If the threads attribute asks for it, the connected components of g are
+ * ordered concurrently. This yields the same ordering as the serial path.
+ * Components with ranks of PAR_WIDTH nodes are instead ordered one after
+ * the other, each spreading the work on its wide ranks over the threads.
  */
 void dot_mincross(graph_t * g, int doBalance)
 {
-    int c, nc;
+    int c, nc, nthreads;
     char *s;
+    mincross_state_t st = {0};
 
     /* check whether malformed input has led to empty cluster that the crossing
      * functions will not anticipate
@@ -356,34 +581,43 @@ void dot_mincross(graph_t * g, int doBalance)
 	}
     }
 
-    init_mincross(g);
+    init_mincross(&st, g);
 
-    for (nc = c = 0; c < GD_comp(g).size; c++) {
-	init_mccomp(g, c);
-	nc += mincross(g, 0, 2, doBalance);
+    st.Threads = nthreads = dot_threads(g);
+    if (nthreads > 1 && GD_comp(g).size > 1 && dot_parallel_available()
+	&& components_separable(g) && !wide_component(g)) {
+	nc = mincross_components(&st, g, nthreads, doBalance);
+    } else {
+	for (nc = c = 0; c < GD_comp(g).size; c++) {
+	    init_mccomp(&st, g, c);
+	    nc += mincross_starts(&st, g, doBalance);
+	}
     }
 
-    merge2(g);
+    merge2(&st, g);
 
     /* run mincross on contents of each cluster */
-    for (c = 1; c <= GD_n_cluster(g); c++) {
-	nc += mincross_clust(GD_clust(g)[c], doBalance);
+    nc += mincross_clusters(&st, g, doBalance);
 #ifdef DEBUG
+    for (c = 1; c <= GD_n_cluster(g); c++)
 	check_vlists(GD_clust(g)[c]);
-	check_order();
+    check_order(g);
 #endif
-    }
 
     if (GD_n_cluster(g) > 0 && (!(s = agget(g, "remincross")) || mapbool(s))) {
 	mark_lowclusters(g);
-	ReMincross = true;
-	nc = mincross(g, 2, 2, doBalance);
+	st.ReMincross = true;
+	st.Seeded = st.SeedPos != NULL;
+	nc = mincross(&st, g, 2, 2, doBalance);
 #ifdef DEBUG
 	for (c = 1; c <= GD_n_cluster(g); c++)
 	    check_vlists(GD_clust(g)[c]);
 #endif
     }
-    cleanup2(g, nc);
+    if (Verbose && st.TimedOut)
+	fprintf(stderr, "mincross %s: mctime exceeded, keeping best order found\n",
+		agnameof(g));
+    cleanup2(&st, g, nc);
 }
 
 static adjmatrix_t *new_matrix(int i, int j)
@@ -405,15 +639,27 @@ static void free_matrix(adjmatrix_t * p)
 
 #define ELT(M,i,j)		(M->data[((i)*M->ncols)+(j)])
 
-static void init_mccomp(graph_t * g, int c)
+/* init_mccomp:
+ * Set up the rank arrays for ordering component c of the root graph g.
+ * Flat edge matrices of earlier components are stashed away so they are not
+ * consulted for this one; merge2 puts them back.
+ */
+static void init_mccomp(mincross_state_t * st, graph_t * g, int c)
 {
     int r;
 
-    GD_nlist(g) = GD_comp(g).list[c];
+    st->nlist = GD_nlist(g) = GD_comp(g).list[c];
     if (c > 0) {
+	if (!st->stash)
+	    st->stash = gv_calloc((size_t)GD_maxrank(g) + 2, sizeof(adjmatrix_t *));
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	    GD_rank(g)[r].v = GD_rank(g)[r].v + GD_rank(g)[r].n;
 	    GD_rank(g)[r].n = 0;
+	    if (GD_rank(g)[r].flat) {
+		free_matrix(st->stash[r]);
+		st->stash[r] = GD_rank(g)[r].flat;
+		GD_rank(g)[r].flat = NULL;
+	    }
 	}
     }
 }
@@ -425,12 +671,12 @@ static int betweenclust(edge_t * e)
     return (ND_clust(agtail(e)) != ND_clust(aghead(e)));
 }
 
-static void do_ordering_node (graph_t * g, node_t* n, int outflag)
+static void do_ordering_node (mincross_state_t * st, graph_t * g, node_t* n, int outflag)
 {
     int i, ne;
     node_t *u, *v;
     edge_t *e, *f, *fe;
-    edge_t **sortlist = TE_list;
+    edge_t **sortlist = st->TE_list;
 
     if (ND_clust(n))
 	return;
@@ -466,17 +712,17 @@ static void do_ordering_node (graph_t * g, node_t* n, int outflag)
     }
 }
 
-static void do_ordering(graph_t * g, int outflag)
+static void do_ordering(mincross_state_t * st, graph_t * g, int outflag)
 {
     /* Order all nodes in graph */
     node_t *n;
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	do_ordering_node (g, n, outflag);
+	do_ordering_node (st, g, n, outflag);
     }
 }
 
-static void do_ordering_for_nodes(graph_t * g)
+static void do_ordering_for_nodes(mincross_state_t * st, graph_t * g)
 {
     /* Order nodes which have the "ordered" attribute */
     node_t *n;
@@ -485,9 +731,9 @@ static void do_ordering_for_nodes(graph_t * g)
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if ((ordering = late_string(n, N_ordering, NULL))) {
 	    if (streq(ordering, "out"))
-		do_ordering_node(g, n, TRUE);
+		do_ordering_node(st, g, n, TRUE);
 	    else if (streq(ordering, "in"))
-		do_ordering_node(g, n, FALSE);
+		do_ordering_node(st, g, n, FALSE);
 	    else if (ordering[0])
 		agerr(AGERR, "ordering '%s' not recognized for node '%s'.\n", ordering, agnameof(n));
 	}
@@ -501,7 +747,7 @@ static void do_ordering_for_nodes(graph_t * g)
  * Note that, in this implementation, the value of G_ordering
  * dominates the value of N_ordering.
  */
-static void ordered_edges(graph_t * g)
+static void ordered_edges(mincross_state_t * st, graph_t * g)
 {
     char *ordering;
 
@@ -509,9 +755,9 @@ static void ordered_edges(graph_t * g)
 	return;
     if ((ordering = late_string(g, G_ordering, NULL))) {
 	if (streq(ordering, "out"))
-	    do_ordering(g, TRUE);
+	    do_ordering(st, g, TRUE);
 	else if (streq(ordering, "in"))
-	    do_ordering(g, FALSE);
+	    do_ordering(st, g, FALSE);
 	else if (ordering[0])
 	    agerr(AGERR, "ordering '%s' not recognized.\n", ordering);
     }
@@ -522,36 +768,327 @@ static void ordered_edges(graph_t * g)
 	for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
 	    /* clusters are processed by separate calls to ordered_edges */
 	    if (!is_cluster(subg))
-		ordered_edges(subg);
+		ordered_edges(st, subg);
 	}
-	if (N_ordering) do_ordering_for_nodes (g);
+	if (N_ordering) do_ordering_for_nodes (st, g);
+    }
+}
+
+/* mincross_clust:
+ * If clustercache is set and g was ordered before with the same contents,
+ * its nodes are put in the recorded order instead of running mincross.
+ */
+static int mincross_clust(mincross_state_t * st, graph_t * g, int doBalance)
+{
+    int nc;
+    clust_entry_t *cached = NULL;
+    uint64_t key = 0;
+    bool caching = dot_cluster_cache_enabled(g);
+
+    if (caching) {
+	key = dot_cluster_hash(g);
+	cached = dot_cluster_cache(key, false);
+    }
+
+    expand_cluster(st, g);
+    ordered_edges(st, g);
+    flat_breakcycles(st, g);
+    flat_reorder(st, g);
+    if (cached && restore_clust_order(st, g, cached)) {
+	if (Verbose)
+	    fprintf(stderr, "mincross %s: reusing cached order\n", agnameof(g));
+	nc = ncross(st);
+    } else {
+	nc = mincross(st, g, 2, 2, doBalance);
+	if (caching)
+	    save_clust_order(st, g, dot_cluster_cache(key, true));
     }
+
+    nc += mincross_clusters(st, g, doBalance);
+
+    save_vlist(g);
+    return nc;
+}
+
+/* find the group of sibling c, see sibling_groups */
+static size_t sibling_find(size_t *parent, size_t c)
+{
+    while (parent[c] != c)
+	c = parent[c] = parent[parent[c]];
+    return c;
 }
 
-static int mincross_clust(graph_t * g, int doBalance)
+/* a cluster and its number among its siblings */
+typedef struct {
+    graph_t *g;
+    size_t c;
+} sibling_t;
+
+static int siblingcmpf(const void *x, const void *y)
 {
-    int c, nc;
+    const sibling_t *a = x, *b = y;
 
-    expand_cluster(g);
-    ordered_edges(g);
-    flat_breakcycles(g);
-    flat_reorder(g);
-    nc = mincross(g, 2, 2, doBalance);
+    return (a->g > b->g) - (a->g < b->g);
+}
 
-    for (c = 1; c <= GD_n_cluster(g); c++)
-	nc += mincross_clust(GD_clust(g)[c], doBalance);
+/* sibling_groups:
+ * Group the clusters of g that must be ordered one after the other, because
+ * the order of one changes which edges of another cross. That is the case
+ * for clusters joined by an edge, which while they are collapsed joins their
+ * rank leaders. Sets group[c] to the first cluster of the group of cluster
+ * c + 1, and returns the number of groups.
+ */
+static size_t sibling_groups(graph_t * g, size_t * group)
+{
+    size_t c, k, o, l, n = (size_t)GD_n_cluster(g), ngroups = 0;
+    sibling_t *sorted = gv_calloc(n, sizeof(sibling_t));
+    sibling_t key, *found;
+    int r, i;
+    node_t *v, *u;
+    edge_t *e;
+    graph_t *clust;
 
-    save_vlist(g);
+    for (c = 0; c < n; c++) {
+	group[c] = c;
+	sorted[c] = (sibling_t) {GD_clust(g)[c + 1], c};
+    }
+    qsort(sorted, n, sizeof(sibling_t), siblingcmpf);
+    for (c = 0; c < n; c++) {
+	clust = GD_clust(g)[c + 1];
+	for (r = GD_minrank(clust); r <= GD_maxrank(clust); r++) {
+	    if (!GD_rankleader(clust) || !(v = GD_rankleader(clust)[r]))
+		continue;
+	    elist *lists[] = {&ND_out(v), &ND_in(v), &ND_flat_out(v),
+			      &ND_flat_in(v)};
+	    for (l = 0; l < sizeof(lists) / sizeof(lists[0]); l++) {
+		for (i = 0; i < lists[l]->size; i++) {
+		    e = lists[l]->list[i];
+		    u = agtail(e) == v ? aghead(e) : agtail(e);
+		    key.g = ND_clust(u);
+		    if (!key.g || key.g == clust
+			|| !(found = bsearch(&key, sorted, n, sizeof(sibling_t),
+					     siblingcmpf)))
+			continue;
+		    k = sibling_find(group, c);
+		    o = sibling_find(group, found->c);
+		    if (o != k)
+			group[MAX(o, k)] = MIN(o, k);
+		}
+	    }
+	}
+    }
+    for (c = 0; c < n; c++) {
+	group[c] = sibling_find(group, c);
+	if (group[c] == c)
+	    ngroups++;
+    }
+    free(sorted);
+    return ngroups;
+}
+
+typedef struct {
+    mincross_state_t *st;	/* one state per cluster */
+    graph_t *g;			/* parent of the clusters */
+    int doBalance;
+    bool *restored;		/* per cluster, order taken from clustercache */
+    int *nc;			/* crossings per cluster */
+    size_t *members;		/* clusters by group, in order within each */
+    size_t *start;		/* per group, its first entry of members */
+} mcclust_job_t;
+
+static void mincross_clust_job(void *arg, size_t k)
+{
+    mcclust_job_t *job = arg;
+
+    for (size_t m = job->start[k]; m < job->start[k + 1]; m++) {
+	size_t c = job->members[m];
+	graph_t *clust = GD_clust(job->g)[c + 1];
+
+	if (job->restored[c])
+	    job->nc[c] = ncross(&job->st[c]);
+	else
+	    job->nc[c] = mincross(&job->st[c], clust, 2, 2, job->doBalance);
+    }
+}
+
+/* reset_vlist:
+ * Point the rank arrays of g back at its nodes, starting with those save_vlist
+ * recorded, after expanding other clusters has moved them.
+ */
+static void reset_vlist(graph_t * g)
+{
+    int r;
+
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	if (GD_rank(g)[r].n > 0)
+	    GD_rank(g)[r].v = GD_rank(dot_root(g))[r].v
+		+ ND_order(GD_rankleader(g)[r]);
+}
+
+/* mincross_siblings:
+ * Like mincross_clust on each cluster of g in turn, but with the groups of
+ * sibling_groups ordered concurrently, the clusters of a group one after the
+ * other. All clusters are expanded first. Each then runs mincross with a
+ * state of its own, whose rank arrays share the nodes with st but not the
+ * crossing counts, and which only counts the crossings its order affects,
+ * see rcross_clust. The result thus does not depend on the number of
+ * threads, but may differ from that of mincross_clust, whose counts include
+ * the rest of the graph. Expanding a cluster moves the nodes of others on
+ * its ranks, so their rank arrays are set again from the first node of each
+ * rank, as rec_reset_vlists does. Their own clusters follow, one cluster
+ * after the other.
+ */
+static int mincross_siblings(mincross_state_t * st, graph_t * g,
+			     const size_t * group, size_t ngroups,
+			     int doBalance)
+{
+    int r, nc = 0, deg, minr = GD_minrank(st->Root),
+	maxr = GD_maxrank(st->Root);
+    size_t c, n = (size_t)GD_n_cluster(g);
+    mincross_state_t *cst = gv_calloc(n, sizeof(mincross_state_t));
+    bool *restored = gv_calloc(n, sizeof(bool));
+    bool *caching = gv_calloc(n, sizeof(bool));
+    bool *seeded = gv_calloc(n, sizeof(bool));
+    uint64_t *key = gv_calloc(n, sizeof(uint64_t));
+    int *cnc = gv_calloc(n, sizeof(int));
+    size_t *members = gv_calloc(n, sizeof(size_t));
+    size_t *start = gv_calloc(ngroups + 1, sizeof(size_t));
+    size_t *jobof = gv_calloc(n, sizeof(size_t));
+    size_t k;
+    graph_t *clust;
+    node_t *v;
+
+    for (c = 0; c < n; c++) {
+	clust_entry_t *cached = NULL;
+
+	clust = GD_clust(g)[c + 1];
+	if ((caching[c] = dot_cluster_cache_enabled(clust))) {
+	    key[c] = dot_cluster_hash(clust);
+	    cached = dot_cluster_cache(key[c], false);
+	}
+	expand_cluster(st, clust);
+	ordered_edges(st, clust);
+	flat_breakcycles(st, clust);
+	flat_reorder(st, clust);
+	if (cached && restore_clust_order(st, clust, cached)) {
+	    if (Verbose)
+		fprintf(stderr, "mincross %s: reusing cached order\n",
+			agnameof(clust));
+	    restored[c] = true;
+	}
+	seeded[c] = st->Seeded;
+	save_vlist(clust);
+    }
+
+    for (c = 0; c < n; c++) {
+	mincross_state_t *cs = &cst[c];
+
+	clust = GD_clust(g)[c + 1];
+	reset_vlist(clust);
+	inherit_options(cs, st);
+	cs->Clust = clust;
+	cs->Seeded = seeded[c];
+	cs->rank = gv_calloc((size_t)maxr + 2, sizeof(rank_t));
+	memcpy(cs->rank, st->rank, ((size_t)maxr + 2) * sizeof(rank_t));
+	for (r = minr; r <= maxr; r++)
+	    cs->rank[r].valid = false;
+	deg = 0;
+	for (r = GD_minrank(clust); r <= GD_maxrank(clust); r++)
+	    for (int i = 0; i < GD_rank(clust)[r].n; i++) {
+		v = GD_rank(clust)[r].v[i];
+		deg = MAX(deg, MAX(ND_in(v).size, ND_out(v).size));
+	    }
+	cs->TI_list = gv_calloc((size_t)deg + 1, sizeof(int));
+    }
+
+    /* a job per group, numbered in order of their first clusters */
+    for (k = c = 0; c < n; c++)
+	if (group[c] == c)
+	    jobof[c] = k++;
+    for (c = 0; c < n; c++)
+	start[jobof[group[c]] + 1]++;
+    for (k = 0; k < ngroups; k++)
+	start[k + 1] += start[k];
+    for (c = 0; c < n; c++)
+	members[start[jobof[group[c]]]++] = c;
+    for (k = ngroups; k > 0; k--)
+	start[k] = start[k - 1];
+    start[0] = 0;
+
+    if (Verbose)
+	fprintf(stderr, "mincross %s: ordering %zu groups of clusters concurrently\n",
+		agnameof(g), ngroups);
+    mcclust_job_t job = {.st = cst, .g = g, .doBalance = doBalance,
+			 .restored = restored, .nc = cnc, .members = members,
+			 .start = start};
+    dot_parallel_for(st->Threads, ngroups, mincross_clust_job, &job);
+
+    for (c = 0; c < n; c++) {
+	mincross_state_t *cs = &cst[c];
+
+	clust = GD_clust(g)[c + 1];
+	st->TimedOut |= cs->TimedOut;
+	for (r = MAX(minr, GD_minrank(clust) - 1);
+	     r <= MIN(maxr, GD_maxrank(clust)); r++)
+	    st->rank[r].valid = false;
+	free(cs->rank);
+	free(cs->TI_list);
+	free(cs->Count);
+	scratch_free(&cs->sc);
+	if (caching[c] && !restored[c])
+	    save_clust_order(st, clust, dot_cluster_cache(key[c], true));
+	save_vlist(clust);
+    }
+    for (c = 0; c < n; c++) {
+	clust = GD_clust(g)[c + 1];
+	reset_vlist(clust);
+	nc += cnc[c] + mincross_clusters(st, clust, doBalance);
+	save_vlist(clust);
+    }
+
+    free(jobof);
+    free(start);
+    free(members);
+    free(cnc);
+    free(key);
+    free(seeded);
+    free(caching);
+    free(restored);
+    free(cst);
+    return nc;
+}
+
+/* mincross_clusters:
+ * Order the insides of the clusters of g, and so on down. If the threads
+ * attribute asks for it and some of them are not joined by edges, the
+ * clusters are ordered concurrently.
+ */
+static int mincross_clusters(mincross_state_t * st, graph_t * g,
+			     int doBalance)
+{
+    int c, nc = 0;
+
+    if (st->Threads > 1 && GD_n_cluster(g) > 1 && dot_parallel_available()) {
+	size_t *group = gv_calloc((size_t)GD_n_cluster(g), sizeof(size_t));
+	size_t ngroups = sibling_groups(g, group);
+	if (ngroups > 1)
+	    nc = mincross_siblings(st, g, group, ngroups, doBalance);
+	free(group);
+	if (ngroups > 1)
+	    return nc;
+    }
+    for (c = 1; c <= GD_n_cluster(g); c++)
+	nc += mincross_clust(st, GD_clust(g)[c], doBalance);
     return nc;
 }
 
-static int left2right(graph_t * g, node_t * v, node_t * w)
+static int left2right(mincross_state_t * st, graph_t * g, node_t * v, node_t * w)
 {
     adjmatrix_t *M;
     int rv;
 
     /* CLUSTER indicates orig nodes of clusters, and vnodes of skeletons */
-    if (!ReMincross) {
+    if (!st->ReMincross) {
 	if (ND_clust(v) != ND_clust(w) && ND_clust(v) && ND_clust(w)) {
 	    /* the following allows cluster skeletons to be swapped */
 	    if (ND_ranktype(v) == CLUSTER && ND_node_type(v) == VIRTUAL)
@@ -564,7 +1101,7 @@ static int left2right(graph_t * g, node_t * v, node_t * w)
 	if (ND_clust(v) != ND_clust(w))
 	    return TRUE;
     }
-    M = GD_rank(g)[ND_rank(v)].flat;
+    M = RANK(st, g)[ND_rank(v)].flat;
     if (M == NULL)
 	rv = FALSE;
     else {
@@ -578,45 +1115,195 @@ static int left2right(graph_t * g, node_t * v, node_t * w)
     return rv;
 }
 
-static int in_cross(node_t * v, node_t * w)
+/* in_cross, out_cross:
+ * Add to *c0 the penalty of crossings among the in (out) edges of the
+ * adjacent nodes v and w, with v left of w, and to *c1 the penalty of those
+ * there would be after exchanging v and w.
+ */
+static void in_cross(node_t * v, node_t * w, int *c0, int *c1)
 {
     edge_t **e1, **e2;
-    int inv, cross = 0, t;
+    int inv, t;
+    double port;
 
     for (e2 = ND_in(w).list; *e2; e2++) {
-	int cnt = ED_xpenalty(*e2);		
-		
+	int cnt = ED_xpenalty(*e2);
 	inv = ND_order(agtail(*e2));
+	port = ED_tail_port(*e2).p.x;
 
 	for (e1 = ND_in(v).list; *e1; e1++) {
 	    t = ND_order(agtail(*e1)) - inv;
-	    if (t > 0 || (t == 0 && ED_tail_port(*e1).p.x > ED_tail_port(*e2).p.x))
-		cross += ED_xpenalty(*e1) * cnt;
+	    if (t > 0 || (t == 0 && ED_tail_port(*e1).p.x > port))
+		*c0 += ED_xpenalty(*e1) * cnt;
+	    else if (t < 0 || (t == 0 && ED_tail_port(*e1).p.x < port))
+		*c1 += ED_xpenalty(*e1) * cnt;
 	}
     }
-    return cross;
 }
 
-static int out_cross(node_t * v, node_t * w)
+static void out_cross(node_t * v, node_t * w, int *c0, int *c1)
 {
     edge_t **e1, **e2;
-    int inv, cross = 0, t;
+    int inv, t;
+    double port;
 
     for (e2 = ND_out(w).list; *e2; e2++) {
 	int cnt = ED_xpenalty(*e2);
 	inv = ND_order(aghead(*e2));
+	port = ED_head_port(*e2).p.x;
 
 	for (e1 = ND_out(v).list; *e1; e1++) {
 	    t = ND_order(aghead(*e1)) - inv;
-	    if (t > 0 || (t == 0 && (ED_head_port(*e1)).p.x > (ED_head_port(*e2)).p.x))
-		cross += ED_xpenalty(*e1) * cnt;
+	    if (t > 0 || (t == 0 && ED_head_port(*e1).p.x > port))
+		*c0 += ED_xpenalty(*e1) * cnt;
+	    else if (t < 0 || (t == 0 && ED_head_port(*e1).p.x < port))
+		*c1 += ED_xpenalty(*e1) * cnt;
+	}
+    }
+}
+
+/* While transposing rank r, the nodes on the neighboring ranks keep their
+ * order. The far endpoints of the edges of each node on r can thus be
+ * collected once per sweep into compact arrays, which are much cheaper to
+ * compare pairwise than the edge lists themselves. Arrays of nodes with many
+ * edges are also sorted, so the crossings between two such nodes follow from
+ * merging their endpoints in O(deg(v) + deg(w)) instead of comparing every
+ * pair of edges.
+ */
+#define SORTED_MIN	32
+static int endpointcmpf(const void *x, const void *y)
+{
+    const endpoint_t *a = x;
+    const endpoint_t *b = y;
+
+    if (a->order != b->order)
+	return a->order < b->order ? -1 : 1;
+    if (a->port != b->port)
+	return a->port < b->port ? -1 : 1;
+    return 0;
+}
+
+static int endpoints(elist l, bool in, endpoint_t * ep)
+{
+    int i;
+    edge_t *e;
+
+    for (i = 0; (e = l.list[i]); i++) {
+	if (in) {
+	    ep[i].order = ND_order(agtail(e));
+	    ep[i].port = ED_tail_port(e).p.x;
+	} else {
+	    ep[i].order = ND_order(aghead(e));
+	    ep[i].port = ED_head_port(e).p.x;
 	}
+	ep[i].weight = ED_xpenalty(e);
+    }
+    if (i > SORTED_MIN)
+	qsort(ep, (size_t)i, sizeof(ep[0]), endpointcmpf);
+    return i;
+}
+
+static void scratch_free(endpoint_scratch_t * sc)
+{
+    free(sc->ep);
+    free(sc->eps);
+    *sc = (endpoint_scratch_t){0};
+}
+
+/* collect the sorted endpoints of the nodes on a rank */
+static void rank_endpoints(endpoint_scratch_t * st, rank_t * rank, bool in,
+			   bool out)
+{
+    int i, n = 0;
+    node_t *v;
+
+    for (i = 0; i < rank->n; i++) {
+	v = rank->v[i];
+	if (in)
+	    n += ND_in(v).size;
+	if (out)
+	    n += ND_out(v).size;
+    }
+    if (st->nep < n) {
+	st->nep = n;
+	st->ep = ALLOC(n, st->ep, endpoint_t);
+    }
+    if (st->neps < rank->n) {
+	st->neps = rank->n;
+	st->eps = ALLOC(rank->n, st->eps, endpoints_t);
+    }
+
+    n = 0;
+    for (i = 0; i < rank->n; i++) {
+	v = rank->v[i];
+	st->eps[i].in = n;
+	st->eps[i].nin = in ? endpoints(ND_in(v), true, st->ep + n) : 0;
+	n += st->eps[i].nin;
+	st->eps[i].out = n;
+	st->eps[i].nout = out ? endpoints(ND_out(v), false, st->ep + n) : 0;
+	n += st->eps[i].nout;
+    }
+}
+
+/* total penalty of the pairs of a and b where the endpoint in a lies
+ * strictly right of the one in b
+ */
+static int merge_count(const endpoint_t * a, int na, const endpoint_t * b,
+		       int nb)
+{
+    int i, j, total = 0, left = 0, cross = 0;
+
+    for (i = 0; i < na; i++)
+	total += a[i].weight;
+    for (i = j = 0; j < nb; j++) {
+	while (i < na && endpointcmpf(&a[i], &b[j]) <= 0)
+	    left += a[i++].weight;
+	cross += (total - left) * b[j].weight;
     }
     return cross;
+}
+
+/* crossings among the edges with endpoints a and b, in the manner of
+ * in_cross
+ */
+static void endpoints_cross(const endpoint_t * a, int na, const endpoint_t * b,
+			    int nb, int *c0, int *c1)
+{
+    int i, j;
+
+    if (na > SORTED_MIN && nb > SORTED_MIN) {
+	*c0 += merge_count(a, na, b, nb);
+	*c1 += merge_count(b, nb, a, na);
+	return;
+    }
+    /* written without branches, as their outcome is hard to predict */
+    for (j = 0; j < nb; j++) {
+	int x0 = 0, x1 = 0;
+	for (i = 0; i < na; i++) {
+	    int t = a[i].order - b[j].order;
+	    x0 += ((t > 0) | ((t == 0) & (a[i].port > b[j].port))) * a[i].weight;
+	    x1 += ((t < 0) | ((t == 0) & (a[i].port < b[j].port))) * a[i].weight;
+	}
+	*c0 += x0 * b[j].weight;
+	*c1 += x1 * b[j].weight;
+    }
+}
 
+/* like in_cross and out_cross together, for the nodes at positions i and
+ * i + 1 of the rank last passed to rank_endpoints
+ */
+static void sorted_cross(const endpoint_scratch_t * st, int i, int *c0,
+			 int *c1)
+{
+    const endpoints_t *v = &st->eps[i];
+    const endpoints_t *w = &st->eps[i + 1];
+    const endpoint_t *ep = st->ep;
+
+    endpoints_cross(ep + v->in, v->nin, ep + w->in, w->nin, c0, c1);
+    endpoints_cross(ep + v->out, v->nout, ep + w->out, w->nout, c0, c1);
 }
 
-static void exchange(node_t * v, node_t * w)
+static void exchange(mincross_state_t * st, node_t * v, node_t * w)
 {
     int vi, wi, r;
 
@@ -624,13 +1311,14 @@ static void exchange(node_t * v, node_t * w)
     vi = ND_order(v);
     wi = ND_order(w);
     ND_order(v) = wi;
-    GD_rank(Root)[r].v[wi] = v;
+    st->rank[r].v[wi] = v;
     ND_order(w) = vi;
-    GD_rank(Root)[r].v[vi] = w;
+    st->rank[r].v[vi] = w;
 }
 
-static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
+static void balanceNodes(mincross_state_t * st, graph_t * g, int r, node_t * v, node_t * w)
 {
+    rank_t *rank = RANK(st, g);
     node_t *s;			/* separator node */
     int sepIndex = 0;
     int nullType;		/* type of null nodes */
@@ -642,8 +1330,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
 	return;
 
     /* count the number of dummy and original nodes */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == NORMAL)
+    for (i = 0; i < rank[r].n; i++) {
+	if (ND_node_type(rank[r].v[i]) == NORMAL)
 	    cntOri++;
 	else
 	    cntDummy++;
@@ -662,8 +1350,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
     }
 
     /* get the separator node index */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (GD_rank(g)[r].v[i] == s)
+    for (i = 0; i < rank[r].n; i++) {
+	if (rank[r].v[i] == s)
 	    sepIndex = i;
     }
 
@@ -673,14 +1361,14 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
      * right of the separator node 
      */
     for (i = sepIndex - 1; i >= 0; i--) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+	if (ND_node_type(rank[r].v[i]) == nullType)
 	    k++;
 	else
 	    break;
     }
 
-    for (i = sepIndex + 1; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+    for (i = sepIndex + 1; i < rank[r].n; i++) {
+	if (ND_node_type(rank[r].v[i]) == nullType)
 	    m++;
 	else
 	    break;
@@ -688,11 +1376,11 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
 
     /* now exchange v,w and calculate the same counts */
 
-    exchange(v, w);
+    exchange(st, v, w);
 
     /* get the separator node index */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (GD_rank(g)[r].v[i] == s)
+    for (i = 0; i < rank[r].n; i++) {
+	if (rank[r].v[i] == s)
 	    sepIndex = i;
     }
 
@@ -700,25 +1388,25 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
      * right of the separator node 
      */
     for (i = sepIndex - 1; i >= 0; i--) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+	if (ND_node_type(rank[r].v[i]) == nullType)
 	    k1++;
 	else
 	    break;
     }
 
-    for (i = sepIndex + 1; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+    for (i = sepIndex + 1; i < rank[r].n; i++) {
+	if (ND_node_type(rank[r].v[i]) == nullType)
 	    m1++;
 	else
 	    break;
     }
 
     if (abs(k1 - m1) > abs(k - m)) {
-	exchange(v, w);		//revert to the original ordering
+	exchange(st, v, w);		//revert to the original ordering
     }
 }
 
-static int balance(graph_t * g)
+static int balance(mincross_state_t * st, graph_t * g)
 {
     int i, c0, c1, rv;
     node_t *v, *w;
@@ -728,132 +1416,245 @@ static int balance(graph_t * g)
 
     for (r = GD_maxrank(g); r >= GD_minrank(g); r--) {
 
-	GD_rank(g)[r].candidate = false;
-	for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
-	    v = GD_rank(g)[r].v[i];
-	    w = GD_rank(g)[r].v[i + 1];
+	RANK(st, g)[r].candidate = false;
+	for (i = 0; i < RANK(st, g)[r].n - 1; i++) {
+	    v = RANK(st, g)[r].v[i];
+	    w = RANK(st, g)[r].v[i + 1];
 	    assert(ND_order(v) < ND_order(w));
-	    if (left2right(g, v, w))
+	    if (left2right(st, g, v, w))
 		continue;
 	    c0 = c1 = 0;
 	    if (r > 0) {
-		c0 += in_cross(v, w);
-		c1 += in_cross(w, v);
+		in_cross(v, w, &c0, &c1);
 	    }
 
-	    if (GD_rank(g)[r + 1].n > 0) {
-		c0 += out_cross(v, w);
-		c1 += out_cross(w, v);
+	    if (RANK(st, g)[r + 1].n > 0) {
+		out_cross(v, w, &c0, &c1);
 	    }
 
 	    if (c1 <= c0) {
-		balanceNodes(g, r, v, w);
+		balanceNodes(st, g, r, v, w);
 	    }
 	}
     }
     return rv;
 }
 
-static int transpose_step(graph_t * g, int r, bool reverse)
+/* transpose_step:
+ * Exchange adjacent nodes of rank r that cross less the other way round.
+ * Only rank r is changed, so ranks that are not adjacent may be handled
+ * concurrently, each with its own scratch space sc. The ranks next to r
+ * are left for the caller to mark, see transpose_mark.
+ * Returns the reduction in crossings and sets *exchanged if any nodes
+ * were exchanged.
+ */
+static int transpose_step(mincross_state_t * st, endpoint_scratch_t * sc,
+			  graph_t * g, int r, bool reverse, bool *exchanged)
 {
     int i, c0, c1, rv;
     node_t *v, *w;
 
     rv = 0;
-    GD_rank(g)[r].candidate = false;
-    for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
-	v = GD_rank(g)[r].v[i];
-	w = GD_rank(g)[r].v[i + 1];
+    *exchanged = false;
+    RANK(st, g)[r].candidate = false;
+    rank_endpoints(sc, &RANK(st, g)[r], r > 0, RANK(st, g)[r + 1].n > 0);
+    for (i = 0; i < RANK(st, g)[r].n - 1; i++) {
+	v = RANK(st, g)[r].v[i];
+	w = RANK(st, g)[r].v[i + 1];
 	assert(ND_order(v) < ND_order(w));
-	if (left2right(g, v, w))
+	if (left2right(st, g, v, w))
 	    continue;
 	c0 = c1 = 0;
-	if (r > 0) {
-	    c0 += in_cross(v, w);
-	    c1 += in_cross(w, v);
-	}
-	if (GD_rank(g)[r + 1].n > 0) {
-	    c0 += out_cross(v, w);
-	    c1 += out_cross(w, v);
-	}
+	sorted_cross(sc, i, &c0, &c1);
 	if (c1 < c0 || (c0 > 0 && reverse && c1 == c0)) {
-	    exchange(v, w);
+	    endpoints_t t = sc->eps[i];
+	    sc->eps[i] = sc->eps[i + 1];
+	    sc->eps[i + 1] = t;
+	    exchange(st, v, w);
 	    rv += c0 - c1;
-	    GD_rank(Root)[r].valid = false;
-	    GD_rank(g)[r].candidate = true;
-
-	    if (r > GD_minrank(g)) {
-		GD_rank(Root)[r - 1].valid = false;
-		GD_rank(g)[r - 1].candidate = true;
-	    }
-	    if (r < GD_maxrank(g)) {
-		GD_rank(Root)[r + 1].valid = false;
-		GD_rank(g)[r + 1].candidate = true;
-	    }
+	    st->rank[r].valid = false;
+	    RANK(st, g)[r].candidate = true;
+	    *exchanged = true;
 	}
     }
     return rv;
 }
 
-static void transpose(graph_t * g, bool reverse)
+/* the crossings with rank r have changed, so revisit the ranks next to it */
+static void transpose_mark(mincross_state_t * st, graph_t * g, int r)
+{
+    if (r > GD_minrank(g)) {
+	st->rank[r - 1].valid = false;
+	RANK(st, g)[r - 1].candidate = true;
+    }
+    if (r < GD_maxrank(g)) {
+	st->rank[r + 1].valid = false;
+	RANK(st, g)[r + 1].candidate = true;
+    }
+}
+
+/* ranks of one parity handled concurrently by transpose_parallel */
+typedef struct {
+    mincross_state_t *st;
+    graph_t *g;
+    int first;			/* rank of job 0, every other rank follows */
+    bool reverse;
+    endpoint_scratch_t *sc;	/* per rank, from GD_minrank(g) */
+    int *delta;			/* per rank, result of transpose_step */
+    bool *exchanged;		/* per rank, result of transpose_step */
+} transpose_job_t;
+
+static void transpose_job(void *arg, size_t i)
+{
+    transpose_job_t *job = arg;
+    int r = job->first + 2 * (int)i;
+    int k = r - GD_minrank(job->g);
+
+    job->delta[k] = 0;
+    job->exchanged[k] = false;
+    if (RANK(job->st, job->g)[r].candidate)
+	job->delta[k] = transpose_step(job->st, &job->sc[k], job->g, r,
+				       job->reverse, &job->exchanged[k]);
+}
+
+/* transpose_parallel:
+ * Like the loop of transpose, but each sweep first handles the even ranks
+ * and then the odd ones, each half concurrently. A rank thus sees both of
+ * its neighbors as left by the same half sweep, whatever the number of
+ * threads, rather than the one above as changed and the one below as
+ * unchanged by this sweep.
+ */
+static void transpose_parallel(mincross_state_t * st, graph_t * g,
+			       bool reverse)
 {
-    int r, delta;
+    int minr = GD_minrank(g), maxr = GD_maxrank(g), delta, sweeps = 0;
+    size_t nranks = (size_t)(maxr - minr + 1);
+    transpose_job_t job = {.st = st, .g = g, .reverse = reverse};
+
+    job.sc = gv_calloc(nranks, sizeof(endpoint_scratch_t));
+    job.delta = gv_calloc(nranks, sizeof(int));
+    job.exchanged = gv_calloc(nranks, sizeof(bool));
+    do {
+	delta = 0;
+	for (int parity = 0; parity < 2; parity++) {
+	    job.first = minr + parity;
+	    if (job.first > maxr)
+		break;
+	    size_t n = (size_t)(maxr - job.first) / 2 + 1;
+	    dot_parallel_for(st->Threads, n, transpose_job, &job);
+	    for (int r = job.first; r <= maxr; r += 2) {
+		delta += job.delta[r - minr];
+		if (job.exchanged[r - minr])
+		    transpose_mark(st, g, r);
+	    }
+	}
+	sweeps++;
+    } while (delta >= 1 && !out_of_time(st) &&
+	     (st->MaxSweeps == 0 || sweeps < st->MaxSweeps));
+
+    for (size_t k = 0; k < nranks; k++)
+	scratch_free(&job.sc[k]);
+    free(job.sc);
+    free(job.delta);
+    free(job.exchanged);
+}
+
+/* does g have a rank wide enough to spread its work over threads? */
+static bool wide_ranks(mincross_state_t * st, graph_t * g)
+{
+    if (st->Threads <= 1 || !dot_parallel_available())
+	return false;
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	if (RANK(st, g)[r].n >= PAR_WIDTH)
+	    return true;
+    return false;
+}
+
+static void transpose(mincross_state_t * st, graph_t * g, bool reverse)
+{
+    int r, delta, sweeps = 0;
+    bool exchanged;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
-	GD_rank(g)[r].candidate = true;
+	RANK(st, g)[r].candidate = true;
+    if (wide_ranks(st, g)) {
+	transpose_parallel(st, g, reverse);
+	return;
+    }
     do {
 	delta = 0;
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	    if (GD_rank(g)[r].candidate) {
-		delta += transpose_step(g, r, reverse);
+	    if (RANK(st, g)[r].candidate) {
+		delta += transpose_step(st, &st->sc, g, r, reverse, &exchanged);
+		if (exchanged)
+		    transpose_mark(st, g, r);
 	    }
 	}
-    } while (delta >= 1);
+	sweeps++;
+    } while (delta >= 1 && !out_of_time(st) &&
+	     (st->MaxSweeps == 0 || sweeps < st->MaxSweeps));
 }
 
-static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
+/* out_of_time:
+ * Has the mctime budget run out? Every exchange keeps a valid order, so
+ * callers may stop at any point and carry on with the order at hand.
+ */
+static bool out_of_time(mincross_state_t * st)
+{
+    if (st->Deadline > 0 && !st->TimedOut && wall_sec() >= st->Deadline)
+	st->TimedOut = true;
+    return st->TimedOut;
+}
+
+static int mincross(mincross_state_t * st, graph_t * g, int startpass,
+		    int endpass, int doBalance)
 {
     int maxthispass = 0, iter, trying, pass;
     int cur_cross, best_cross;
 
     if (startpass > 1) {
-	cur_cross = best_cross = ncross(g);
-	save_best(g);
+	cur_cross = best_cross = ncross(st);
+	save_best(st, g);
     } else
 	cur_cross = best_cross = INT_MAX;
     for (pass = startpass; pass <= endpass; pass++) {
+	/* the first pass builds the initial order, which cannot be skipped;
+	 * one seeded from an earlier layout is only refined by transpose
+	 */
+	if (pass > startpass && (st->Seeded || out_of_time(st)))
+	    break;
 	if (pass <= 1) {
-	    maxthispass = MIN(4, MaxIter);
+	    maxthispass = MIN(4, st->MaxIter);
 	    if (g == dot_root(g))
-		build_ranks(g, pass);
+		build_ranks(st, g, pass);
 	    if (pass == 0)
-		flat_breakcycles(g);
-	    flat_reorder(g);
+		flat_breakcycles(st, g);
+	    flat_reorder(st, g);
 
-	    if ((cur_cross = ncross(g)) <= best_cross) {
-		save_best(g);
+	    if ((cur_cross = ncross(st)) <= best_cross) {
+		save_best(st, g);
 		best_cross = cur_cross;
 	    }
 	} else {
-	    maxthispass = MaxIter;
+	    maxthispass = st->MaxIter;
 	    if (cur_cross > best_cross)
-		restore_best(g);
+		restore_best(st, g);
 	    cur_cross = best_cross;
 	}
 	trying = 0;
-	for (iter = 0; iter < maxthispass; iter++) {
+	for (iter = 0; iter < maxthispass && !st->Seeded; iter++) {
 	    if (Verbose)
 		fprintf(stderr,
 			"mincross: pass %d iter %d trying %d cur_cross %d best_cross %d\n",
 			pass, iter, trying, cur_cross, best_cross);
-	    if (trying++ >= MinQuit)
+	    if (trying++ >= st->MinQuit)
 		break;
-	    if (cur_cross == 0)
+	    if (cur_cross == 0 || out_of_time(st))
 		break;
-	    mincross_step(g, iter);
-	    if ((cur_cross = ncross(g)) <= best_cross) {
-		save_best(g);
-		if (cur_cross < Convergence * best_cross)
+	    mincross_step(st, g, iter);
+	    if ((cur_cross = ncross(st)) <= best_cross) {
+		save_best(st, g);
+		if (cur_cross < st->Convergence * best_cross)
 		    trying = 0;
 		best_cross = cur_cross;
 	    }
@@ -862,51 +1663,108 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
 	    break;
     }
     if (cur_cross > best_cross)
-	restore_best(g);
-    if (best_cross > 0) {
-	transpose(g, FALSE);
-	best_cross = ncross(g);
+	restore_best(st, g);
+    if (best_cross > 0 && !out_of_time(st)) {
+	transpose(st, g, FALSE);
+	best_cross = ncross(st);
     }
     if (doBalance) {
 	for (iter = 0; iter < maxthispass; iter++)
-	    balance(g);
+	    balance(st, g);
     }
 
     return best_cross;
 }
 
-static void restore_best(graph_t * g)
+/* mincross_starts:
+ * Run mincross from st->Starts initial orders and keep the ordering with the
+ * fewest crossings. The first start is the classic one; later ones shuffle
+ * the order in which build_ranks visits the nodes, seeded by the number of
+ * the start. Ties go to the earlier start, so the result only depends on the
+ * number of starts. The starts work on the same nodes, so they run one after
+ * the other; components are still spread over threads as a whole.
+ */
+static int mincross_starts(mincross_state_t * st, graph_t * g, int doBalance)
+{
+    int r, i, k, nc, best;
+    size_t total, j;
+    node_t **saved;
+
+    best = mincross(st, g, 0, 2, doBalance);
+    if (st->Starts <= 1 || best == 0)
+	return best;
+
+    total = 0;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	total += (size_t)RANK(st, g)[r].n;
+    saved = gv_calloc(total, sizeof(node_t *));
+    for (j = 0, r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	for (i = 0; i < RANK(st, g)[r].n; i++)
+	    saved[j++] = RANK(st, g)[r].v[i];
+
+    for (k = 1; k < st->Starts && best > 0 && !out_of_time(st); k++) {
+	st->Seed = (unsigned)k;
+	nc = mincross(st, g, 0, 2, doBalance);
+	if (Verbose)
+	    fprintf(stderr, "mincross: start %d crossings %d best %d\n", k, nc,
+		    best);
+	if (nc < best) {
+	    best = nc;
+	    for (j = 0, r = GD_minrank(g); r <= GD_maxrank(g); r++)
+		for (i = 0; i < RANK(st, g)[r].n; i++)
+		    saved[j++] = RANK(st, g)[r].v[i];
+	}
+    }
+    st->Seed = 0;
+
+    for (j = 0, r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	rank_t *rank = &RANK(st, g)[r];
+	int base_order = rank->n > 0 ? ND_order(rank->v[0]) : 0;
+	for (i = 0; i < rank->n; i++) {
+	    rank->v[i] = saved[j++];
+	    ND_order(rank->v[i]) = base_order + i;
+	}
+	rank->valid = false;
+	/* later starts may have turned flat edges around to suit their order */
+	if (GD_has_flat_edges(g))
+	    flat_make_lr(st, g, r);
+    }
+    free(saved);
+    return best;
+}
+
+static void restore_best(mincross_state_t * st, graph_t * g)
 {
     node_t *n;
     int i, r;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANK(st, g)[r].n; i++) {
+	    n = RANK(st, g)[r].v[i];
 	    ND_order(n) = saveorder(n);
 	}
     }
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	GD_rank(Root)[r].valid = false;
-	qsort(GD_rank(g)[r].v, GD_rank(g)[r].n, sizeof(GD_rank(g)[0].v[0]),
+	st->rank[r].valid = false;
+	qsort(RANK(st, g)[r].v, RANK(st, g)[r].n, sizeof(RANK(st, g)[0].v[0]),
 	      (qsort_cmpf) nodeposcmpf);
     }
 }
 
-static void save_best(graph_t * g)
+static void save_best(mincross_state_t * st, graph_t * g)
 {
     node_t *n;
     int i, r;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANK(st, g)[r].n; i++) {
+	    n = RANK(st, g)[r].v[i];
 	    saveorder(n) = ND_order(n);
 	}
     }
 }
 
 /* merges the connected components of g */
-static void merge_components(graph_t * g)
+static void merge_components(mincross_state_t * st, graph_t * g)
 {
     int c;
     node_t *u, *v;
@@ -926,23 +1784,30 @@ static void merge_components(graph_t * g)
     }
     GD_comp(g).size = 1;
     GD_nlist(g) = GD_comp(g).list[0];
-    GD_minrank(g) = GlobalMinRank;
-    GD_maxrank(g) = GlobalMaxRank;
+    GD_minrank(g) = st->GlobalMinRank;
+    GD_maxrank(g) = st->GlobalMaxRank;
 }
 
 /* merge connected components, create globally consistent rank lists */
-static void merge2(graph_t * g)
+static void merge2(mincross_state_t * st, graph_t * g)
 {
     int i, r;
     node_t *v;
 
     /* merge the components and rank limits */
-    merge_components(g);
+    merge_components(st, g);
 
     /* install complete ranks */
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	GD_rank(g)[r].n = GD_rank(g)[r].an;
 	GD_rank(g)[r].v = GD_rank(g)[r].av;
+	if (st->stash) {
+	    /* keep the matrix of the last component with flat edges on r */
+	    if (GD_rank(g)[r].flat)
+		free_matrix(st->stash[r]);
+	    else
+		GD_rank(g)[r].flat = st->stash[r];
+	}
 	for (i = 0; i < GD_rank(g)[r].n; i++) {
 	    v = GD_rank(g)[r].v[i];
 	    if (v == NULL) {
@@ -956,22 +1821,24 @@ static void merge2(graph_t * g)
 	    ND_order(v) = i;
 	}
     }
+    free(st->stash);
+    st->stash = NULL;
 }
 
-static void cleanup2(graph_t * g, int nc)
+static void cleanup2(mincross_state_t * st, graph_t * g, int nc)
 {
     int i, j, r, c;
     node_t *v;
     edge_t *e;
 
-    if (TI_list) {
-	free(TI_list);
-	TI_list = NULL;
-    }
-    if (TE_list) {
-	free(TE_list);
-	TE_list = NULL;
-    }
+    free(st->TI_list);
+    st->TI_list = NULL;
+    free(st->TE_list);
+    st->TE_list = NULL;
+    free(st->Count);
+    st->Count = NULL;
+    st->C = 0;
+    scratch_free(&st->sc);
     /* fix vlists of clusters */
     for (c = 1; c <= GD_n_cluster(g); c++)
 	rec_reset_vlists(GD_clust(g)[c]);
@@ -998,7 +1865,7 @@ static void cleanup2(graph_t * g, int nc)
 		agnameof(g), nc, elapsed_sec());
 }
 
-static node_t *neighbor(node_t * v, int dir)
+static node_t *neighbor(graph_t * root, node_t * v, int dir)
 {
     node_t *rv;
 
@@ -1006,34 +1873,52 @@ static node_t *neighbor(node_t * v, int dir)
 assert(v);
     if (dir < 0) {
 	if (ND_order(v) > 0)
-	    rv = GD_rank(Root)[ND_rank(v)].v[ND_order(v) - 1];
+	    rv = GD_rank(root)[ND_rank(v)].v[ND_order(v) - 1];
     } else
-	rv = GD_rank(Root)[ND_rank(v)].v[ND_order(v) + 1];
+	rv = GD_rank(root)[ND_rank(v)].v[ND_order(v) + 1];
 assert((rv == 0) || (ND_order(rv)-ND_order(v))*dir > 0);
     return rv;
 }
 
-static int is_a_normal_node_of(graph_t * g, node_t * v)
+/* contains:
+ * agcontains(g, obj), serialized when st is shared with other threads.
+ * Lookups restructure cgraph's dictionaries, so even these are not safe to
+ * run concurrently.
+ */
+static int contains(const mincross_state_t * st, graph_t * g, void *obj)
+{
+    int rv;
+
+    if (st && st->locked) {
+	dot_lock();
+	rv = agcontains(g, obj);
+	dot_unlock();
+    } else
+	rv = agcontains(g, obj);
+    return rv;
+}
+
+static int is_a_normal_node_of(const mincross_state_t * st, graph_t * g, node_t * v)
 {
-    return ND_node_type(v) == NORMAL && agcontains(g, v);
+    return ND_node_type(v) == NORMAL && contains(st, g, v);
 }
 
-static int is_a_vnode_of_an_edge_of(graph_t * g, node_t * v)
+static int is_a_vnode_of_an_edge_of(const mincross_state_t * st, graph_t * g, node_t * v)
 {
     if (ND_node_type(v) == VIRTUAL
 	&& ND_in(v).size == 1 && ND_out(v).size == 1) {
 	edge_t *e = ND_out(v).list[0];
 	while (ED_edge_type(e) != NORMAL)
 	    e = ED_to_orig(e);
-	if (agcontains(g, e))
+	if (contains(st, g, e))
 	    return TRUE;
     }
     return FALSE;
 }
 
-static int inside_cluster(graph_t * g, node_t * v)
+static int inside_cluster(const mincross_state_t * st, graph_t * g, node_t * v)
 {
-    return is_a_normal_node_of(g, v) | is_a_vnode_of_an_edge_of(g, v);
+    return is_a_normal_node_of(st, g, v) | is_a_vnode_of_an_edge_of(st, g, v);
 }
 
 static node_t *furthestnode(graph_t * g, node_t * v, int dir)
@@ -1041,10 +1926,10 @@ static node_t *furthestnode(graph_t * g, node_t * v, int dir)
     node_t *u, *rv;
 
     rv = u = v;
-    while ((u = neighbor(u, dir))) {
-	if (is_a_normal_node_of(g, u))
+    while ((u = neighbor(dot_root(g), u, dir))) {
+	if (is_a_normal_node_of(NULL, g, u))
 	    rv = u;
-	else if (is_a_vnode_of_an_edge_of(g, u))
+	else if (is_a_vnode_of_an_edge_of(NULL, g, u))
 	    rv = u;
     }
     return rv;
@@ -1156,28 +2041,29 @@ fillRanks (Agraph_t* g)
     free (rnks);
 }
 
-static void init_mincross(graph_t * g)
+static void init_mincross(mincross_state_t * st, graph_t * g)
 {
     int size;
 
     if (Verbose)
 	start_timer();
 
-    ReMincross = false;
-    Root = g;
+    st->ReMincross = false;
+    st->Root = g;
     /* alloc +1 for the null terminator usage in do_ordering() */
     size = agnedges(dot_root(g)) + 1;
-    TE_list = N_NEW(size, edge_t *);
-    TI_list = N_NEW(size, int);
-    mincross_options(g);
+    st->TE_list = N_NEW(size, edge_t *);
+    st->TI_list = N_NEW(size, int);
+    mincross_options(st, g);
     if (GD_flags(g) & NEW_RANK)
 	fillRanks (g);
     class2(g);
     decompose(g, 1);
     allocate_ranks(g);
-    ordered_edges(g);
-    GlobalMinRank = GD_minrank(g);
-    GlobalMaxRank = GD_maxrank(g);
+    st->rank = GD_rank(g);
+    ordered_edges(st, g);
+    st->GlobalMinRank = GD_minrank(g);
+    st->GlobalMaxRank = GD_maxrank(g);
 }
 
 static void flat_rev(Agraph_t * g, Agedge_t * e)
@@ -1207,19 +2093,19 @@ static void flat_rev(Agraph_t * g, Agedge_t * e)
     }
 }
 
-static void flat_search(graph_t * g, node_t * v)
+static void flat_search(mincross_state_t * st, graph_t * g, node_t * v)
 {
     int i;
     bool hascl;
     edge_t *e;
-    adjmatrix_t *M = GD_rank(g)[ND_rank(v)].flat;
+    adjmatrix_t *M = RANK(st, g)[ND_rank(v)].flat;
 
     ND_mark(v) = TRUE;
     ND_onstack(v) = true;
     hascl = GD_n_cluster(dot_root(g)) > 0;
     if (ND_flat_out(v).list)
 	for (i = 0; (e = ND_flat_out(v).list[i]); i++) {
-	    if (hascl && !(agcontains(g, agtail(e)) && agcontains(g, aghead(e))))
+	    	    if (hascl && !(contains(st, g, agtail(e)) && contains(st, g, aghead(e))))
 		continue;
 	    if (ED_weight(e) == 0)
 		continue;
@@ -1237,35 +2123,36 @@ static void flat_search(graph_t * g, node_t * v)
 		assert(flatindex(agtail(e)) < M->ncols);
 		ELT(M, flatindex(agtail(e)), flatindex(aghead(e))) = 1;
 		if (!ND_mark(aghead(e)))
-		    flat_search(g, aghead(e));
+		    		    flat_search(st, g, aghead(e));
 	    }
 	}
     ND_onstack(v) = false;
 }
 
-static void flat_breakcycles(graph_t * g)
+static void flat_breakcycles(mincross_state_t * st, graph_t * g)
 {
     int i, r, flat;
     node_t *v;
+    rank_t *rank = RANK(st, g);
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	flat = 0;
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    v = GD_rank(g)[r].v[i];
+	for (i = 0; i < rank[r].n; i++) {
+	    v = rank[r].v[i];
 	    ND_mark(v) = FALSE;
 	    ND_onstack(v) = false;
 	    flatindex(v) = i;
 	    if (ND_flat_out(v).size > 0 && flat == 0) {
-		GD_rank(g)[r].flat =
-		    new_matrix(GD_rank(g)[r].n, GD_rank(g)[r].n);
+		free_matrix(rank[r].flat);
+		rank[r].flat = new_matrix(rank[r].n, rank[r].n);
 		flat = 1;
 	    }
 	}
 	if (flat) {
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
+	    for (i = 0; i < rank[r].n; i++) {
+		v = rank[r].v[i];
 		if (!ND_mark(v))
-		    flat_search(g, v);
+		    flat_search(st, g, v);
 	    }
 	}
     }
@@ -1305,22 +2192,28 @@ void allocate_ranks(graph_t * g)
 }
 
 /* install a node at the current right end of its rank */
-void install_in_rank(graph_t * g, node_t * n)
+void install_in_rank(mincross_state_t * st, graph_t * g, node_t * n)
 {
     int i, r;
+    rank_t *rank = RANK(st, g);
 
     r = ND_rank(n);
-    i = GD_rank(g)[r].n;
-    if (GD_rank(g)[r].an <= 0) {
+    i = rank[r].n;
+    if (rank[r].an <= 0) {
 	agerr(AGERR, "install_in_rank, line %d: %s %s rank %d i = %d an = 0\n",
 	      __LINE__, agnameof(g), agnameof(n), r, i);
 	return;
     }
+    if (g == st->Root && i >= rank[r].an) {
+	agerr(AGERR, "install_in_rank, line %d: %s %s rank %d i = %d an = %d\n",
+	      __LINE__, agnameof(g), agnameof(n), r, i, rank[r].an);
+	return;
+    }
 
-    GD_rank(g)[r].v[i] = n;
+    rank[r].v[i] = n;
     ND_order(n) = i;
-    GD_rank(g)[r].n++;
-    assert(GD_rank(g)[r].n <= GD_rank(g)[r].an);
+    rank[r].n++;
+    assert(rank[r].n <= rank[r].an);
 #ifdef DEBUG
     {
 	node_t *v;
@@ -1331,9 +2224,9 @@ void install_in_rank(graph_t * g, node_t * n)
 	assert(v != NULL);
     }
 #endif
-    if (ND_order(n) > GD_rank(Root)[r].an) {
+        if (ND_order(n) > st->rank[r].an) {
 	agerr(AGERR, "install_in_rank, line %d: ND_order(%s) [%d] > GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, agnameof(n), ND_order(n), r, GD_rank(Root)[r].an);
+	      __LINE__, agnameof(n), ND_order(n), r, st->rank[r].an);
 	return;
     }
     if (r < GD_minrank(g) || r > GD_maxrank(g)) {
@@ -1341,33 +2234,317 @@ void install_in_rank(graph_t * g, node_t * n)
 	      __LINE__, r, GD_minrank(g), GD_maxrank(g));
 	return;
     }
-    if (GD_rank(g)[r].v + ND_order(n) >
-	GD_rank(g)[r].av + GD_rank(Root)[r].an) {
+        if (rank[r].v + ND_order(n) > rank[r].av + st->rank[r].an) {
 	agerr(AGERR, "install_in_rank, line %d: GD_rank(g)[%d].v + ND_order(%s) [%d] > GD_rank(g)[%d].av + GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, r, agnameof(n),ND_order(n), r, r, GD_rank(Root)[r].an);
+	      __LINE__, r, agnameof(n),ND_order(n), r, r, st->rank[r].an);
 	return;
     }
 }
 
+/* install the nodes reached from n by a breadth-first search along out
+ * edges (pass 0) or in edges (pass 1), if n is a source in that direction
+ */
+static void install_from(mincross_state_t * st, graph_t * g, node_t * n,
+			 int pass, nodequeue * q)
+{
+    node_t *n0;
+    edge_t **otheredges;
+
+    otheredges = pass == 0 ? ND_in(n).list : ND_out(n).list;
+    if (otheredges[0] != NULL)
+	return;
+    if (!MARK(n)) {
+	MARK(n) = TRUE;
+	enqueue(q, n);
+	while ((n0 = dequeue(q))) {
+	    if (ND_ranktype(n0) != CLUSTER) {
+		install_in_rank(st, g, n0);
+		enqueue_neighbors(q, n0, pass);
+	    } else {
+		install_cluster(st, g, n0, pass, q);
+	    }
+	}
+    }
+}
+
+/* Seeding the initial order from an earlier layout (mcinit=pos).
+ *
+ * Each node is keyed by its x in the layout that wrote the pos attributes,
+ * taken back through rankdir to dot's own coordinates. Virtual nodes take
+ * the x at which the spline of their edge crossed their rank, or else
+ * interpolate between the ends of the edge; the leaders of a collapsed
+ * cluster take the mean x of its nodes. Nodes with no position, such as
+ * those added since, take the mean of their neighbors. Installing in order
+ * of the keys then reproduces the earlier order, so that a small change to
+ * a graph does not reshuffle the rest of its drawing.
+ */
+
+typedef struct {
+    node_t *n;
+    double key;
+    size_t i;
+} seed_t;
+
+/* agxget is not thread-safe; see contains() */
+static char *seed_attr(const mincross_state_t * st, void *obj, Agsym_t * sym)
+{
+    char *rv;
+
+    if (st->locked)
+	dot_lock();
+    rv = agxget(obj, sym);
+    if (st->locked)
+	dot_unlock();
+    return rv;
+}
+
+/* undo the rotation for rankdir applied by translate_drawing */
+static pointf seed_point(const mincross_state_t * st, pointf p)
+{
+    switch (st->SeedRankdir) {
+    case RANKDIR_LR:
+	return (pointf) {p.y, -p.x};
+    case RANKDIR_BT:
+	return (pointf) {p.x, -p.y};
+    case RANKDIR_RL:
+	return (pointf) {p.y, p.x};
+    default:
+	return p;
+    }
+}
+
+static bool seed_node_pos(const mincross_state_t * st, node_t * n, pointf * p)
+{
+    char *s = seed_attr(st, n, st->SeedPos);
+
+    if (!s || sscanf(s, "%lf,%lf", &p->x, &p->y) != 2)
+	return false;
+    *p = seed_point(st, *p);
+    return true;
+}
+
+/* seed_spline_x:
+ * x at which the control polygon of an edge pos crosses height y.
+ */
+static bool seed_spline_x(const mincross_state_t * st, const char *s,
+			  double y, double *x)
+{
+    pointf a = {0, 0}, b;
+    bool have = false;
+    int len;
+
+    while (*s) {
+	if (*s == ' ' || *s == ';' || *s == '\t' || *s == '\n') {
+	    s++;
+	    continue;
+	}
+	if ((*s == 's' || *s == 'e') && s[1] == ',') {
+	    /* arrowhead end point, not on the spline */
+	    if (sscanf(s + 2, "%lf,%lf%n", &b.x, &b.y, &len) != 2)
+		return false;
+	    s += 2 + len;
+	    continue;
+	}
+	if (sscanf(s, "%lf,%lf%n", &b.x, &b.y, &len) != 2)
+	    return false;
+	s += len;
+	b = seed_point(st, b);
+	if (have && a.y != b.y && (a.y - y) * (b.y - y) <= 0) {
+	    *x = a.x + (y - a.y) / (b.y - a.y) * (b.x - a.x);
+	    return true;
+	}
+	a = b;
+	have = true;
+    }
+    return false;
+}
+
+static bool seed_vnode_x(const mincross_state_t * st, node_t * v, double *x)
+{
+    edge_t *e = NULL;
+    pointf t, h;
+    int rt, rh;
+    double f;
+    char *s;
+
+    if (ND_out(v).size > 0)
+	e = ND_out(v).list[0];
+    else if (ND_in(v).size > 0)
+	e = ND_in(v).list[0];
+    while (e && ED_edge_type(e) != NORMAL)
+	e = ED_to_orig(e);
+    if (!e || ND_node_type(agtail(e)) != NORMAL
+	|| ND_node_type(aghead(e)) != NORMAL)
+	return false;
+    if (!seed_node_pos(st, agtail(e), &t) || !seed_node_pos(st, aghead(e), &h))
+	return false;
+
+    rt = ND_rank(agtail(e));
+    rh = ND_rank(aghead(e));
+    if (rt == rh) {		/* label node of a flat edge */
+	*x = (t.x + h.x) / 2;
+	return true;
+    }
+    f = (double) (ND_rank(v) - rt) / (rh - rt);
+    *x = t.x + f * (h.x - t.x);
+    if (st->SeedEdgePos && (s = seed_attr(st, e, st->SeedEdgePos)))
+	seed_spline_x(st, s, t.y + f * (h.y - t.y), x);
+    return true;
+}
+
+static bool seed_cluster_x(const mincross_state_t * st, graph_t * clust,
+			   double *x)
+{
+    node_t *n;
+    pointf p;
+    double sum = 0;
+    size_t cnt = 0;
+
+    if (st->locked)
+	dot_lock();
+    for (n = agfstnode(clust); n; n = agnxtnode(clust, n)) {
+	char *s = agxget(n, st->SeedPos);
+	if (s && sscanf(s, "%lf,%lf", &p.x, &p.y) == 2) {
+	    sum += seed_point(st, p).x;
+	    cnt++;
+	}
+    }
+    if (st->locked)
+	dot_unlock();
+    if (cnt == 0)
+	return false;
+    *x = sum / cnt;
+    return true;
+}
+
+/* mean key of the neighbors of n on nlist, which are found by their index
+ * in ND_low
+ */
+static bool seed_neighbors(seed_t * nodes, size_t cnt, node_t * n, double *x)
+{
+    elist *lists[] = {&ND_out(n), &ND_in(n), &ND_flat_out(n), &ND_flat_in(n)};
+    double sum = 0;
+    size_t found = 0;
+
+    for (size_t l = 0; l < sizeof(lists) / sizeof(lists[0]); l++) {
+	for (int i = 0; i < lists[l]->size; i++) {
+	    edge_t *e = lists[l]->list[i];
+	    node_t *m = agtail(e) == n ? aghead(e) : agtail(e);
+	    int k = ND_low(m);
+	    if (k >= 0 && (size_t) k < cnt && nodes[k].n == m
+		&& nodes[k].key != HUGE_VAL) {
+		sum += nodes[k].key;
+		found++;
+	    }
+	}
+    }
+    if (found == 0)
+	return false;
+    *x = sum / found;
+    return true;
+}
+
+static int seed_cmp(const void *x, const void *y)
+{
+    const seed_t *a = x, *b = y;
+
+    if (a->key != b->key)
+	return a->key < b->key ? -1 : 1;
+    return a->i < b->i ? -1 : a->i > b->i;
+}
+
+/* seed_ranks:
+ * Install the nodes of nlist in the order of their earlier positions.
+ * Returns false, having installed nothing, if none of them has a position.
+ */
+static bool seed_ranks(mincross_state_t * st, graph_t * g, node_t * nlist)
+{
+    size_t cnt = 0, k, keyed = 0;
+    node_t *n;
+    seed_t *nodes;
+    int *low;
+    bool changed;
+    pointf p;
+    double x;
+
+    for (n = nlist; n; n = ND_next(n))
+	cnt++;
+    nodes = gv_calloc(cnt, sizeof(seed_t));
+    low = gv_calloc(cnt, sizeof(int));
+    for (k = 0, n = nlist; n; n = ND_next(n), k++) {
+	nodes[k].n = n;
+	nodes[k].i = k;
+	nodes[k].key = HUGE_VAL;
+	low[k] = ND_low(n);
+	ND_low(n) = (int) k;
+	if (ND_ranktype(n) == CLUSTER && ND_clust(n)) {
+	    if (seed_cluster_x(st, ND_clust(n), &x))
+		nodes[k].key = x;
+	} else if (ND_node_type(n) == NORMAL) {
+	    if (seed_node_pos(st, n, &p))
+		nodes[k].key = p.x;
+	} else if (seed_vnode_x(st, n, &x))
+	    nodes[k].key = x;
+	if (nodes[k].key != HUGE_VAL)
+	    keyed++;
+    }
+
+    if (keyed > 0) {
+	do {
+	    changed = false;
+	    for (k = 0; k < cnt; k++) {
+		if (nodes[k].key == HUGE_VAL
+		    && seed_neighbors(nodes, cnt, nodes[k].n, &x)) {
+		    nodes[k].key = x;
+		    changed = true;
+		}
+	    }
+	} while (changed);
+    }
+    for (k = 0; k < cnt; k++)
+	ND_low(nodes[k].n) = low[k];
+    free(low);
+
+    if (keyed > 0) {
+	qsort(nodes, cnt, sizeof(seed_t), seed_cmp);
+	for (k = 0; k < cnt; k++) {
+	    n = nodes[k].n;
+	    if (ND_ranktype(n) == CLUSTER && ND_clust(n)) {
+		/* all leaders at once, as install_cluster does */
+		graph_t *clust = ND_clust(n);
+		if (GD_installed(clust) != 1) {
+		    for (int r = GD_minrank(clust); r <= GD_maxrank(clust); r++)
+			install_in_rank(st, g, GD_rankleader(clust)[r]);
+		    GD_installed(clust) = 1;
+		}
+	    } else
+		install_in_rank(st, g, n);
+	}
+    }
+    free(nodes);
+    return keyed > 0;
+}
+
 /*	install nodes in ranks. the initial ordering ensure that series-parallel
  *	graphs such as trees are drawn with no crossings.  it tries searching
  *	in- and out-edges and takes the better of the two initial orderings.
  */
-void build_ranks(graph_t * g, int pass)
+void build_ranks(mincross_state_t * st, graph_t * g, int pass)
 {
     int i, j;
-    node_t *n, *n0;
-    edge_t **otheredges;
+    node_t *n, *nlist;
     nodequeue *q;
+    rank_t *rank = RANK(st, g);
 
+    nlist = g == st->Root ? st->nlist : GD_nlist(g);
     q = new_queue(GD_n_nodes(g));
-    for (n = GD_nlist(g); n; n = ND_next(n))
+    for (n = nlist; n; n = ND_next(n))
 	MARK(n) = FALSE;
 
 #ifdef DEBUG
     {
 	edge_t *e;
-	for (n = GD_nlist(g); n; n = ND_next(n)) {
+	for (n = nlist; n; n = ND_next(n)) {
 	    for (i = 0; (e = ND_out(n).list[i]); i++)
 		assert(!MARK(aghead(e)));
 	    for (i = 0; (e = ND_in(n).list[i]); i++)
@@ -1376,41 +2553,53 @@ void build_ranks(graph_t * g, int pass)
     }
 #endif
 
-    for (i = GD_minrank(g); i <= GD_maxrank(g); i++)
-	GD_rank(g)[i].n = 0;
+        for (i = GD_minrank(g); i <= GD_maxrank(g); i++)
+	rank[i].n = 0;
 
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
-	otheredges = pass == 0 ? ND_in(n).list : ND_out(n).list;
-	if (otheredges[0] != NULL)
-	    continue;
-	if (!MARK(n)) {
-	    MARK(n) = TRUE;
-	    enqueue(q, n);
-	    while ((n0 = dequeue(q))) {
-		if (ND_ranktype(n0) != CLUSTER) {
-		    install_in_rank(g, n0);
-		    enqueue_neighbors(q, n0, pass);
-		} else {
-		    install_cluster(g, n0, pass, q);
-		}
-	    }
+    st->Seeded = st->SeedPos && seed_ranks(st, g, nlist);
+    if (st->Seeded) {
+	/* installed in the order of a previous layout */
+    } else if (st->Seed == 0) {
+	for (n = nlist; n; n = ND_next(n))
+	    install_from(st, g, n, pass, q);
+    } else {
+	/* a later start of mincross_starts: visit the nodes in shuffled order */
+	size_t cnt = 0, k;
+	unsigned x = st->Seed * 2654435761u + (unsigned)pass + 1;
+	for (n = nlist; n; n = ND_next(n))
+	    cnt++;
+	node_t **order = gv_calloc(cnt, sizeof(node_t *));
+	for (k = 0, n = nlist; n; n = ND_next(n))
+	    order[k++] = n;
+	for (k = cnt; k > 1; k--) {
+	    /* xorshift32 */
+	    x ^= x << 13;
+	    x ^= x >> 17;
+	    x ^= x << 5;
+	    size_t m = x % k;
+	    n = order[k - 1];
+	    order[k - 1] = order[m];
+	    order[m] = n;
 	}
+	for (k = 0; k < cnt; k++)
+	    install_from(st, g, order[k], pass, q);
+	free(order);
     }
     if (dequeue(q))
 	agerr(AGERR, "surprise\n");
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++) {
-	GD_rank(Root)[i].valid = false;
-	if (GD_flip(g) && GD_rank(g)[i].n > 0) {
-	    node_t **vlist = GD_rank(g)[i].v;
-	    int num_nodes_1 = GD_rank(g)[i].n - 1;
+		st->rank[i].valid = false;
+	if (GD_flip(g) && rank[i].n > 0) {
+	    node_t **vlist = rank[i].v;
+	    int num_nodes_1 = rank[i].n - 1;
 	    int half_num_nodes_1 = num_nodes_1 / 2;
 	    for (j = 0; j <= half_num_nodes_1; j++)
-		exchange(vlist[j], vlist[num_nodes_1 - j]);
+		exchange(st, vlist[j], vlist[num_nodes_1 - j]);
 	}
     }
 
-    if (g == dot_root(g) && ncross(g) > 0)
-	transpose(g, FALSE);
+    if (g == dot_root(g) && ncross(st) > 0)
+	transpose(st, g, FALSE);
     free_queue(q);
 }
 
@@ -1438,10 +2627,11 @@ void enqueue_neighbors(nodequeue * q, node_t * n0, int pass)
     }
 }
 
-static int constraining_flat_edge(Agraph_t *g, Agedge_t *e) {
+static int constraining_flat_edge(const mincross_state_t *st, Agraph_t *g,
+				  Agedge_t *e) {
 	if (ED_weight(e) == 0) return FALSE;
-	if (!inside_cluster(g,agtail(e))) return FALSE;
-	if (!inside_cluster(g,aghead(e))) return FALSE;
+	if (!inside_cluster(st,g,agtail(e))) return FALSE;
+	if (!inside_cluster(st,g,aghead(e))) return FALSE;
 	return TRUE;
 }
 
@@ -1449,7 +2639,8 @@ static int constraining_flat_edge(Agraph_t *g, Agedge_t *e) {
 /* construct nodes reachable from 'here' in post-order.
 * This is the same as doing a topological sort in reverse order.
 */
-static int postorder(graph_t * g, node_t * v, node_t ** list, int r)
+static int postorder(const mincross_state_t * st, graph_t * g, node_t * v,
+		     node_t ** list, int r)
 {
     edge_t *e;
     int i, cnt = 0;
@@ -1457,9 +2648,9 @@ static int postorder(graph_t * g, node_t * v, node_t ** list, int r)
     MARK(v) = TRUE;
     if (ND_flat_out(v).size > 0) {
 	for (i = 0; (e = ND_flat_out(v).list[i]); i++) {
-	    if (!constraining_flat_edge(g, e)) continue;
+	    	    if (!constraining_flat_edge(st, g, e)) continue;
 	    if (!MARK(aghead(e)))
-		cnt += postorder(g, aghead(e), list + cnt, r);
+		cnt += postorder(st, g, aghead(e), list + cnt, r);
 	}
     }
     assert(ND_rank(v) == r);
@@ -1467,43 +2658,203 @@ static int postorder(graph_t * g, node_t * v, node_t ** list, int r)
     return cnt;
 }
 
-static void flat_reorder(graph_t * g)
+/* nonconstraint flat edges on rank r must be made LR */
+static void flat_make_lr(mincross_state_t * st, graph_t * g, int r)
+{
+    int i, j;
+    node_t *v;
+    edge_t *e;
+    rank_t *rank = RANK(st, g);
+
+    for (i = 0; i < rank[r].n; i++) {
+	v = rank[r].v[i];
+	if (ND_flat_out(v).list) {
+	    for (j = 0; (e = ND_flat_out(v).list[j]); j++) {
+		if ( (!GD_flip(g) && ND_order(aghead(e)) < ND_order(agtail(e))) ||
+			 ( (GD_flip(g)) && (ND_order(aghead(e)) > ND_order(agtail(e)) ))) {
+		    assert(!constraining_flat_edge(st, g, e));
+		    delete_flat_edge(e);
+		    j--;
+		    flat_rev(g, e);
+		}
+	    }
+	}
+    }
+}
+
+/* save_clust_order:
+ * Record the order of the nodes on each rank of cluster g in the layout
+ * cache, before any of its own clusters are expanded.
+ */
+static void save_clust_order(mincross_state_t * st, graph_t * g,
+			     clust_entry_t * ent)
+{
+    int r, i;
+    size_t j, total = 0;
+
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	total += (size_t)RANK(st, g)[r].n;
+    free(ent->rank_size);
+    free(ent->order);
+    ent->n_rank_size = GD_maxrank(g) - GD_minrank(g) + 1;
+    ent->rank_size = gv_calloc((size_t)ent->n_rank_size, sizeof(int));
+    ent->order = gv_calloc(total, sizeof(uint64_t));
+    for (j = 0, r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	ent->rank_size[r - GD_minrank(g)] = RANK(st, g)[r].n;
+	for (i = 0; i < RANK(st, g)[r].n; i++)
+	    ent->order[j++] = dot_node_signature(RANK(st, g)[r].v[i]);
+    }
+}
+
+/* a recorded node signature and its position */
+typedef struct {
+    uint64_t sig;
+    int pos;
+} sigpos_t;
+
+static int sigposcmpf(const void *x, const void *y)
+{
+    const sigpos_t *a = x;
+    const sigpos_t *b = y;
+    if (a->sig != b->sig)
+	return a->sig < b->sig ? -1 : 1;
+    return a->pos - b->pos;
+}
+
+/* restore_clust_order:
+ * Put the nodes on each rank of cluster g in the order recorded by
+ * save_clust_order. Nodes with the same signature keep their relative
+ * order. Returns false, leaving the order alone, unless the record accounts
+ * for exactly the nodes now in g and keeps constraining flat edges
+ * pointing the right way.
+ */
+static bool restore_clust_order(mincross_state_t * st, graph_t * g,
+				const clust_entry_t * ent)
+{
+    int r, i, j, k, n, maxn = 0, base_order;
+    size_t base, total = 0;
+    bool ok = true;
+    edge_t *e;
+
+    if (ent->n_rank_size != GD_maxrank(g) - GD_minrank(g) + 1)
+	return false;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	n = RANK(st, g)[r].n;
+	if (n != ent->rank_size[r - GD_minrank(g)])
+	    return false;
+	total += (size_t)n;
+	maxn = MAX(maxn, n);
+    }
+
+    /* target[base + i] is the new position of the node now at i */
+    int *target = gv_calloc(total, sizeof(int));
+    sigpos_t *sp = gv_calloc((size_t)maxn, sizeof(sigpos_t));
+    for (base = 0, r = GD_minrank(g); ok && r <= GD_maxrank(g);
+	 base += (size_t)n, r++) {
+	rank_t *rank = &RANK(st, g)[r];
+	n = rank->n;
+	for (i = 0; i < n; i++) {
+	    sp[i].sig = ent->order[base + (size_t)i];
+	    sp[i].pos = i;
+	}
+	qsort(sp, (size_t)n, sizeof(sp[0]), sigposcmpf);
+	for (i = 0; ok && i < n; i++) {
+	    uint64_t sig = dot_node_signature(rank->v[i]);
+	    int lo = 0, hi = n;
+	    while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (sp[mid].sig < sig)
+		    lo = mid + 1;
+		else
+		    hi = mid;
+	    }
+	    /* skip entries already taken by nodes of the same signature */
+	    for (k = lo; k < n && sp[k].sig == sig && sp[k].pos < 0; k++);
+	    if (k == n || sp[k].sig != sig)
+		ok = false;
+	    else {
+		target[base + (size_t)i] = sp[k].pos;
+		sp[k].pos = -1;
+	    }
+	}
+	base_order = n > 0 ? ND_order(rank->v[0]) : 0;
+	for (i = 0; ok && i < n; i++) {
+	    node_t *v = rank->v[i];
+	    if (!ND_flat_out(v).list)
+		continue;
+	    for (j = 0; (e = ND_flat_out(v).list[j]); j++) {
+		int h = ND_order(aghead(e)) - base_order;
+		if (h < 0 || h >= n || !constraining_flat_edge(st, g, e))
+		    continue;
+		if ((target[base + (size_t)h] < target[base + (size_t)i]) !=
+		    GD_flip(g))
+		    ok = false;
+	    }
+	}
+    }
+    free(sp);
+
+    if (ok) {
+	node_t **vlist = gv_calloc((size_t)maxn, sizeof(node_t *));
+	for (base = 0, r = GD_minrank(g); r <= GD_maxrank(g);
+	     base += (size_t)n, r++) {
+	    rank_t *rank = &RANK(st, g)[r];
+	    n = rank->n;
+	    base_order = n > 0 ? ND_order(rank->v[0]) : 0;
+	    for (i = 0; i < n; i++)
+		vlist[target[base + (size_t)i]] = rank->v[i];
+	    for (i = 0; i < n; i++) {
+		rank->v[i] = vlist[i];
+		ND_order(vlist[i]) = base_order + i;
+	    }
+	    st->rank[r].valid = false;
+	    if (GD_has_flat_edges(g))
+		flat_make_lr(st, g, r);
+	}
+	free(vlist);
+    }
+    free(target);
+    return ok;
+}
+
+static void flat_reorder(mincross_state_t * st, graph_t * g)
 {
     int i, j, r, pos, n_search, local_in_cnt, local_out_cnt, base_order;
     node_t *v, **left, **right, *t;
     node_t **temprank = NULL;
-    edge_t *flat_e, *e;
+    edge_t *flat_e;
+    rank_t *rank = RANK(st, g);
 
     if (!GD_has_flat_edges(g))
 	return;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].n == 0) continue;
-	base_order = ND_order(GD_rank(g)[r].v[0]);
-	for (i = 0; i < GD_rank(g)[r].n; i++)
-	    MARK(GD_rank(g)[r].v[i]) = FALSE;
+	if (rank[r].n == 0) continue;
+	base_order = ND_order(rank[r].v[0]);
+	for (i = 0; i < rank[r].n; i++)
+	    MARK(rank[r].v[i]) = FALSE;
 	temprank = ALLOC(i + 1, temprank, node_t *);
 	pos = 0;
 
 	/* construct reverse topological sort order in temprank */
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    if (GD_flip(g)) v = GD_rank(g)[r].v[i];
-	    else v = GD_rank(g)[r].v[GD_rank(g)[r].n - i - 1];
+	for (i = 0; i < rank[r].n; i++) {
+	    if (GD_flip(g)) v = rank[r].v[i];
+	    else v = rank[r].v[rank[r].n - i - 1];
 
 	    local_in_cnt = local_out_cnt = 0;
 	    for (j = 0; j < ND_flat_in(v).size; j++) {
 		flat_e = ND_flat_in(v).list[j];
-		if (constraining_flat_edge(g, flat_e)) local_in_cnt++;
+		if (constraining_flat_edge(st, g, flat_e)) local_in_cnt++;
 	    }
 	    for (j = 0; j < ND_flat_out(v).size; j++) {
 		flat_e = ND_flat_out(v).list[j];
-		if (constraining_flat_edge(g, flat_e)) local_out_cnt++;
+		if (constraining_flat_edge(st, g, flat_e)) local_out_cnt++;
 	    }
 	    if ((local_in_cnt == 0) && (local_out_cnt == 0))
 		temprank[pos++] = v;
 	    else {
 		if (!MARK(v) && local_in_cnt == 0) {
 		    left = temprank + pos;
-		    n_search = postorder(g, v, left, r);
+		    n_search = postorder(st, g, v, left, r);
 		    pos += n_search;
 		}
 	    }
@@ -1521,42 +2872,29 @@ static void flat_reorder(graph_t * g)
 		    right--;
 		}
 	    }
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i] = temprank[i];
+	    for (i = 0; i < rank[r].n; i++) {
+		v = rank[r].v[i] = temprank[i];
 		ND_order(v) = i + base_order;
 	    }
 
-	    /* nonconstraint flat edges must be made LR */
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
-		if (ND_flat_out(v).list) {
-		    for (j = 0; (e = ND_flat_out(v).list[j]); j++) {
-			if ( (!GD_flip(g) && ND_order(aghead(e)) < ND_order(agtail(e))) ||
-				 ( (GD_flip(g)) && (ND_order(aghead(e)) > ND_order(agtail(e)) ))) {
-			    assert(!constraining_flat_edge(g, e));
-			    delete_flat_edge(e);
-			    j--;
-			    flat_rev(g, e);
-			}
-		    }
-		}
-	    }
+	    flat_make_lr(st, g, r);
 	    /* postprocess to restore intended order */
 	}
 	/* else do no harm! */
-	GD_rank(Root)[r].valid = false;
+	st->rank[r].valid = false;
     }
     if (temprank)
 	free(temprank);
 }
 
-static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
+static void reorder(mincross_state_t * st, graph_t * g, int r, bool reverse,
+		    bool hasfixed)
 {
     int changed = 0, nelt;
-    node_t **vlist = GD_rank(g)[r].v;
-    node_t **lp, **rp, **ep = vlist + GD_rank(g)[r].n;
+    node_t **vlist = RANK(st, g)[r].v;
+    node_t **lp, **rp, **ep = vlist + RANK(st, g)[r].n;
 
-    for (nelt = GD_rank(g)[r].n - 1; nelt >= 0; nelt--) {
+    for (nelt = RANK(st, g)[r].n - 1; nelt >= 0; nelt--) {
 	lp = vlist;
 	while (lp < ep) {
 	    /* find leftmost node that can be compared */
@@ -1570,7 +2908,7 @@ static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
 	    for (rp = lp + 1; rp < ep; rp++) {
 		if (sawclust && ND_clust(*rp))
 		    continue;	/* ### */
-		if (left2right(g, *lp, *rp)) {
+				if (left2right(st, g, *lp, *rp)) {
 		    muststay = true;
 		    break;
 		}
@@ -1585,7 +2923,7 @@ static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
 		int p1 = ND_mval(*lp);
 		int p2 = ND_mval(*rp);
 		if (p1 > p2 || (p1 == p2 && reverse)) {
-		    exchange(*lp, *rp);
+		    		    exchange(st, *lp, *rp);
 		    changed++;
 		}
 	    }
@@ -1596,13 +2934,13 @@ static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
     }
 
     if (changed) {
-	GD_rank(Root)[r].valid = false;
+		st->rank[r].valid = false;
 	if (r > 0)
-	    GD_rank(Root)[r - 1].valid = false;
+	    st->rank[r - 1].valid = false;
     }
 }
 
-static void mincross_step(graph_t * g, int pass)
+static void mincross_step(mincross_state_t * st, graph_t * g, int pass)
 {
     int r, other, first, last, dir;
 
@@ -1610,24 +2948,24 @@ static void mincross_step(graph_t * g, int pass)
 
     if (pass % 2 == 0) {	/* down pass */
 	first = GD_minrank(g) + 1;
-	if (GD_minrank(g) > GD_minrank(Root))
+		if (GD_minrank(g) > GD_minrank(st->Root))
 	    first--;
 	last = GD_maxrank(g);
 	dir = 1;
     } else {			/* up pass */
 	first = GD_maxrank(g) - 1;
 	last = GD_minrank(g);
-	if (GD_maxrank(g) < GD_maxrank(Root))
+		if (GD_maxrank(g) < GD_maxrank(st->Root))
 	    first++;
 	dir = -1;
     }
 
     for (r = first; r != last + dir; r += dir) {
 	other = r - dir;
-	bool hasfixed = medians(g, r, other);
-	reorder(g, r, reverse, hasfixed);
+		bool hasfixed = medians(st, g, r, other);
+	reorder(st, g, r, reverse, hasfixed);
     }
-    transpose(g, !reverse);
+    transpose(st, g, !reverse);
 }
 
 static int local_cross(elist l, int dir)
@@ -1655,65 +2993,216 @@ static int local_cross(elist l, int dir)
     return cross;
 }
 
-static int rcross(graph_t * g, int r)
+/* The crossings between two adjacent ranks are counted with an accumulator
+ * tree, here a Fenwick tree indexed by the order of the lower endpoint.
+ * Edges are visited in order of their upper endpoint. Each edge crosses every
+ * edge already in the tree whose lower endpoint lies further right, and the
+ * tree yields the total penalty of those in O(log n). A full count thus costs
+ * O(E log V) instead of O(E V).
+ */
+
+/* add w at position i of the tree t */
+static void acc_add(int *t, int n, int i, int w)
 {
-    static int *Count, C;
-    int top, bot, cross, max, i, k;
+    for (i++; i <= n; i += i & -i)
+	t[i] += w;
+}
+
+/* sum of the weights at positions 0..i of the tree t */
+static int acc_sum(const int *t, int i)
+{
+    int sum = 0;
+
+    for (i++; i > 0; i -= i & -i)
+	sum += t[i];
+    return sum;
+}
+
+static int rcross(mincross_state_t * st, int r)
+{
+    int top, bot, cross, total, i, n;
     node_t **rtop, *v;
+    rank_t *rank = st->rank;
+    int *Count;
+    edge_t *e;
 
     cross = 0;
-    max = 0;
-    rtop = GD_rank(g)[r].v;
+    total = 0;
+    rtop = rank[r].v;
+    n = rank[r + 1].n;
 
-    if (C <= GD_rank(Root)[r + 1].n) {
-	C = GD_rank(Root)[r + 1].n + 1;
-	Count = ALLOC(C, Count, int);
+    if (st->C <= n) {
+	st->C = n + 1;
+	st->Count = ALLOC(st->C, st->Count, int);
     }
+    Count = st->Count;
 
-    for (i = 0; i < GD_rank(g)[r + 1].n; i++)
+    for (i = 0; i <= n; i++)
 	Count[i] = 0;
 
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
-	edge_t *e;
-	if (max > 0) {
+    for (top = 0; top < rank[r].n; top++) {
+	if (total > 0) {
 	    for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-		for (k = ND_order(aghead(e)) + 1; k <= max; k++)
-		    cross += Count[k] * ED_xpenalty(e);
+		int right = total - acc_sum(Count, ND_order(aghead(e)));
+		cross += right * ED_xpenalty(e);
 	    }
 	}
 	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-	    int inv = ND_order(aghead(e));
-	    if (inv > max)
-		max = inv;
-	    Count[inv] += ED_xpenalty(e);
+	    assert(ND_order(aghead(e)) < n);
+	    acc_add(Count, n, ND_order(aghead(e)), ED_xpenalty(e));
+	    total += ED_xpenalty(e);
 	}
     }
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
-	v = GD_rank(g)[r].v[top];
+    for (top = 0; top < rank[r].n; top++) {
+	v = rank[r].v[top];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_out(v), 1);
     }
-    for (bot = 0; bot < GD_rank(g)[r + 1].n; bot++) {
-	v = GD_rank(g)[r + 1].v[bot];
+    for (bot = 0; bot < rank[r + 1].n; bot++) {
+	v = rank[r + 1].v[bot];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_in(v), -1);
     }
     return cross;
 }
 
-int ncross(graph_t * g)
+/* an edge between two adjacent ranks, by the orders of its ends */
+typedef struct {
+    int top, bot;
+    int pen;
+} rank_edge_t;
+
+static int rank_edge_cmpf(const void *x, const void *y)
+{
+    const rank_edge_t *a = x, *b = y;
+
+    if (a->top != b->top)
+	return a->top < b->top ? -1 : 1;
+    return (a->bot > b->bot) - (a->bot < b->bot);
+}
+
+/* is order i on rank r within the nodes of g there? */
+static bool in_slice(mincross_state_t * st, graph_t * g, int r, int i)
+{
+    int lo;
+
+    if (r < GD_minrank(g) || r > GD_maxrank(g))
+	return false;
+    lo = (int)(GD_rank(g)[r].v - st->rank[r].v);
+    return i >= lo && i < lo + GD_rank(g)[r].n;
+}
+
+/* rcross_clust:
+ * The crossings between ranks r and r + 1 of the edges with an end in
+ * st->Clust. A pair of edges without such an end crosses or not whatever
+ * the order of st->Clust, and so does a pair with one in a sibling cluster
+ * that no edge joins to it. This thus differs from rcross by an amount that
+ * stays the same while st->Clust is ordered, and, unlike rcross, never looks
+ * at nodes of siblings in other groups, which may be ordered at the same
+ * time. Ports are only accounted for on the nodes of st->Clust.
+ */
+static int rcross_clust(mincross_state_t * st, int r)
+{
+    graph_t *g = st->Clust;
+    rank_t *top = NULL, *bot = NULL;
+    rank_edge_t *edges;
+    int *bots, *Count;
+    int i, j, cross = 0, total = 0;
+    size_t m = 0, nb, k, l;
+    node_t *v;
+    edge_t *e;
+
+    if (r >= GD_minrank(g) && r <= GD_maxrank(g))
+	top = &GD_rank(g)[r];
+    if (r + 1 >= GD_minrank(g) && r + 1 <= GD_maxrank(g))
+	bot = &GD_rank(g)[r + 1];
+
+    for (i = 0; top && i < top->n; i++)
+	m += (size_t)ND_out(top->v[i]).size;
+    for (i = 0; bot && i < bot->n; i++)
+	m += (size_t)ND_in(bot->v[i]).size;
+    edges = gv_calloc(m + 1, sizeof(rank_edge_t));
+    bots = gv_calloc(m + 1, sizeof(int));
+
+    m = 0;
+    for (i = 0; top && i < top->n; i++) {
+	v = top->v[i];
+	for (j = 0; (e = ND_out(v).list[j]); j++)
+	    edges[m++] = (rank_edge_t) {ND_order(v), ND_order(aghead(e)),
+					ED_xpenalty(e)};
+    }
+    for (i = 0; bot && i < bot->n; i++) {
+	v = bot->v[i];
+	for (j = 0; (e = ND_in(v).list[j]); j++)
+	    if (!in_slice(st, g, r, ND_order(agtail(e))))
+		edges[m++] = (rank_edge_t) {ND_order(agtail(e)), ND_order(v),
+					    ED_xpenalty(e)};
+    }
+
+    /* number the lower ends densely, for a tree as small as the edges */
+    for (k = 0; k < m; k++)
+	bots[k] = edges[k].bot;
+    qsort(bots, m, sizeof(int), (qsort_cmpf) ordercmpf);
+    for (nb = k = 0; k < m; k++)
+	if (nb == 0 || bots[nb - 1] != bots[k])
+	    bots[nb++] = bots[k];
+    for (k = 0; k < m; k++) {
+	int *p = bsearch(&edges[k].bot, bots, nb, sizeof(int),
+			 (bsearch_cmpf) ordercmpf);
+	edges[k].bot = (int)(p - bots);
+    }
+    qsort(edges, m, sizeof(rank_edge_t), rank_edge_cmpf);
+
+    if (st->C <= (int)nb) {
+	st->C = (int)nb + 1;
+	st->Count = ALLOC(st->C, st->Count, int);
+    }
+    Count = st->Count;
+    for (k = 0; k <= nb; k++)
+	Count[k] = 0;
+    for (k = 0; k < m; k = l) {
+	for (l = k; l < m && edges[l].top == edges[k].top; l++) {
+	    int right = total - acc_sum(Count, edges[l].bot);
+	    cross += right * edges[l].pen;
+	}
+	for (l = k; l < m && edges[l].top == edges[k].top; l++) {
+	    acc_add(Count, (int)nb, edges[l].bot, edges[l].pen);
+	    total += edges[l].pen;
+	}
+    }
+    free(bots);
+    free(edges);
+
+    for (i = 0; top && i < top->n; i++)
+	if (ND_has_port(top->v[i]))
+	    cross += local_cross(ND_out(top->v[i]), 1);
+    for (i = 0; bot && i < bot->n; i++)
+	if (ND_has_port(bot->v[i]))
+	    cross += local_cross(ND_in(bot->v[i]), -1);
+    return cross;
+}
+
+int ncross(mincross_state_t * st)
 {
-    int r, count, nc;
+    int r, count, nc, minr, maxr;
+    graph_t *g = st->Root;
+    rank_t *rank = st->rank;
 
-    g = Root;
+    minr = GD_minrank(g);
+    maxr = GD_maxrank(g);
+    if (st->Clust) {
+	minr = MAX(minr, GD_minrank(st->Clust) - 1);
+	maxr = MIN(maxr, GD_maxrank(st->Clust) + 1);
+    }
     count = 0;
-    for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].valid)
-	    count += GD_rank(g)[r].cache_nc;
+    for (r = minr; r < maxr; r++) {
+	if (rank[r].valid)
+	    count += rank[r].cache_nc;
 	else {
-	    nc = GD_rank(g)[r].cache_nc = rcross(g, r);
+	    nc = rank[r].cache_nc = st->Clust ? rcross_clust(st, r)
+					      : rcross(st, r);
 	    count += nc;
-	    GD_rank(g)[r].valid = true;
+	    rank[r].valid = true;
 	}
     }
     return count;
@@ -1772,57 +3261,109 @@ static bool flat_mval(node_t * n)
 
 #define VAL(node,port) (MC_SCALE * ND_order(node) + (port).order)
 
-static bool medians(graph_t * g, int r0, int r1)
+/* set ND_mval(n) of node n on rank r0 from its neighbors on rank r1, using
+ * list as scratch space for their positions
+ */
+static void node_median(node_t * n, int r0, int r1, int *list)
 {
-    int i, j0, lspan, rspan, *list;
-    node_t *n, **v;
+    int j0, lspan, rspan;
     edge_t *e;
-    bool hasfixed = false;
 
-    list = TI_list;
-    v = GD_rank(g)[r0].v;
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
-	n = v[i];
-	size_t j = 0;
-	if (r1 > r0)
-	    for (j0 = 0; (e = ND_out(n).list[j0]); j0++) {
-		if (ED_xpenalty(e) > 0)
-		    list[j++] = VAL(aghead(e), ED_head_port(e));
-	} else
-	    for (j0 = 0; (e = ND_in(n).list[j0]); j0++) {
-		if (ED_xpenalty(e) > 0)
-		    list[j++] = VAL(agtail(e), ED_tail_port(e));
-	    }
-	switch (j) {
-	case 0:
-	    ND_mval(n) = -1;
-	    break;
-	case 1:
-	    ND_mval(n) = list[0];
-	    break;
-	case 2:
-	    ND_mval(n) = (list[0] + list[1]) / 2;
-	    break;
-	default:
-	    qsort(list, j, sizeof(int), (qsort_cmpf) ordercmpf);
-	    if (j % 2)
-		ND_mval(n) = list[j / 2];
+    size_t j = 0;
+    if (r1 > r0)
+	for (j0 = 0; (e = ND_out(n).list[j0]); j0++) {
+	    if (ED_xpenalty(e) > 0)
+		list[j++] = VAL(aghead(e), ED_head_port(e));
+    } else
+	for (j0 = 0; (e = ND_in(n).list[j0]); j0++) {
+	    if (ED_xpenalty(e) > 0)
+		list[j++] = VAL(agtail(e), ED_tail_port(e));
+	}
+    switch (j) {
+    case 0:
+	ND_mval(n) = -1;
+	break;
+    case 1:
+	ND_mval(n) = list[0];
+	break;
+    case 2:
+	ND_mval(n) = (list[0] + list[1]) / 2;
+	break;
+    default:
+	qsort(list, j, sizeof(int), (qsort_cmpf) ordercmpf);
+	if (j % 2)
+	    ND_mval(n) = list[j / 2];
+	else {
+	    /* weighted median */
+	    size_t rm = j / 2;
+	    size_t lm = rm - 1;
+	    rspan = list[j - 1] - list[rm];
+	    lspan = list[lm] - list[0];
+	    if (lspan == rspan)
+		ND_mval(n) = (list[lm] + list[rm]) / 2;
 	    else {
-		/* weighted median */
-		size_t rm = j / 2;
-		size_t lm = rm - 1;
-		rspan = list[j - 1] - list[rm];
-		lspan = list[lm] - list[0];
-		if (lspan == rspan)
-		    ND_mval(n) = (list[lm] + list[rm]) / 2;
-		else {
-		    double w = list[lm] * (double)rspan + list[rm] * (double)lspan;
-		    ND_mval(n) = w / (lspan + rspan);
-		}
+		double w = list[lm] * (double)rspan + list[rm] * (double)lspan;
+		ND_mval(n) = w / (lspan + rspan);
 	    }
 	}
     }
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+}
+
+/* nodes of a rank whose medians are computed concurrently by medians */
+typedef struct {
+    node_t **v;
+    int n;
+    int r0, r1;
+    int *list;			/* scratch space of all jobs */
+    size_t *offset;		/* per job, start of its part of list */
+} median_job_t;
+
+static void median_job(void *arg, size_t i)
+{
+    median_job_t *job = arg;
+    int end = MIN(job->n, (int)(i + 1) * PAR_CHUNK);
+
+    for (int k = (int)i * PAR_CHUNK; k < end; k++)
+	node_median(job->v[k], job->r0, job->r1, job->list + job->offset[i]);
+}
+
+/* degree of n towards rank r1, i.e. the scratch space node_median needs */
+static size_t median_degree(node_t * n, int r0, int r1)
+{
+    return (size_t)(r1 > r0 ? ND_out(n).size : ND_in(n).size);
+}
+
+static bool medians(mincross_state_t * st, graph_t * g, int r0, int r1)
+{
+    int i;
+    node_t *n, **v;
+    bool hasfixed = false;
+
+    v = RANK(st, g)[r0].v;
+    if (st->Threads > 1 && RANK(st, g)[r0].n >= PAR_WIDTH) {
+	/* the result is the same, each chunk of nodes just gets a part of
+	 * the scratch space large enough for its node of largest degree
+	 */
+	median_job_t job = {.v = v, .n = RANK(st, g)[r0].n, .r0 = r0, .r1 = r1};
+	size_t njobs = ((size_t)job.n + PAR_CHUNK - 1) / PAR_CHUNK, size = 0;
+	job.offset = gv_calloc(njobs, sizeof(size_t));
+	for (size_t c = 0; c < njobs; c++) {
+	    size_t deg = 0;
+	    int end = MIN(job.n, (int)(c + 1) * PAR_CHUNK);
+	    for (int k = (int)c * PAR_CHUNK; k < end; k++)
+		deg = MAX(deg, median_degree(v[k], r0, r1));
+	    job.offset[c] = size;
+	    size += deg;
+	}
+	job.list = gv_calloc(size + 1, sizeof(int));
+	dot_parallel_for(st->Threads, njobs, median_job, &job);
+	free(job.list);
+	free(job.offset);
+    } else {
+	for (i = 0; i < RANK(st, g)[r0].n; i++)
+	    node_median(v[i], r0, r1, st->TI_list);
+    }
+        for (i = 0; i < RANK(st, g)[r0].n; i++) {
 	n = v[i];
 	if ((ND_out(n).size == 0) && (ND_in(n).size == 0))
 	    hasfixed |= flat_mval(n);
@@ -1920,11 +3461,11 @@ void check_rs(graph_t * g, int null_ok)
     }
 }
 
-void check_order(void)
+void check_order(graph_t * g)
 {
     int i, r;
     node_t *v;
-    graph_t *g = Root;
+
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	assert(GD_rank(g)[r].v[GD_rank(g)[r].n] == NULL);
@@ -1936,21 +3477,58 @@ void check_order(void)
 }
 #endif
 
-static void mincross_options(graph_t * g)
+static void mincross_options(mincross_state_t * st, graph_t * g)
 {
     char *p;
     double f;
 
     /* set default values */
-    MinQuit = 8;
-    MaxIter = 24;
-    Convergence = .995;
+    st->MinQuit = 8;
+    st->MaxIter = 24;
+    st->Convergence = .995;
+    st->Starts = 1;
+    st->MaxSweeps = 0;
 
     p = agget(g, "mclimit");
+    if ((GD_flags(g) & LARGE_GRAPH) && (!p || *p == '\0')) {
+	/* as if mclimit=0.17, i.e. one iteration without improvement and
+	 * at most four per pass, each with a few sweeps of transpose
+	 */
+	p = "0.17";
+	st->MaxSweeps = LARGE_SWEEPS;
+	if (Verbose)
+	    fprintf(stderr, "mincross %s: large graph, limiting iterations\n",
+		    agnameof(g));
+    }
     if (p && (f = atof(p)) > 0.0) {
-	MinQuit = MAX(1, MinQuit * f);
-	MaxIter = MAX(1, MaxIter * f);
+	st->MinQuit = MAX(1, st->MinQuit * f);
+	st->MaxIter = MAX(1, st->MaxIter * f);
     }
+
+    p = agget(g, "mcstarts");
+    if (p && atoi(p) > 1)
+	st->Starts = atoi(p);
+
+    p = agget(g, "mcinit");
+    if (p && *p) {
+	if (streq(p, "pos")) {
+	    st->SeedPos = agattr(g, AGNODE, "pos", NULL);
+	    st->SeedEdgePos = agattr(g, AGEDGE, "pos", NULL);
+	    st->SeedRankdir = GD_rankdir(g);
+	} else
+	    agerr(AGWARN, "mcinit '%s' not recognized.\n", p);
+    }
+    if (st->SeedPos) {
+	/* further starts would only lose the seeded order */
+	st->Starts = 1;
+	if (Verbose)
+	    fprintf(stderr, "mincross %s: seeding orders from pos\n",
+		    agnameof(g));
+    }
+
+    p = agget(g, "mctime");
+    if (p && (f = atof(p)) > 0.0)
+	st->Deadline = wall_sec() + f / 1000.0;
 }
 
 #ifdef DEBUG
@@ -1982,12 +3560,12 @@ void check_vlists(graph_t * g)
 	for (i = 0; i < GD_rank(g)[r].n; i++) {
 	    u = GD_rank(g)[r].v[i];
 	    j = ND_order(u);
-	    assert(GD_rank(Root)[r].v[j] == u);
+	    	    assert(GD_rank(dot_root(g))[r].v[j] == u);
 	}
 	if (GD_rankleader(g)) {
 	    u = GD_rankleader(g)[r];
 	    j = ND_order(u);
-	    assert(GD_rank(Root)[r].v[j] == u);
+	    	    assert(GD_rank(dot_root(g))[r].v[j] == u);
 	}
     }
     for (c = 1; c <= GD_n_cluster(g); c++)
@@ -1998,7 +3576,7 @@ void node_in_root_vlist(node_t * n)
 {
     node_t **vptr;
 
-    for (vptr = GD_rank(Root)[ND_rank(n)].v; *vptr; vptr++)
+        for (vptr = GD_rank(dot_root(n))[ND_rank(n)].v; *vptr; vptr++)
 	if (*vptr == n)
 	    break;
     if (*vptr == 0)
@@ -22,6 +22,7 @@
 #include <stdbool.h>
 
 static int nsiter2(graph_t * g);
+static void allocate_aux_edges(graph_t * g);
 static void create_aux_edges(graph_t * g);
 static void remove_aux_edges(graph_t * g);
 static void set_xcoords(graph_t * g);
@@ -29,6 +30,7 @@ static void set_ycoords(graph_t * g);
 static void set_aspect(graph_t * g, aspect_t* );
 static void expand_leaves(graph_t * g);
 static void make_lrvn(graph_t * g);
+static void bk_clusters(graph_t * g);
 static void contain_nodes(graph_t * g);
 static bool idealsize(graph_t * g, double);
 
@@ -107,14 +109,29 @@ connectGraph (graph_t* g)
 	if (r < GD_maxrank(g)) hp = (rp+1)->v[0];
 	else hp = (rp-1)->v[0];
 	assert (hp);
-	sn = virtual_node(g);
-	ND_node_type(sn) = SLACKNODE;
+	sn = slack_node(g);
 	make_aux_edge(sn, tp, 0, 0);
 	make_aux_edge(sn, hp, 0, 0);
 	ND_rank(sn) = MIN(ND_rank(tp), ND_rank(hp));
     }
 }
 
+/* use_bk:
+ * Return true if x coordinates are to be assigned by the Brandes-Köpf
+ * method rather than network simplex. This is the default for large graphs.
+ */
+static bool use_bk(graph_t * g)
+{
+    char *s = agget(g, "xcoord");
+    if ((GD_flags(g) & LARGE_GRAPH) && (!s || *s == '\0')) {
+	if (Verbose)
+	    fprintf(stderr, "position %s: large graph, using xcoord=bk\n",
+		    agnameof(g));
+	return true;
+    }
+    return s && streq(s, "bk");
+}
+
 void dot_position(graph_t * g, aspect_t* asp)
 {
     if (GD_nlist(g) == NULL)
@@ -126,12 +143,19 @@ void dot_position(graph_t * g, aspect_t* asp)
     expand_leaves(g);
     if (flat_edges(g))
 	set_ycoords(g);
-    create_aux_edges(g);
-    if (rank(g, 2, nsiter2(g))) { /* LR balance == 2 */
-	connectGraph (g);
-	const int rank_result = rank(g, 2, nsiter2(g));
-	assert(rank_result == 0);
-	(void)rank_result;
+    if (use_bk(g)) {
+	dot_bk_xcoords(g);
+	/* no constraints are needed, but remove_aux_edges expects the lists */
+	allocate_aux_edges(g);
+	bk_clusters(g);
+    } else {
+	create_aux_edges(g);
+	if (rank(g, 2, nsiter2(g))) { /* LR balance == 2 */
+	    connectGraph (g);
+	    const int rank_result = rank(g, 2, nsiter2(g));
+	    assert(rank_result == 0);
+	    (void)rank_result;
+	}
     }
     set_xcoords(g);
     set_aspect(g, asp);
@@ -169,15 +193,25 @@ static int canreach(node_t * u, node_t * v)
     return go(u, v);
 }
 
+/* an auxiliary edge together with its layout record */
+typedef struct {
+    Agedgepair_t pair;
+    Agedgeinfo_t info;
+} auxedge_t;
+
+/* make_aux_edge:
+ * Auxiliary edges are allocated with aux_alloc, so they need not and
+ * must not be freed individually.
+ */
 edge_t *make_aux_edge(node_t * u, node_t * v, double len, int wt)
 {
     edge_t *e;
 
-    Agedgepair_t* e2 = NEW(Agedgepair_t);
-    AGTYPE(&(e2->in)) = AGINEDGE;
-    AGTYPE(&(e2->out)) = AGOUTEDGE;
-    e2->out.base.data = (Agrec_t*)NEW(Agedgeinfo_t);
-    e = &(e2->out);
+    auxedge_t *ae = aux_alloc(agroot(u), sizeof(auxedge_t));
+    AGTYPE(&ae->pair.in) = AGINEDGE;
+    AGTYPE(&ae->pair.out) = AGOUTEDGE;
+    ae->pair.out.base.data = (Agrec_t*)&ae->info;
+    e = &ae->pair.out;
 
     agtail(e) = u;
     aghead(e) = v;
@@ -331,8 +365,7 @@ static void make_edge_pairs(graph_t * g)
     for (n = GD_nlist(g); n; n = ND_next(n)) {
 	if (ND_save_out(n).list)
 	    for (i = 0; (e = ND_save_out(n).list[i]); i++) {
-		sn = virtual_node(g);
-		ND_node_type(sn) = SLACKNODE;
+		sn = slack_node(g);
 		m0 = (ED_head_port(e).p.x - ED_tail_port(e).p.x);
 		if (m0 > 0)
 		    m1 = 0;
@@ -537,15 +570,9 @@ static void create_aux_edges(graph_t * g)
 
 static void remove_aux_edges(graph_t * g)
 {
-    int i;
     node_t *n, *nnext, *nprev;
-    edge_t *e;
 
     for (n = GD_nlist(g); n; n = ND_next(n)) {
-	for (i = 0; (e = ND_out(n).list[i]); i++) {
-	    free(e->base.data);
-	    free(e);
-	}
 	free_list(ND_out(n));
 	free_list(ND_in(n));
 	ND_out(n) = ND_save_out(n);
@@ -560,12 +587,11 @@ static void remove_aux_edges(graph_t * g)
 		ND_next(nprev) = nnext;
 	    else
 		GD_nlist(g) = nnext;
-	    free(n->base.data);
-	    free(n);
 	} else
 	    nprev = n;
     }
     ND_prev(GD_nlist(g)) = NULL;
+    free_aux_graph(g);
 }
 
 /* set_xcoords:
@@ -1171,10 +1197,8 @@ static void make_lrvn(graph_t * g)
 
     if (GD_ln(g))
 	return;
-    ln = virtual_node(dot_root(g));
-    ND_node_type(ln) = SLACKNODE;
-    rn = virtual_node(dot_root(g));
-    ND_node_type(rn) = SLACKNODE;
+    ln = slack_node(dot_root(g));
+    rn = slack_node(dot_root(g));
 
     if (GD_label(g) && (g != dot_root(g)) && !GD_flip(agroot(g))) {
 	int w = MAX(GD_border(g)[BOTTOM_IX].x, GD_border(g)[TOP_IX].x);
@@ -1215,6 +1239,25 @@ static void contain_nodes(graph_t * g)
     }
 }
 
+/* bk_clusters:
+ * Make the left and right bounding box nodes ln and rn of every cluster
+ * below g, positioned at the x extent dot_bk_xcoords left in its bounding
+ * box.
+ */
+static void bk_clusters(graph_t * g)
+{
+    int c;
+    graph_t *subg;
+
+    for (c = 1; c <= GD_n_cluster(g); c++) {
+	subg = GD_clust(g)[c];
+	make_lrvn(subg);
+	ND_rank(GD_ln(subg)) = GD_bb(subg).LL.x;
+	ND_rank(GD_rn(subg)) = GD_bb(subg).UR.x;
+	bk_clusters(subg);
+    }
+}
+
 /* idealsize:
  * set g->drawing->size to a reasonable default.
  * returns a boolean to indicate if drawing is to
@@ -23,6 +23,9 @@
  *  watch out for interactions between leaves and clusters.
  */
 
+#include	<cgraph/alloc.h>
+#include	<cgraph/arena.h>
+#include	<dotgen/clustcache.h>
 #include	<dotgen/dot.h>
 #include	<limits.h>
 #include	<stdbool.h>
@@ -444,8 +447,45 @@ setRanks (graph_t* g, attrsym_t* lsym)
 }
 #endif
 
+/* save_ranks:
+ * Record the local ranks of the nodes of cluster g in the layout cache.
+ */
+static void save_ranks(graph_t * g, clust_entry_t * ent)
+{
+    node_t *n;
+    int i;
+
+    free(ent->ranks);
+    ent->n_ranks = agnnodes(g);
+    ent->ranks = gv_calloc((size_t)ent->n_ranks, sizeof(int));
+    for (i = 0, n = agfstnode(g); n; n = agnxtnode(g, n), i++)
+	ent->ranks[i] = ND_rank(n);
+}
+
+/* restore_ranks:
+ * Give the nodes of cluster g the local ranks recorded by save_ranks,
+ * and set the cluster's rank bounds accordingly.
+ */
+static void restore_ranks(graph_t * g, const clust_entry_t * ent)
+{
+    node_t *n;
+    int i;
+
+    GD_minrank(g) = INT_MAX;
+    GD_maxrank(g) = -1;
+    for (i = 0, n = agfstnode(g); n; n = agnxtnode(g, n), i++) {
+	ND_rank(n) = ent->ranks[i];
+	if (GD_maxrank(g) < ND_rank(n))
+	    GD_maxrank(g) = ND_rank(n);
+	if (GD_minrank(g) > ND_rank(n))
+	    GD_minrank(g) = ND_rank(n);
+    }
+}
+
 /* dot1_rank:
  * asp != NULL => g is root
+ * If clustercache is set and g is a cluster ranked before with the same
+ * contents, network simplex is skipped and the recorded ranks are used.
  */
 static void dot1_rank(graph_t * g, aspect_t* asp)
 {
@@ -453,6 +493,14 @@ static void dot1_rank(graph_t * g, aspect_t* asp)
 #ifdef ALLOW_LEVELS
     attrsym_t* N_level;
 #endif
+    clust_entry_t *cached = NULL;
+    uint64_t key = 0;
+    bool caching = !asp && g != dot_root(g) && dot_cluster_cache_enabled(g);
+
+    /* hash before subclusters are induced below */
+    if (caching)
+	key = dot_cluster_hash(g);
+
     edgelabel_ranks(g);
 
     if (asp) {
@@ -472,6 +520,12 @@ static void dot1_rank(graph_t * g, aspect_t* asp)
     acyclic(g);
     if (minmax_edges2(g, p))
 	decompose(g, 0);
+    if (caching) {
+	cached = dot_cluster_cache(key, false);
+	if (cached && cached->n_ranks != agnnodes(g))
+	    cached = NULL;
+    }
+
 #ifdef ALLOW_LEVELS
     if ((N_level = agattr(g,AGNODE,"level",NULL)))
 	setRanks(g, N_level);
@@ -480,10 +534,17 @@ static void dot1_rank(graph_t * g, aspect_t* asp)
 
     if (asp)
 	rank3(g, asp);
-    else
+    else if (!cached)
 	rank1(g);
 
     expand_ranksets(g, asp);
+    if (cached) {
+	if (Verbose)
+	    fprintf(stderr, "rank %s: reusing cached ranks\n", agnameof(g));
+	restore_ranks(g, cached);
+    }
+    else if (caching)
+	save_ranks(g, dot_cluster_cache(key, true));
     cleanup1(g);
 }
 
@@ -513,9 +574,6 @@ bool is_cluster(graph_t * g)
 #define	BACKWARD_PENALTY	1000
 #define STRONG_CLUSTER_WEIGHT   1000
 #define	NORANK		6
-#define ROOT    "\177root"
-#define TOPNODE     "\177top"
-#define BOTNODE     "\177bot"
 
 /* hops is not used in dot, so we overload it to 
  * contain the index of the connected component
@@ -699,34 +757,167 @@ static bool is_internal_to_cluster(edge_t * e)
     return false;
 }
 
-static node_t* Last_node;
-static node_t* makeXnode (graph_t* G, char* name)
+/* The level assignment constraints form a fast graph of their own. Its
+ * nodes and edges are allocated from an arena instead of being made with
+ * agnode and agedge, as building and closing a cgraph graph with all its
+ * dictionaries cost more than ranking it. Edges are found by their
+ * endpoints through a hash table, which gives the constraint graph the
+ * behavior of a strict graph. Only g, a bare graph carrying the node list,
+ * is handed to rank2.
+ */
+typedef struct {
+    graph_t *g;			/* holds GD_nlist for rank2 */
+    arena_t arena;		/* storage of nodes and edges */
+    node_t *last;		/* end of the node list */
+    int n_nodes;
+    node_t *top, *bot;		/* shared ends of strong clusters */
+    edge_t **table;		/* open addressing table of edges */
+    size_t used;		/* occupied slots of table, deleted ones included */
+    size_t size;		/* number of slots of table, a power of 2 */
+} xgraph_t;
+
+/* a node of the constraint graph with its layout record */
+typedef struct {
+    node_t node;
+    Agnodeinfo_t info;
+} xnode_t;
+
+/* an edge of the constraint graph with its layout record */
+typedef struct {
+    Agedgepair_t pair;
+    Agedgeinfo_t info;
+} xedge_t;
+
+/* marks a slot of the table whose edge was deleted */
+static char xdeleted;
+#define XDELETED ((edge_t *)&xdeleted)
+
+static size_t xhash(node_t * t, node_t * h)
+{
+    return (size_t)ND_id(t) * 2654435761u ^ (size_t)ND_id(h) * 40503u;
+}
+
+/* find the slot of the edge from t to h, or the empty slot it would take */
+static size_t xslot(xgraph_t * xg, node_t * t, node_t * h)
+{
+    size_t mask = xg->size - 1;
+    size_t i = xhash(t, h) & mask;
+    edge_t *e;
+
+    while ((e = xg->table[i])) {
+	if (e != XDELETED && agtail(e) == t && aghead(e) == h)
+	    break;
+	i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static edge_t *xfindedge(xgraph_t * xg, node_t * t, node_t * h)
+{
+    if (xg->size == 0)
+	return NULL;
+    return xg->table[xslot(xg, t, h)];
+}
+
+static void xgrow(xgraph_t * xg)
+{
+    edge_t **old = xg->table;
+    size_t i, old_size = xg->size;
+
+    xg->size = old_size ? 2 * old_size : 64;
+    xg->table = gv_calloc(xg->size, sizeof(edge_t *));
+    xg->used = 0;
+    for (i = 0; i < old_size; i++) {
+	if (old[i] && old[i] != XDELETED) {
+	    xg->table[xslot(xg, agtail(old[i]), aghead(old[i]))] = old[i];
+	    xg->used++;
+	}
+    }
+    free(old);
+}
+
+static node_t *makeXnode(xgraph_t * xg)
 {
-    node_t *n = agnode(G, name, 1);
+    xnode_t *xn = arena_alloc(&xg->arena, sizeof(xnode_t));
+    node_t *n = &xn->node;
+
+    AGTYPE(n) = AGNODE;
+    n->base.data = (Agrec_t *) & xn->info;
+    n->root = xg->g;
+    ND_id(n) = xg->n_nodes++;
     alloc_elist(4, ND_in(n));
     alloc_elist(4, ND_out(n));
-    if (Last_node) {
-	ND_prev(n) = Last_node;
-	ND_next(Last_node) = n;
+    if (xg->last) {
+	ND_prev(n) = xg->last;
+	ND_next(xg->last) = n;
     } else {
 	ND_prev(n) = NULL;
-	GD_nlist(G) = n;
+	GD_nlist(xg->g) = n;
     }
-    Last_node = n;
+    xg->last = n;
     ND_next(n) = NULL;
-    
+
     return n;
 }
 
-static void compile_nodes(graph_t * g, graph_t * Xg)
+/* the edge from t to h, which is made if there is none */
+static edge_t *makeXedge(xgraph_t * xg, node_t * t, node_t * h)
+{
+    xedge_t *xe;
+    edge_t *e;
+    size_t i;
+
+    if ((e = xfindedge(xg, t, h)))
+	return e;
+    if (2 * (xg->used + 1) > xg->size)
+	xgrow(xg);
+
+    xe = arena_alloc(&xg->arena, sizeof(xedge_t));
+    AGTYPE(&xe->pair.in) = AGINEDGE;
+    AGTYPE(&xe->pair.out) = AGOUTEDGE;
+    xe->pair.out.base.data = (Agrec_t *) & xe->info;
+    e = &xe->pair.out;
+    agtail(e) = t;
+    aghead(e) = h;
+
+    i = xslot(xg, t, h);
+    xg->table[i] = e;
+    xg->used++;
+    elist_append(e, ND_out(t));
+    elist_append(e, ND_in(h));
+    return e;
+}
+
+/* remove e from L, keeping the order of the other edges */
+static void xremove(elist * L, edge_t * e)
+{
+    int i;
+
+    for (i = 0; i < L->size; i++) {
+	if (L->list[i] == e) {
+	    memmove(&L->list[i], &L->list[i + 1],
+		    (size_t)(L->size - i) * sizeof(L->list[0]));
+	    L->size--;
+	    break;
+	}
+    }
+}
+
+static void deleteXedge(xgraph_t * xg, edge_t * e)
+{
+    xg->table[xslot(xg, agtail(e), aghead(e))] = XDELETED;
+    xremove(&ND_out(agtail(e)), e);
+    xremove(&ND_in(aghead(e)), e);
+}
+
+static void compile_nodes(graph_t * g, xgraph_t * xg)
 {
     /* build variables */
     node_t *n;
 
-    Last_node = NULL;
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if (find(n) == n)
-	    ND_rep(n) = makeXnode (Xg, agnameof(n));
+	    ND_rep(n) = makeXnode (xg);
     }
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if (ND_rep(n) == 0)
@@ -740,44 +931,37 @@ static void merge(edge_t * e, int minlen, int weight)
     ED_weight(e) += weight;
 }
 
-static void strong(graph_t * g, node_t * t, node_t * h, edge_t * orig)
+static void strong(xgraph_t * xg, node_t * t, node_t * h, edge_t * orig)
 {
     edge_t *e;
-    if ((e = agfindedge(g, t, h)) ||
-	(e = agfindedge(g, h, t)) || (e = agedge(g, t, h, 0, 1)))
-	merge(e, ED_minlen(orig), ED_weight(orig));
-    else
-	agerr(AGERR, "ranking: failure to create strong constraint edge between nodes %s and %s\n", 
-	    agnameof(t), agnameof(h));
+    if (!(e = xfindedge(xg, t, h)) && !(e = xfindedge(xg, h, t)))
+	e = makeXedge(xg, t, h);
+    merge(e, ED_minlen(orig), ED_weight(orig));
 }
 
-static void weak(graph_t * g, node_t * t, node_t * h, edge_t * orig)
+static void weak(xgraph_t * xg, node_t * t, node_t * h, edge_t * orig)
 {
     node_t *v;
     edge_t *e, *f;
-    static int id;
-    char buf[100];
+    int i;
 
-    for (e = agfstin(g, t); e; e = agnxtin(g, e)) {
+    for (i = 0; (e = ND_in(t).list[i]); i++) {
 	/* merge with existing weak edge (e,f) */
 	v = agtail(e);
-	if ((f = agfstout(g, v)) && (aghead(f) == h)) {
+	if ((f = ND_out(v).list[0]) && (aghead(f) == h)) {
 	    return;
 	}
     }
-    if (!e) {
-	snprintf(buf, sizeof(buf), "_weak_%d", id++);
-	v = makeXnode(g, buf);
-	e = agedge(g, v, t, 0, 1);
-	f = agedge(g, v, h, 0, 1);
-    }
+    v = makeXnode(xg);
+    e = makeXedge(xg, v, t);
+    f = makeXedge(xg, v, h);
     ED_minlen(e) = MAX(ED_minlen(e), 0);	/* effectively a nop */
     ED_weight(e) += ED_weight(orig) * BACKWARD_PENALTY;
     ED_minlen(f) = MAX(ED_minlen(f), ED_minlen(orig));
     ED_weight(f) += ED_weight(orig);
 }
 
-static void compile_edges(graph_t * ug, graph_t * Xg)
+static void compile_edges(graph_t * ug, xgraph_t * xg)
 {
     node_t *n;
     edge_t *e;
@@ -807,18 +991,18 @@ static void compile_edges(graph_t * ug, graph_t * Xg)
 		    Xt = Xh;
 		    Xh = temp;
 		}
-		strong(Xg, Xt, Xh, e);
+		strong(xg, Xt, Xh, e);
 	    } else {
 		if (is_a_strong_cluster(tc) || is_a_strong_cluster(hc))
-		    weak(Xg, Xt, Xh, e);
+		    weak(xg, Xt, Xh, e);
 		else
-		    strong(Xg, Xt, Xh, e);
+		    strong(xg, Xt, Xh, e);
 	    }
 	}
     }
 }
 
-static void compile_clusters(graph_t* g, graph_t* Xg, node_t* top, node_t* bot)
+static void compile_clusters(graph_t* g, xgraph_t* xg, node_t* top, node_t* bot)
 {
     node_t *n;
     node_t *rep;
@@ -829,67 +1013,72 @@ static void compile_clusters(graph_t* g, graph_t* Xg, node_t* top, node_t* bot)
 	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	    if (agfstin(g, n) == 0) {
 		rep = ND_rep(find(n));
-		if (!top) top = makeXnode(Xg,TOPNODE);
-		agedge(Xg, top, rep, 0, 1);
+		if (!top) {
+		    if (!xg->top) xg->top = makeXnode(xg);
+		    top = xg->top;
+		}
+		makeXedge(xg, top, rep);
 	    }
 	    if (agfstout(g, n) == 0) {
 		rep = ND_rep(find(n));
-		if (!bot)  bot = makeXnode(Xg,BOTNODE);
-		agedge(Xg, rep, bot, 0, 1);
+		if (!bot) {
+		    if (!xg->bot) xg->bot = makeXnode(xg);
+		    bot = xg->bot;
+		}
+		makeXedge(xg, rep, bot);
 	    }
 	}
 	if (top && bot) {
-	    e = agedge(Xg, top, bot, 0, 1);
+	    e = makeXedge(xg, top, bot);
 	    merge(e, 0, STRONG_CLUSTER_WEIGHT);
 	}
     }
     for (sub = agfstsubg(g); sub; sub = agnxtsubg(sub))
-	compile_clusters(sub, Xg, top, bot);
+	compile_clusters(sub, xg, top, bot);
 }
 
-static void reverse_edge2(graph_t * g, edge_t * e)
+static void reverse_edge2(xgraph_t * xg, edge_t * e)
 {
     edge_t *rev;
 
-    rev = agfindedge(g, aghead(e), agtail(e));
-    if (!rev)
-	rev = agedge(g, aghead(e), agtail(e), 0, 1);
+    rev = makeXedge(xg, aghead(e), agtail(e));
     merge(rev, ED_minlen(e), ED_weight(e));
-    agdelete(g, e);
+    deleteXedge(xg, e);
 }
 
-static void dfs(graph_t * g, node_t * v)
+static void dfs(xgraph_t * xg, node_t * v)
 {
-    edge_t *e, *f;
+    edge_t *e;
     node_t *w;
+    int i;
 
     if (ND_mark(v))
 	return;
     ND_mark(v) = TRUE;
     ND_onstack(v) = true;
-    for (e = agfstout(g, v); e; e = f) {
-	f = agnxtout(g, e);
+    for (i = 0; (e = ND_out(v).list[i]); ) {
 	w = aghead(e);
 	if (ND_onstack(w))
-	    reverse_edge2(g, e);
+	    reverse_edge2(xg, e);	/* removes e from ND_out(v) */
 	else {
 	    if (!ND_mark(w))
-		dfs(g, w);
+		dfs(xg, w);
+	    i++;
 	}
     }
     ND_onstack(v) = false;
 }
 
-static void break_cycles(graph_t * g)
+static void break_cycles(xgraph_t * xg)
 {
     node_t *n;
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+    for (n = GD_nlist(xg->g); n; n = ND_next(n)) {
 	ND_mark(n) = FALSE;
 	ND_onstack(n) = false;
     }
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	dfs(g, n);
+    for (n = GD_nlist(xg->g); n; n = ND_next(n))
+	dfs(xg, n);
 }
 /* setMinMax:
  * This will only be called with the root graph or a cluster
@@ -930,7 +1119,7 @@ static void setMinMax (graph_t* g, int doRoot)
  *
  * rank2 is called with balance=1, which ensures that minrank=0
  */
-static void readout_levels(graph_t * g, graph_t * Xg, int ncc)
+static void readout_levels(graph_t * g, xgraph_t * xg, int ncc)
 {
     node_t *n;
     node_t *xn;
@@ -973,8 +1162,8 @@ static void readout_levels(graph_t * g, graph_t * Xg, int ncc)
 
     setMinMax(g, doRoot);
 
-    /* release fastgraph memory from Xg */
-    for (n = agfstnode(Xg); n; n = agnxtnode(Xg, n)) {
+    /* release fastgraph memory from the constraint graph */
+    for (n = GD_nlist(xg->g); n; n = ND_next(n)) {
 	free_list(ND_in(n));
 	free_list(ND_out(n));
     }
@@ -987,34 +1176,36 @@ static void readout_levels(graph_t * g, graph_t * Xg, int ncc)
 	free (minrk);
 }
 
-static void dfscc(graph_t * g, node_t * n, int cc)
+static void dfscc(node_t * n, int cc)
 {
     edge_t *e;
+    int i;
+
     if (ND_comp(n) == 0) {
 	ND_comp(n) = cc;
-	for (e = agfstout(g, n); e; e = agnxtout(g, e))
-	    dfscc(g, aghead(e), cc);
-	for (e = agfstin(g, n); e; e = agnxtin(g, e))
-	    dfscc(g, agtail(e), cc);
+	for (i = 0; (e = ND_out(n).list[i]); i++)
+	    dfscc(aghead(e), cc);
+	for (i = 0; (e = ND_in(n).list[i]); i++)
+	    dfscc(agtail(e), cc);
     }
 }
 
-static int connect_components(graph_t * g)
+static int connect_components(xgraph_t * xg)
 {
     int cc = 0;
     node_t *n;
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+    for (n = GD_nlist(xg->g); n; n = ND_next(n))
 	ND_comp(n) = 0;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+    for (n = GD_nlist(xg->g); n; n = ND_next(n))
 	if (ND_comp(n) == 0)
-	    dfscc(g, n, ++cc);
+	    dfscc(n, ++cc);
     if (cc > 1) {
-	node_t *root = makeXnode(g, ROOT);
+	node_t *root = makeXnode(xg);
 	int ncc = 1;
-	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (n = GD_nlist(xg->g); n; n = ND_next(n)) {
 	    if (ND_comp(n) == ncc) {
-		(void) agedge(g, root, n, 0, 1);
+		(void) makeXedge(xg, root, n);
 		ncc++;
 	    }
 	}
@@ -1022,43 +1213,37 @@ static int connect_components(graph_t * g)
     return (cc);
 }
 
-static void add_fast_edges (graph_t * g)
+/* order_in_edges:
+ * Out edges are listed in the order they were made. Relist the in edges
+ * in the order of their tails and of the out lists, which is how rank2
+ * has always seen them.
+ */
+static void order_in_edges (xgraph_t * xg)
 {
-    node_t *n;
+    node_t *n, *h;
     edge_t *e;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
-	    elist_append(e, ND_out(n));
-	    elist_append(e, ND_in(aghead(e)));
+    int i;
+
+    for (n = GD_nlist(xg->g); n; n = ND_next(n))
+	ND_in(n).size = 0;
+    for (n = GD_nlist(xg->g); n; n = ND_next(n)) {
+	for (i = 0; (e = ND_out(n).list[i]); i++) {
+	    h = aghead(e);
+	    ND_in(h).list[ND_in(h).size++] = e;
+	    ND_in(h).list[ND_in(h).size] = NULL;
 	}
     }
 }
 
-static void my_init_graph(Agraph_t *g, Agobj_t *graph, void *arg)
-{ int *sz = arg; (void)g; agbindrec(graph,"level graph rec",sz[0],true); }
-static void my_init_node(Agraph_t *g, Agobj_t *node, void *arg)
-{ int *sz = arg; (void)g; agbindrec(node,"level node rec",sz[1],true); }
-static void my_init_edge(Agraph_t *g, Agobj_t *edge, void *arg)
-{ int *sz = arg; (void)g; agbindrec(edge,"level edge rec",sz[2],true); }
-static Agcbdisc_t mydisc = { {my_init_graph,0,0}, {my_init_node,0,0}, {my_init_edge,0,0} };
-
-int infosizes[] = {
-    sizeof(Agraphinfo_t), 
-    sizeof(Agnodeinfo_t),
-    sizeof(Agedgeinfo_t)
-};
-
 void dot2_rank(graph_t * g, aspect_t* asp)
 {
     int ssize;
     int ncc, maxiter = INT_MAX;
     char *s;
-    graph_t *Xg;
+    xgraph_t xg = {0};
 
-    Last_node = NULL;
-    Xg = agopen("level assignment constraints", Agstrictdirected, 0);
-    agbindrec(Xg,"level graph rec",sizeof(Agraphinfo_t),true);
-    agpushdisc(Xg,&mydisc,infosizes);
+    xg.g = agopen("level assignment constraints", Agstrictdirected, 0);
+    agbindrec(xg.g, "level graph rec", sizeof(Agraphinfo_t), true);
 
     edgelabel_ranks(g);
 
@@ -1068,27 +1253,28 @@ void dot2_rank(graph_t * g, aspect_t* asp)
 	maxiter = INT_MAX;
 
     compile_samerank(g, 0);
-    compile_nodes(g, Xg);
-    compile_edges(g, Xg);
-    compile_clusters(g, Xg, 0, 0);
-    break_cycles(Xg);
-    ncc = connect_components(Xg);
-    add_fast_edges (Xg);
-
-    if (asp) {
-	init_UF_size(Xg);
-	initEdgeTypes(Xg);
-    }
+    compile_nodes(g, &xg);
+    compile_edges(g, &xg);
+    compile_clusters(g, &xg, 0, 0);
+    break_cycles(&xg);
+    ncc = connect_components(&xg);
+    order_in_edges (&xg);
+
+    /* The records of the constraint graph start out zeroed, so there is
+     * nothing for init_UF_size and initEdgeTypes to do here for asp.
+     */
+    (void)asp;
 
     if ((s = agget(g, "searchsize")))
 	ssize = atoi(s);
     else
 	ssize = -1;
-    rank2(Xg, 1, maxiter, ssize);
-/* fastgr(Xg); */
-    readout_levels(g, Xg, ncc);
+    rank2(xg.g, 1, maxiter, ssize);
+    readout_levels(g, &xg, ncc);
 #ifdef DEBUG
-    fprintf (stderr, "Xg %d nodes %d edges\n", agnnodes(Xg), agnedges(Xg));
+    fprintf (stderr, "Xg %d nodes\n", xg.n_nodes);
 #endif
-    agclose(Xg);
+    agclose(xg.g);
+    arena_reset(&xg.arena);
+    free(xg.table);
 }
@@ -0,0 +1,99 @@
+/// \file
+/// \brief Implementation of the fork/join helpers declared in workers.h
+
+#include "config.h"
+
+#include <cgraph/alloc.h>
+#include <dotgen/workers.h>
+#include <stdlib.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+
+static pthread_mutex_t cgraph_lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+  pthread_mutex_t lock; ///< protects `next`
+  size_t next;          ///< index of the next call to be claimed
+  size_t n;             ///< total number of calls
+  void (*fn)(void *arg, size_t i);
+  void *arg;
+} job_t;
+
+static void *worker(void *arg) {
+  job_t *job = arg;
+  for (;;) {
+    pthread_mutex_lock(&job->lock);
+    size_t i = job->next;
+    if (i < job->n)
+      ++job->next;
+    pthread_mutex_unlock(&job->lock);
+    if (i >= job->n)
+      break;
+    job->fn(job->arg, i);
+  }
+  return NULL;
+}
+#endif
+
+int dot_threads(Agraph_t *g) {
+  const char *s = agget(g, "threads");
+  if (s == NULL || *s == '\0')
+    return 1;
+  int n = atoi(s);
+  return n > 1 ? n : 1;
+}
+
+bool dot_parallel_available(void) {
+#ifdef HAVE_PTHREAD
+  return true;
+#else
+  return false;
+#endif
+}
+
+void dot_parallel_for(int nthreads, size_t n, void (*fn)(void *arg, size_t i),
+                      void *arg) {
+#ifdef HAVE_PTHREAD
+  if (nthreads > 1 && n > 1) {
+    size_t extra = (size_t)nthreads - 1;
+    if (extra > n - 1)
+      extra = n - 1;
+
+    job_t job = {.next = 0, .n = n, .fn = fn, .arg = arg};
+    pthread_mutex_init(&job.lock, NULL);
+
+    pthread_t *tids = gv_calloc(extra, sizeof(pthread_t));
+    size_t started = 0;
+    for (; started < extra; ++started) {
+      // if we cannot get more threads, make do with what we have
+      if (pthread_create(&tids[started], NULL, worker, &job) != 0)
+        break;
+    }
+    worker(&job);
+    for (size_t i = 0; i < started; ++i)
+      pthread_join(tids[i], NULL);
+
+    free(tids);
+    pthread_mutex_destroy(&job.lock);
+    return;
+  }
+#else
+  (void)nthreads;
+#endif
+
+  for (size_t i = 0; i < n; ++i)
+    fn(arg, i);
+}
+
+void dot_lock(void) {
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&cgraph_lock);
+#endif
+}
+
+void dot_unlock(void) {
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&cgraph_lock);
+#endif
+}
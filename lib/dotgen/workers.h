@@ -0,0 +1,45 @@
+/// \file
+/// \brief Minimal fork/join helpers for the parallel phases of dot
+///
+/// Dot layout phases that operate on independent pieces of a graph (connected
+/// components, clusters, …) can spread that work over a number of threads. The
+/// degree of parallelism is controlled by the `threads` graph attribute and
+/// defaults to 1, in which case all work runs on the calling thread. When
+/// Graphviz is built without thread support every request is serialized.
+///
+/// Worker callbacks must not create or look up cgraph objects without holding
+/// the lock provided below; cgraph dictionaries are not safe for concurrent
+/// access, even for reading.
+
+#pragma once
+
+#include <cgraph/cgraph.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/// number of worker threads requested for laying out `g`
+///
+/// \return A value ≥ 1
+int dot_threads(Agraph_t *g);
+
+/// call `fn(arg, i)` for every `i` in [0, `n`)
+///
+/// Calls are distributed over at most `nthreads` threads, the calling thread
+/// being one of them. Calls are claimed in increasing order of `i` but may
+/// complete in any order. The function returns once all calls have completed.
+///
+/// \param nthreads Maximum number of threads to use
+/// \param n Number of calls to make
+/// \param fn Callback to invoke
+/// \param arg Opaque pointer passed through to `fn`
+void dot_parallel_for(int nthreads, size_t n, void (*fn)(void *arg, size_t i),
+                      void *arg);
+
+/// is `dot_parallel_for` able to run anything concurrently?
+bool dot_parallel_available(void);
+
+/// acquire the lock guarding shared cgraph state from worker threads
+void dot_lock(void);
+
+/// release the lock acquired by `dot_lock`
+void dot_unlock(void);
@@ -50,6 +50,26 @@ extern "C" {
 /* function to convert a polyline into a spline representation */
     PATHPLAN_API void make_polyline(Ppolyline_t line, Ppolyline_t* sline);
 
+/* The routines above return their results in storage owned by the library,
+ * which is reused by the next call. The variants below instead use the
+ * storage in a caller-provided scratch object, so that threads each holding
+ * their own scratch can route concurrently. Results remain valid until the
+ * next call with the same scratch. */
+    typedef struct Pscratch_s Pscratch_t;
+
+    PATHPLAN_API Pscratch_t *Pscratch_new(void);
+    PATHPLAN_API void Pscratch_free(Pscratch_t *scratch);
+
+    PATHPLAN_API int Pshortestpath_r(Pscratch_t *scratch, Ppoly_t * boundary,
+			       Ppoint_t endpoints[2],
+			       Ppolyline_t * output_route);
+    PATHPLAN_API int Proutespline_r(Pscratch_t *scratch, Pedge_t * barriers,
+			      int n_barriers, Ppolyline_t input_route,
+			      Pvector_t endpoint_slopes[2],
+			      Ppolyline_t * output_route);
+    PATHPLAN_API void make_polyline_r(Pscratch_t *scratch, Ppolyline_t line,
+				Ppolyline_t* sline);
+
 #undef PATHPLAN_API
 
 #ifdef __cplusplus
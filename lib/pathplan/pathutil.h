@@ -39,6 +39,18 @@ extern "C" {
 
     PATHUTIL_API int in_poly(Ppoly_t argpoly, Ppoint_t q);
 
+/* working storage behind the reentrant routines of pathplan.h; each part
+ * is allocated by the routine using it on first use */
+struct Pscratch_s {
+    struct shortest_state_s *shortest;	/* Pshortestpath_r */
+    struct route_state_s *route;	/* Proutespline_r */
+    Ppoint_t *ispline;			/* make_polyline_r */
+    int isz;
+};
+
+    void shortest_state_free(struct shortest_state_s *);
+    void route_state_free(struct route_state_s *);
+
 #undef PATHUTIL_API
 #ifdef __cplusplus
 }
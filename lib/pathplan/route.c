@@ -30,15 +30,22 @@ typedef struct tna_t {
 
 #define POINTSIZE sizeof (Ppoint_t)
 
-static Ppoint_t *ops;
-static int opn, opl;
+/* working storage of Proutespline_r, kept between calls */
+struct route_state_s {
+    Ppoint_t *ops;
+    int opn, opl;
+    tna_t *tnas;
+    int tnan;
+};
 
-static int reallyroutespline(Pedge_t *, int,
+typedef struct route_state_s state_t;
+
+static int reallyroutespline(state_t *, Pedge_t *, int,
 			     Ppoint_t *, int, Ppoint_t, Ppoint_t);
 static int mkspline(Ppoint_t *, int, tna_t *, Ppoint_t, Ppoint_t,
 		    Ppoint_t *, Ppoint_t *, Ppoint_t *, Ppoint_t *);
-static int splinefits(Pedge_t *, int, Ppoint_t, Pvector_t, Ppoint_t,
-		      Pvector_t, Ppoint_t *, int);
+static int splinefits(state_t *, Pedge_t *, int, Ppoint_t, Pvector_t,
+		      Ppoint_t, Pvector_t, Ppoint_t *, int);
 static int splineisinside(Pedge_t *, int, Ppoint_t *);
 static int splineintersectsline(Ppoint_t *, Ppoint_t *, double *);
 static void points2coeff(double, double, double, double, double *);
@@ -46,7 +53,7 @@ static void addroot(double, double *, int *);
 
 static Pvector_t normv(Pvector_t);
 
-static int growops(int);
+static int growops(state_t *, int);
 
 static Ppoint_t add(Ppoint_t, Ppoint_t);
 static Ppoint_t sub(Ppoint_t, Ppoint_t);
@@ -69,9 +76,36 @@ static double B23(double t);
 int Proutespline(Pedge_t * edges, int edgen, Ppolyline_t input,
 		 Ppoint_t evs[2], Ppolyline_t * output)
 {
+    static Pscratch_t scratch;
+    return Proutespline_r(&scratch, edges, edgen, input, evs, output);
+}
+
+void route_state_free(state_t *s)
+{
+    if (s == NULL)
+	return;
+    free(s->ops);
+    free(s->tnas);
+    free(s);
+}
+
+/* Proutespline_r:
+ * As Proutespline, using the working storage in scratch. The resulting
+ * spline remains valid until the next call with the same scratch.
+ */
+int Proutespline_r(Pscratch_t *scratch, Pedge_t * edges, int edgen,
+		   Ppolyline_t input, Ppoint_t evs[2], Ppolyline_t * output)
+{
+    state_t *s;
     Ppoint_t *inps;
     int inpn;
 
+    if (scratch->route == NULL) {
+	if (!(scratch->route = calloc(1, sizeof(state_t))))
+	    return -1;
+    }
+    s = scratch->route;
+
     /* unpack into previous format rather than modify legacy code */
     inps = input.ps;
     inpn = input.pn;
@@ -79,20 +113,20 @@ int Proutespline(Pedge_t * edges, int edgen, Ppolyline_t input,
     /* generate the splines */
     evs[0] = normv(evs[0]);
     evs[1] = normv(evs[1]);
-    opl = 0;
-    if (growops(4) < 0) {
+    s->opl = 0;
+    if (growops(s, 4) < 0) {
 	return -1;
     }
-    ops[opl++] = inps[0];
-    if (reallyroutespline(edges, edgen, inps, inpn, evs[0], evs[1]) == -1)
+    s->ops[s->opl++] = inps[0];
+    if (reallyroutespline(s, edges, edgen, inps, inpn, evs[0], evs[1]) == -1)
 	return -1;
-    output->pn = opl;
-    output->ps = ops;
+    output->pn = s->opl;
+    output->ps = s->ops;
 
     return 0;
 }
 
-static int reallyroutespline(Pedge_t * edges, int edgen,
+static int reallyroutespline(state_t *s, Pedge_t * edges, int edgen,
 			     Ppoint_t * inps, int inpn, Ppoint_t ev0,
 			     Ppoint_t ev1)
 {
@@ -101,26 +135,23 @@ static int reallyroutespline(Pedge_t * edges, int edgen,
     double maxd, d, t;
     int maxi, i, spliti;
 
-    static tna_t *tnas;
-    static int tnan;
-
-    if (tnan < inpn) {
-	if (!(tnas = realloc(tnas, sizeof(tna_t) * (size_t)inpn)))
+    if (s->tnan < inpn) {
+	if (!(s->tnas = realloc(s->tnas, sizeof(tna_t) * (size_t)inpn)))
 	    return -1;
-	tnan = inpn;
+	s->tnan = inpn;
     }
-    tnas[0].t = 0;
+    s->tnas[0].t = 0;
     for (i = 1; i < inpn; i++)
-	tnas[i].t = tnas[i - 1].t + dist(inps[i], inps[i - 1]);
+	s->tnas[i].t = s->tnas[i - 1].t + dist(inps[i], inps[i - 1]);
     for (i = 1; i < inpn; i++)
-	tnas[i].t /= tnas[inpn - 1].t;
+	s->tnas[i].t /= s->tnas[inpn - 1].t;
     for (i = 0; i < inpn; i++) {
-	tnas[i].a[0] = scale(ev0, B1(tnas[i].t));
-	tnas[i].a[1] = scale(ev1, B2(tnas[i].t));
+	s->tnas[i].a[0] = scale(ev0, B1(s->tnas[i].t));
+	s->tnas[i].a[1] = scale(ev1, B2(s->tnas[i].t));
     }
-    if (mkspline(inps, inpn, tnas, ev0, ev1, &p1, &v1, &p2, &v2) == -1)
+    if (mkspline(inps, inpn, s->tnas, ev0, ev1, &p1, &v1, &p2, &v2) == -1)
 	return -1;
-    int fit = splinefits(edges, edgen, p1, v1, p2, v2, inps, inpn);
+    int fit = splinefits(s, edges, edgen, p1, v1, p2, v2, inps, inpn);
     if (fit > 0) {
 	return 0;
     }
@@ -130,7 +161,7 @@ static int reallyroutespline(Pedge_t * edges, int edgen,
     cp1 = add(p1, scale(v1, 1 / 3.0));
     cp2 = sub(p2, scale(v2, 1 / 3.0));
     for (maxd = -1, maxi = -1, i = 1; i < inpn - 1; i++) {
-	t = tnas[i].t;
+	t = s->tnas[i].t;
 	p.x = B0(t) * p1.x + B1(t) * cp1.x + B2(t) * cp2.x + B3(t) * p2.x;
 	p.y = B0(t) * p1.y + B1(t) * cp1.y + B2(t) * cp2.y + B3(t) * p2.y;
 	if ((d = dist(p, inps[i])) > maxd)
@@ -140,11 +171,12 @@ static int reallyroutespline(Pedge_t * edges, int edgen,
     splitv1 = normv(sub(inps[spliti], inps[spliti - 1]));
     splitv2 = normv(sub(inps[spliti + 1], inps[spliti]));
     splitv = normv(add(splitv1, splitv2));
-    if (reallyroutespline(edges, edgen, inps, spliti + 1, ev0, splitv) < 0) {
+    if (reallyroutespline(s, edges, edgen, inps, spliti + 1, ev0,
+                          splitv) < 0) {
 	return -1;
     }
-    if (reallyroutespline(edges, edgen, &inps[spliti], inpn - spliti, splitv,
-                          ev1) < 0) {
+    if (reallyroutespline(s, edges, edgen, &inps[spliti], inpn - spliti,
+                          splitv, ev1) < 0) {
 	return -1;
     }
     return 0;
@@ -203,7 +235,7 @@ static double dist_n(Ppoint_t * p, int n)
     return rv;
 }
 
-static int splinefits(Pedge_t * edges, int edgen, Ppoint_t pa,
+static int splinefits(state_t *s, Pedge_t * edges, int edgen, Ppoint_t pa,
 		      Pvector_t va, Ppoint_t pb, Pvector_t vb,
 		      Ppoint_t * inps, int inpn)
 {
@@ -239,11 +271,12 @@ static int splinefits(Pedge_t * edges, int edgen, Ppoint_t pa,
 	first = 0;
 
 	if (splineisinside(edges, edgen, &sps[0])) {
-	    if (growops(opl + 4) < 0) {
+	    if (growops(s, s->opl + 4) < 0) {
 		return -1;
 	    }
 	    for (pi = 1; pi < 4; pi++)
-		ops[opl].x = sps[pi].x, ops[opl++].y = sps[pi].y;
+		s->ops[s->opl].x = sps[pi].x,
+		    s->ops[s->opl++].y = sps[pi].y;
 #if defined(DEBUG) && DEBUG >= 1
 	    fprintf(stderr, "success: %f %f\n", a, a);
 #endif
@@ -253,11 +286,12 @@ static int splinefits(Pedge_t * edges, int edgen, Ppoint_t pa,
 	// last loop iteration) below?
 	if (a < 0.005) {
 	    if (forceflag) {
-		if (growops(opl + 4) < 0) {
+		if (growops(s, s->opl + 4) < 0) {
 		    return -1;
 		}
 		for (pi = 1; pi < 4; pi++)
-		    ops[opl].x = sps[pi].x, ops[opl++].y = sps[pi].y;
+		    s->ops[s->opl].x = sps[pi].x,
+			s->ops[s->opl++].y = sps[pi].y;
 #if defined(DEBUG) && DEBUG >= 1
 		fprintf(stderr, "forced straight line: %f %f\n", a, a);
 #endif
@@ -416,14 +450,14 @@ static Pvector_t normv(Pvector_t v)
     return v;
 }
 
-static int growops(int newopn)
+static int growops(state_t *s, int newopn)
 {
-    if (newopn <= opn)
+    if (newopn <= s->opn)
 	return 0;
-    if (!(ops = realloc(ops, POINTSIZE * (size_t)newopn))) {
+    if (!(s->ops = realloc(s->ops, POINTSIZE * (size_t)newopn))) {
 	return -1;
     }
-    opn = newopn;
+    s->opn = newopn;
     return 0;
 }
 
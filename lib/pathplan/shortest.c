@@ -55,38 +55,44 @@ typedef struct deque_t {
     int pnlpn, fpnlpi, lpnlpi, apex;
 } deque_t;
 
-static pointnlink_t *pnls, **pnlps;
-static size_t pnln;
-static int pnll;
+/* working storage of Pshortestpath_r, kept between calls */
+struct shortest_state_s {
+    pointnlink_t *pnls, **pnlps;
+    size_t pnln;
+    int pnll;
 
-static triangle_t *tris;
-static size_t trin;
-static int tril;
+    triangle_t *tris;
+    size_t trin;
+    int tril;
 
-static deque_t dq;
+    deque_t dq;
 
-static Ppoint_t *ops;
-static int opn;
+    Ppoint_t *ops;
+    int opn;
+};
 
-static int triangulate(pointnlink_t **, int);
+typedef struct shortest_state_s state_t;
+
+static int triangulate(state_t *, pointnlink_t **, int);
 static bool isdiagonal(int, int, pointnlink_t **, int);
-static int loadtriangle(pointnlink_t *, pointnlink_t *, pointnlink_t *);
-static void connecttris(long, long);
-static bool marktripath(long, long);
+static int loadtriangle(state_t *, pointnlink_t *, pointnlink_t *,
+			pointnlink_t *);
+static void connecttris(state_t *, long, long);
+static bool marktripath(state_t *, long, long);
 
-static void add2dq(int, pointnlink_t *);
-static void splitdq(int, int);
-static int finddqsplit(pointnlink_t *);
+static void add2dq(state_t *, int, pointnlink_t *);
+static void splitdq(state_t *, int, int);
+static int finddqsplit(state_t *, pointnlink_t *);
 
 static int ccw(Ppoint_t *, Ppoint_t *, Ppoint_t *);
 static bool intersects(Ppoint_t *, Ppoint_t *, Ppoint_t *, Ppoint_t *);
 static bool between(Ppoint_t *, Ppoint_t *, Ppoint_t *);
-static int pointintri(long, Ppoint_t *);
+static int pointintri(state_t *, long, Ppoint_t *);
 
-static int growpnls(size_t);
-static int growtris(size_t);
-static int growdq(int);
-static int growops(int);
+static int growpnls(state_t *, size_t);
+static int growtris(state_t *, size_t);
+static int growdq(state_t *, int);
+static int growops(state_t *, int);
 
 /* Pshortestpath:
  * Find a shortest path contained in the polygon polyp going between the
@@ -95,6 +101,30 @@ static int growops(int);
  */
 int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 {
+    static Pscratch_t scratch;
+    return Pshortestpath_r(&scratch, polyp, eps, output);
+}
+
+void shortest_state_free(state_t *s)
+{
+    if (s == NULL)
+	return;
+    free(s->pnls);
+    free(s->pnlps);
+    free(s->tris);
+    free(s->dq.pnlps);
+    free(s->ops);
+    free(s);
+}
+
+/* Pshortestpath_r:
+ * As Pshortestpath, using the working storage in scratch. The resulting
+ * polyline remains valid until the next call with the same scratch.
+ */
+int Pshortestpath_r(Pscratch_t *scratch, Ppoly_t * polyp, Ppoint_t eps[2],
+		    Ppolyline_t * output)
+{
+    state_t *s;
     int pi, minpi;
     double minx;
     Ppoint_t p1, p2, p3;
@@ -107,15 +137,24 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
     int pnli;
 #endif
 
+    if (scratch->shortest == NULL) {
+	scratch->shortest = calloc(1, sizeof(state_t));
+	if (scratch->shortest == NULL) {
+	    prerror("cannot allocate state");
+	    return -2;
+	}
+    }
+    s = scratch->shortest;
+
     /* make space */
     assert(polyp->pn >= 0);
-    if (growpnls((size_t)polyp->pn) != 0)
+    if (growpnls(s, (size_t)polyp->pn) != 0)
 	return -2;
-    pnll = 0;
-    tril = 0;
-    if (growdq(polyp->pn * 2) != 0)
+    s->pnll = 0;
+    s->tril = 0;
+    if (growdq(s, polyp->pn * 2) != 0)
 	return -2;
-    dq.fpnlpi = dq.pnlpn / 2, dq.lpnlpi = dq.fpnlpi - 1;
+    s->dq.fpnlpi = s->dq.pnlpn / 2, s->dq.lpnlpi = s->dq.fpnlpi - 1;
 
     /* make sure polygon is CCW and load pnls array */
     for (pi = 0, minx = HUGE_VAL, minpi = -1; pi < polyp->pn; pi++) {
@@ -132,94 +171,94 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 		&& polyp->ps[pi].x == polyp->ps[pi + 1].x
 		&& polyp->ps[pi].y == polyp->ps[pi + 1].y)
 		continue;
-	    pnls[pnll].pp = &polyp->ps[pi];
-	    pnls[pnll].link = &pnls[pnll % polyp->pn];
-	    pnlps[pnll] = &pnls[pnll];
-	    pnll++;
+	    s->pnls[s->pnll].pp = &polyp->ps[pi];
+	    s->pnls[s->pnll].link = &s->pnls[s->pnll % polyp->pn];
+	    s->pnlps[s->pnll] = &s->pnls[s->pnll];
+	    s->pnll++;
 	}
     } else {
 	for (pi = 0; pi < polyp->pn; pi++) {
 	    if (pi > 0 && polyp->ps[pi].x == polyp->ps[pi - 1].x &&
 		polyp->ps[pi].y == polyp->ps[pi - 1].y)
 		continue;
-	    pnls[pnll].pp = &polyp->ps[pi];
-	    pnls[pnll].link = &pnls[pnll % polyp->pn];
-	    pnlps[pnll] = &pnls[pnll];
-	    pnll++;
+	    s->pnls[s->pnll].pp = &polyp->ps[pi];
+	    s->pnls[s->pnll].link = &s->pnls[s->pnll % polyp->pn];
+	    s->pnlps[s->pnll] = &s->pnls[s->pnll];
+	    s->pnll++;
 	}
     }
 
 #if defined(DEBUG) && DEBUG >= 1
-    fprintf(stderr, "points\n%d\n", pnll);
-    for (pnli = 0; pnli < pnll; pnli++)
-	fprintf(stderr, "%f %f\n", pnls[pnli].pp->x, pnls[pnli].pp->y);
+    fprintf(stderr, "points\n%d\n", s->pnll);
+    for (pnli = 0; pnli < s->pnll; pnli++)
+	fprintf(stderr, "%f %f\n", s->pnls[pnli].pp->x, s->pnls[pnli].pp->y);
 #endif
 
     /* generate list of triangles */
-    if (triangulate(pnlps, pnll))
+    if (triangulate(s, s->pnlps, s->pnll))
 	return -2;
 
 #if defined(DEBUG) && DEBUG >= 2
-    fprintf(stderr, "triangles\n%d\n", tril);
-    for (trii = 0; trii < tril; trii++)
+    fprintf(stderr, "triangles\n%d\n", s->tril);
+    for (trii = 0; trii < s->tril; trii++)
 	for (ei = 0; ei < 3; ei++)
-	    fprintf(stderr, "%f %f\n", tris[trii].e[ei].pnl0p->pp->x,
-		    tris[trii].e[ei].pnl0p->pp->y);
+	    fprintf(stderr, "%f %f\n", s->tris[trii].e[ei].pnl0p->pp->x,
+		    s->tris[trii].e[ei].pnl0p->pp->y);
 #endif
 
     /* connect all pairs of triangles that share an edge */
-    for (trii = 0; trii < tril; trii++)
-	for (trij = trii + 1; trij < tril; trij++)
-	    connecttris(trii, trij);
+    for (trii = 0; trii < s->tril; trii++)
+	for (trij = trii + 1; trij < s->tril; trij++)
+	    connecttris(s, trii, trij);
 
     /* find first and last triangles */
-    for (trii = 0; trii < tril; trii++)
-	if (pointintri(trii, &eps[0]))
+    for (trii = 0; trii < s->tril; trii++)
+	if (pointintri(s, trii, &eps[0]))
 	    break;
-    if (trii == tril) {
+    if (trii == s->tril) {
 	prerror("source point not in any triangle");
 	return -1;
     }
     ftrii = trii;
-    for (trii = 0; trii < tril; trii++)
-	if (pointintri(trii, &eps[1]))
+    for (trii = 0; trii < s->tril; trii++)
+	if (pointintri(s, trii, &eps[1]))
 	    break;
-    if (trii == tril) {
+    if (trii == s->tril) {
 	prerror("destination point not in any triangle");
 	return -1;
     }
     ltrii = trii;
 
     /* mark the strip of triangles from eps[0] to eps[1] */
-    if (!marktripath(ftrii, ltrii)) {
+    if (!marktripath(s, ftrii, ltrii)) {
 	prerror("cannot find triangle path");
 	/* a straight line is better than failing */
-	if (growops(2) != 0)
+	if (growops(s, 2) != 0)
 		return -2;
 	output->pn = 2;
-	ops[0] = eps[0], ops[1] = eps[1];
-	output->ps = ops;
+	s->ops[0] = eps[0], s->ops[1] = eps[1];
+	output->ps = s->ops;
 	return 0;
     }
 
     /* if endpoints in same triangle, use a single line */
     if (ftrii == ltrii) {
-	if (growops(2) != 0)
+	if (growops(s, 2) != 0)
 		return -2;
 	output->pn = 2;
-	ops[0] = eps[0], ops[1] = eps[1];
-	output->ps = ops;
+	s->ops[0] = eps[0], s->ops[1] = eps[1];
+	output->ps = s->ops;
 	return 0;
     }
 
     /* build funnel and shortest path linked list (in add2dq) */
     epnls[0].pp = &eps[0], epnls[0].link = NULL;
     epnls[1].pp = &eps[1], epnls[1].link = NULL;
-    add2dq(DQ_FRONT, &epnls[0]);
-    dq.apex = dq.fpnlpi;
+    add2dq(s, DQ_FRONT, &epnls[0]);
+    s->dq.apex = s->dq.fpnlpi;
     trii = ftrii;
     while (trii != -1) {
-	trip = &tris[trii];
+	trip = &s->tris[trii];
 	trip->mark = 2;
 
 	/* find the left and right points of the exiting edge */
@@ -227,11 +266,11 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 	    if (trip->e[ei].rtp && trip->e[ei].rtp->mark == 1)
 		break;
 	if (ei == 3) {		/* in last triangle */
-	    if (ccw(&eps[1], dq.pnlps[dq.fpnlpi]->pp,
-		    dq.pnlps[dq.lpnlpi]->pp) == ISCCW)
-		lpnlp = dq.pnlps[dq.lpnlpi], rpnlp = &epnls[1];
+	    if (ccw(&eps[1], s->dq.pnlps[s->dq.fpnlpi]->pp,
+		    s->dq.pnlps[s->dq.lpnlpi]->pp) == ISCCW)
+		lpnlp = s->dq.pnlps[s->dq.lpnlpi], rpnlp = &epnls[1];
 	    else
-		lpnlp = &epnls[1], rpnlp = dq.pnlps[dq.lpnlpi];
+		lpnlp = &epnls[1], rpnlp = s->dq.pnlps[s->dq.lpnlpi];
 	} else {
 	    pnlp = trip->e[(ei + 1) % 3].pnl1p;
 	    if (ccw(trip->e[ei].pnl0p->pp, pnlp->pp,
@@ -243,32 +282,32 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 
 	/* update deque */
 	if (trii == ftrii) {
-	    add2dq(DQ_BACK, lpnlp);
-	    add2dq(DQ_FRONT, rpnlp);
+	    add2dq(s, DQ_BACK, lpnlp);
+	    add2dq(s, DQ_FRONT, rpnlp);
 	} else {
-	    if (dq.pnlps[dq.fpnlpi] != rpnlp
-		&& dq.pnlps[dq.lpnlpi] != rpnlp) {
+	    if (s->dq.pnlps[s->dq.fpnlpi] != rpnlp
+		&& s->dq.pnlps[s->dq.lpnlpi] != rpnlp) {
 		/* add right point to deque */
-		splitindex = finddqsplit(rpnlp);
-		splitdq(DQ_BACK, splitindex);
-		add2dq(DQ_FRONT, rpnlp);
+		splitindex = finddqsplit(s, rpnlp);
+		splitdq(s, DQ_BACK, splitindex);
+		add2dq(s, DQ_FRONT, rpnlp);
 		/* if the split is behind the apex, then reset apex */
-		if (splitindex > dq.apex)
-		    dq.apex = splitindex;
+		if (splitindex > s->dq.apex)
+		    s->dq.apex = splitindex;
 	    } else {
 		/* add left point to deque */
-		splitindex = finddqsplit(lpnlp);
-		splitdq(DQ_FRONT, splitindex);
-		add2dq(DQ_BACK, lpnlp);
+		splitindex = finddqsplit(s, lpnlp);
+		splitdq(s, DQ_FRONT, splitindex);
+		add2dq(s, DQ_BACK, lpnlp);
 		/* if the split is in front of the apex, then reset apex */
-		if (splitindex < dq.apex)
-		    dq.apex = splitindex;
+		if (splitindex < s->dq.apex)
+		    s->dq.apex = splitindex;
 	    }
 	}
 	trii = -1;
 	for (ei = 0; ei < 3; ei++)
 	    if (trip->e[ei].rtp && trip->e[ei].rtp->mark == 1) {
-		trii = trip->e[ei].rtp - tris;
+		trii = trip->e[ei].rtp - s->tris;
 		break;
 	    }
     }
@@ -282,18 +321,18 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 
     for (pi = 0, pnlp = &epnls[1]; pnlp; pnlp = pnlp->link)
 	pi++;
-    if (growops(pi) != 0)
+    if (growops(s, pi) != 0)
 	return -2;
     output->pn = pi;
     for (pi = pi - 1, pnlp = &epnls[1]; pnlp; pi--, pnlp = pnlp->link)
-	ops[pi] = *pnlp->pp;
-    output->ps = ops;
+	s->ops[pi] = *pnlp->pp;
+    output->ps = s->ops;
 
     return 0;
 }
 
 /* triangulate polygon */
-static int triangulate(pointnlink_t **points, int point_count) {
+static int triangulate(state_t *s, pointnlink_t **points, int point_count) {
     int pnli, pnlip1, pnlip2;
 
 	if (point_count > 3)
@@ -304,17 +343,17 @@ static int triangulate(pointnlink_t **points, int point_count) {
 			pnlip2 = (pnli + 2) % point_count;
 			if (isdiagonal(pnli, pnlip2, points, point_count))
 			{
-				if (loadtriangle(points[pnli], points[pnlip1], points[pnlip2]) != 0)
+				if (loadtriangle(s, points[pnli], points[pnlip1], points[pnlip2]) != 0)
 					return -1;
 				for (pnli = pnlip1; pnli < point_count - 1; pnli++)
 					points[pnli] = points[pnli + 1];
-				return triangulate(points, point_count - 1);
+				return triangulate(s, points, point_count - 1);
 			}
 		}
 		prerror("triangulation failed");
     } 
 	else {
-		if (loadtriangle(points[0], points[1], points[2]) != 0)
+		if (loadtriangle(s, points[0], points[1], points[2]) != 0)
 			return -1;
 	}
 
@@ -350,18 +389,18 @@ static bool isdiagonal(int pnli, int pnlip2, pointnlink_t **points,
     return true;
 }
 
-static int loadtriangle(pointnlink_t * pnlap, pointnlink_t * pnlbp,
-			 pointnlink_t * pnlcp)
+static int loadtriangle(state_t *s, pointnlink_t * pnlap,
+			pointnlink_t * pnlbp, pointnlink_t * pnlcp)
 {
     triangle_t *trip;
     int ei;
 
     /* make space */
-    if (tril >= 0 && (size_t)tril >= trin) {
-	if (growtris(trin + 20) != 0)
+    if (s->tril >= 0 && (size_t)s->tril >= s->trin) {
+	if (growtris(s, s->trin + 20) != 0)
 		return -1;
     }
-    trip = &tris[tril++];
+    trip = &s->tris[s->tril++];
     trip->mark = 0;
     trip->e[0].pnl0p = pnlap, trip->e[0].pnl1p = pnlbp, trip->e[0].rtp = NULL;
     trip->e[1].pnl0p = pnlbp, trip->e[1].pnl1p = pnlcp, trip->e[1].rtp = NULL;
@@ -373,14 +412,14 @@ static int loadtriangle(pointnlink_t * pnlap, pointnlink_t * pnlbp,
 }
 
 /* connect a pair of triangles at their common edge (if any) */
-static void connecttris(long tri1, long tri2) {
+static void connecttris(state_t *s, long tri1, long tri2) {
     triangle_t *tri1p, *tri2p;
     int ei, ej;
 
     for (ei = 0; ei < 3; ei++) {
 	for (ej = 0; ej < 3; ej++) {
-	    tri1p = &tris[tri1];
-	    tri2p = &tris[tri2];
+	    tri1p = &s->tris[tri1];
+	    tri2p = &s->tris[tri2];
 	    if ((tri1p->e[ei].pnl0p->pp == tri2p->e[ej].pnl0p->pp &&
 		 tri1p->e[ei].pnl1p->pp == tri2p->e[ej].pnl1p->pp) ||
 		(tri1p->e[ei].pnl0p->pp == tri2p->e[ej].pnl1p->pp &&
@@ -391,57 +430,57 @@ static void connecttris(long tri1, long tri2) {
 }
 
 /* find and mark path from trii, to trij */
-static bool marktripath(long trii, long trij) {
+static bool marktripath(state_t *s, long trii, long trij) {
     int ei;
 
-    if (tris[trii].mark)
+    if (s->tris[trii].mark)
 	return false;
-    tris[trii].mark = 1;
+    s->tris[trii].mark = 1;
     if (trii == trij)
 	return true;
     for (ei = 0; ei < 3; ei++)
-	if (tris[trii].e[ei].rtp &&
-	    marktripath(tris[trii].e[ei].rtp - tris, trij))
+	if (s->tris[trii].e[ei].rtp &&
+	    marktripath(s, s->tris[trii].e[ei].rtp - s->tris, trij))
 	    return true;
-    tris[trii].mark = 0;
+    s->tris[trii].mark = 0;
     return false;
 }
 
 /* add a new point to the deque, either front or back */
-static void add2dq(int side, pointnlink_t * pnlp)
+static void add2dq(state_t *s, int side, pointnlink_t * pnlp)
 {
     if (side == DQ_FRONT) {
-	if (dq.lpnlpi - dq.fpnlpi >= 0)
-	    pnlp->link = dq.pnlps[dq.fpnlpi];	/* shortest path links */
-	dq.fpnlpi--;
-	dq.pnlps[dq.fpnlpi] = pnlp;
+	if (s->dq.lpnlpi - s->dq.fpnlpi >= 0)
+	    pnlp->link = s->dq.pnlps[s->dq.fpnlpi];	/* shortest path links */
+	s->dq.fpnlpi--;
+	s->dq.pnlps[s->dq.fpnlpi] = pnlp;
     } else {
-	if (dq.lpnlpi - dq.fpnlpi >= 0)
-	    pnlp->link = dq.pnlps[dq.lpnlpi];	/* shortest path links */
-	dq.lpnlpi++;
-	dq.pnlps[dq.lpnlpi] = pnlp;
+	if (s->dq.lpnlpi - s->dq.fpnlpi >= 0)
+	    pnlp->link = s->dq.pnlps[s->dq.lpnlpi];	/* shortest path links */
+	s->dq.lpnlpi++;
+	s->dq.pnlps[s->dq.lpnlpi] = pnlp;
     }
 }
 
-static void splitdq(int side, int index)
+static void splitdq(state_t *s, int side, int index)
 {
     if (side == DQ_FRONT)
-	dq.lpnlpi = index;
+	s->dq.lpnlpi = index;
     else
-	dq.fpnlpi = index;
+	s->dq.fpnlpi = index;
 }
 
-static int finddqsplit(pointnlink_t * pnlp)
+static int finddqsplit(state_t *s, pointnlink_t * pnlp)
 {
     int index;
 
-    for (index = dq.fpnlpi; index < dq.apex; index++)
-	if (ccw(dq.pnlps[index + 1]->pp, dq.pnlps[index]->pp, pnlp->pp) == ISCCW)
+    for (index = s->dq.fpnlpi; index < s->dq.apex; index++)
+	if (ccw(s->dq.pnlps[index + 1]->pp, s->dq.pnlps[index]->pp, pnlp->pp) == ISCCW)
 	    return index;
-    for (index = dq.lpnlpi; index > dq.apex; index--)
-	if (ccw(dq.pnlps[index - 1]->pp, dq.pnlps[index]->pp, pnlp->pp) == ISCW)
+    for (index = s->dq.lpnlpi; index > s->dq.apex; index--)
+	if (ccw(s->dq.pnlps[index - 1]->pp, s->dq.pnlps[index]->pp, pnlp->pp) == ISCW)
 	    return index;
-    return dq.apex;
+    return s->dq.apex;
 }
 
 /* ccw test: CCW, CW, or co-linear */
@@ -488,66 +527,66 @@ static bool between(Ppoint_t * pap, Ppoint_t * pbp, Ppoint_t * pcp)
 	p2.x * p2.x + p2.y * p2.y <= p1.x * p1.x + p1.y * p1.y;
 }
 
-static int pointintri(long trii, Ppoint_t *pp) {
+static int pointintri(state_t *s, long trii, Ppoint_t *pp) {
     int ei, sum;
 
     for (ei = 0, sum = 0; ei < 3; ei++)
-	if (ccw(tris[trii].e[ei].pnl0p->pp, tris[trii].e[ei].pnl1p->pp, pp) != ISCW)
+	if (ccw(s->tris[trii].e[ei].pnl0p->pp, s->tris[trii].e[ei].pnl1p->pp, pp) != ISCW)
 	    sum++;
     return sum == 3 || sum == 0;
 }
 
-static int growpnls(size_t newpnln) {
-    if (newpnln <= pnln)
+static int growpnls(state_t *s, size_t newpnln) {
+    if (newpnln <= s->pnln)
 	return 0;
-    pnls = realloc(pnls, POINTNLINKSIZE * newpnln);
-    if (pnls == NULL) {
-	prerror("cannot realloc pnls");
+    s->pnls = realloc(s->pnls, POINTNLINKSIZE * newpnln);
+    if (s->pnls == NULL) {
+	prerror("cannot realloc s->pnls");
 	return -1;
     }
-    pnlps = realloc(pnlps, POINTNLINKPSIZE * newpnln);
-    if (pnlps == NULL) {
-	prerror("cannot realloc pnlps");
+    s->pnlps = realloc(s->pnlps, POINTNLINKPSIZE * newpnln);
+    if (s->pnlps == NULL) {
+	prerror("cannot realloc s->pnlps");
 	return -1;
     }
-    pnln = newpnln;
+    s->pnln = newpnln;
     return 0;
 }
 
-static int growtris(size_t newtrin) {
-    tris = realloc(tris, TRIANGLESIZE * newtrin);
-    if (tris == NULL) {
-	prerror("cannot realloc tris");
+static int growtris(state_t *s, size_t newtrin) {
+    s->tris = realloc(s->tris, TRIANGLESIZE * newtrin);
+    if (s->tris == NULL) {
+	prerror("cannot realloc s->tris");
 	return -1;
     }
-    trin = newtrin;
+    s->trin = newtrin;
 
     return 0;
 }
 
-static int growdq(int newdqn)
+static int growdq(state_t *s, int newdqn)
 {
-    if (newdqn <= dq.pnlpn)
+    if (newdqn <= s->dq.pnlpn)
 	return 0;
-    dq.pnlps = realloc(dq.pnlps, POINTNLINKPSIZE * newdqn);
-    if (dq.pnlps == NULL) {
-	prerror("cannot realloc dq.pnls");
+    s->dq.pnlps = realloc(s->dq.pnlps, POINTNLINKPSIZE * newdqn);
+    if (s->dq.pnlps == NULL) {
+	prerror("cannot realloc s->dq.pnls");
 	return -1;
     }
-    dq.pnlpn = newdqn;
+    s->dq.pnlpn = newdqn;
     return 0;
 }
 
-static int growops(int newopn)
+static int growops(state_t *s, int newopn)
 {
-    if (newopn <= opn)
+    if (newopn <= s->opn)
 	return 0;
-    ops = realloc(ops, POINTSIZE * newopn);
-    if (ops == NULL) {
-	prerror("cannot realloc ops");
+    s->ops = realloc(s->ops, POINTSIZE * newopn);
+    if (s->ops == NULL) {
+	prerror("cannot realloc s->ops");
 	return -1;
     }
-    opn = newopn;
+    s->opn = newopn;
 
     return 0;
 }
@@ -56,15 +56,22 @@ int Ppolybarriers(Ppoly_t ** polys, int npolys, Pedge_t ** barriers,
 void
 make_polyline(Ppolyline_t line, Ppolyline_t* sline)
 {
-    static int isz = 0;
-    static Ppoint_t* ispline = 0;
+    static Pscratch_t scratch;
+    make_polyline_r(&scratch, line, sline);
+}
+
+void
+make_polyline_r(Pscratch_t *scratch, Ppolyline_t line, Ppolyline_t* sline)
+{
     int i, j;
     int npts = 4 + 3*(line.pn-2);
 
-    if (npts > isz) {
-	ispline = gv_recalloc(ispline, (size_t)isz, (size_t)npts, sizeof(Ppoint_t));
-	isz = npts;
+    if (npts > scratch->isz) {
+	scratch->ispline = gv_recalloc(scratch->ispline, (size_t)scratch->isz,
+	                               (size_t)npts, sizeof(Ppoint_t));
+	scratch->isz = npts;
     }
+    Ppoint_t *ispline = scratch->ispline;
 
     j = i = 0;
     ispline[j+1] = ispline[j] = line.ps[i];
@@ -80,6 +87,21 @@ make_polyline(Ppolyline_t line, Ppolyline_t* sline)
     sline->ps = ispline;
 }
 
+Pscratch_t *Pscratch_new(void)
+{
+    return gv_alloc(sizeof(Pscratch_t));
+}
+
+void Pscratch_free(Pscratch_t *scratch)
+{
+    if (scratch == NULL)
+	return;
+    shortest_state_free(scratch->shortest);
+    route_state_free(scratch->route);
+    free(scratch->ispline);
+    free(scratch);
+}
+
 /**
  * @dir lib/pathplan
  * @brief finds and smooths shortest paths, API pathplan.h
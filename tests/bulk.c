@@ -0,0 +1,100 @@
+/// \file
+/// \brief graphs built with agnodes/agedges should match those built one
+/// object at a time with agnode/agedge
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *names[] = {"a", "b", "c", "a", "d", "e", "b", "f"};
+#define NNAMES (sizeof(names) / sizeof(names[0]))
+
+static const size_t ends[] = {0, 1, 1, 2, 2, 0, 4, 4, 5, 3, 7, 6, 0, 1, 6, 2};
+#define NEDGES (sizeof(ends) / sizeof(ends[0]) / 2)
+
+static Agraph_t *build(Agdesc_t desc, int bulk) {
+  Agraph_t *g = agopen("g", desc, NULL);
+  assert(g != NULL);
+  agattr(g, AGEDGE, "color", "red");
+
+  // a node that exists beforehand
+  (void)agnode(g, "e", 1);
+
+  // construct the rest in a subgraph, so every ancestor is involved
+  Agraph_t *sg = agsubg(g, "s", 1);
+  Agnode_t *nodes[NNAMES];
+  if (bulk) {
+    if (agnodes(sg, names, NNAMES, nodes) != 0)
+      fprintf(stderr, "agnodes failed\n");
+    (void)agedges(sg, nodes, ends, NEDGES, NULL);
+  } else {
+    for (size_t i = 0; i < NNAMES; i++)
+      nodes[i] = agnode(sg, names[i], 1);
+    for (size_t i = 0; i < NEDGES; i++)
+      (void)agedge(sg, nodes[ends[2 * i]], nodes[ends[2 * i + 1]], NULL, 1);
+  }
+  return g;
+}
+
+static int compare(Agraph_t *g1, Agraph_t *g2) {
+  int ret = EXIT_SUCCESS;
+  if (agnnodes(g1) != agnnodes(g2) || agnedges(g1) != agnedges(g2)) {
+    fprintf(stderr, "%s: %d/%d nodes, %d/%d edges\n", agnameof(g1),
+            agnnodes(g1), agnnodes(g2), agnedges(g1), agnedges(g2));
+    ret = EXIT_FAILURE;
+  }
+  Agnode_t *n1 = agfstnode(g1), *n2 = agfstnode(g2);
+  for (; n1 && n2; n1 = agnxtnode(g1, n1), n2 = agnxtnode(g2, n2)) {
+    if (strcmp(agnameof(n1), agnameof(n2)) != 0) {
+      fprintf(stderr, "node %s != %s\n", agnameof(n1), agnameof(n2));
+      ret = EXIT_FAILURE;
+    }
+    Agedge_t *e1 = agfstout(g1, n1), *e2 = agfstout(g2, n2);
+    for (; e1 && e2; e1 = agnxtout(g1, e1), e2 = agnxtout(g2, e2)) {
+      if (strcmp(agnameof(aghead(e1)), agnameof(aghead(e2))) != 0 ||
+          strcmp(agget(e1, "color"), agget(e2, "color")) != 0) {
+        fprintf(stderr, "edge %s -> %s != %s\n", agnameof(n1),
+                agnameof(aghead(e1)), agnameof(aghead(e2)));
+        ret = EXIT_FAILURE;
+      }
+    }
+    if (e1 || e2) {
+      fprintf(stderr, "out edges of %s differ\n", agnameof(n1));
+      ret = EXIT_FAILURE;
+    }
+    for (e1 = agfstin(g1, n1), e2 = agfstin(g2, n2); e1 && e2;
+         e1 = agnxtin(g1, e1), e2 = agnxtin(g2, e2)) {
+      if (strcmp(agnameof(agtail(e1)), agnameof(agtail(e2))) != 0) {
+        fprintf(stderr, "edge %s -> %s != %s\n", agnameof(agtail(e1)),
+                agnameof(n1), agnameof(agtail(e2)));
+        ret = EXIT_FAILURE;
+      }
+    }
+    if (e1 || e2) {
+      fprintf(stderr, "in edges of %s differ\n", agnameof(n1));
+      ret = EXIT_FAILURE;
+    }
+  }
+  return ret;
+}
+
+int main(void) {
+  int ret = EXIT_SUCCESS;
+  Agdesc_t descs[] = {Agdirected, Agstrictdirected, Agundirected};
+
+  for (size_t i = 0; i < sizeof(descs) / sizeof(descs[0]); i++) {
+    Agraph_t *g1 = build(descs[i], 0);
+    Agraph_t *g2 = build(descs[i], 1);
+    if (compare(g1, g2) != EXIT_SUCCESS ||
+        compare(agsubg(g1, "s", 0), agsubg(g2, "s", 0)) != EXIT_SUCCESS) {
+      fprintf(stderr, "graph kind %zu differs\n", i);
+      ret = EXIT_FAILURE;
+    }
+    agclose(g1);
+    agclose(g2);
+  }
+
+  return ret;
+}
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+
+"""
+micro-benchmark for crossing minimization in dot on wide ranks
+
+Crossing minimization time is dominated by counting crossings between adjacent
+ranks, which scales with the width of those ranks. Long edges are broken into
+chains of virtual nodes, so even a modest number of them produces ranks that
+are thousands of nodes wide. This script generates such a graph and times one
+or more `dot` binaries laying it out, e.g. to compare a build against an
+earlier one:
+
+  ./mincross_benchmark.py --width 400 --span 8 ./old/dot ./new/dot
+"""
+
+import argparse
+import random
+import subprocess
+import sys
+import time
+from typing import List
+
+def generate(ranks: int, width: int, span: int, degree: int, seed: int) -> str:
+  """
+  a layered graph whose edges skip up to `span` ranks
+
+  Args:
+    ranks: Number of layers of real nodes
+    width: Number of real nodes per layer
+    span: Maximum number of layers an edge skips
+    degree: Number of out edges per node
+    seed: Seed for the random number generator
+
+  Returns:
+    DOT source of the graph
+  """
+  rng = random.Random(seed)
+  lines = ["digraph G {", "  node [shape=point];"]
+  for r in range(ranks):
+    lines += [f"  {{rank=same; {' '.join(f'n{r}_{i}' for i in range(width))}}}"]
+  for r in range(ranks - 1):
+    for i in range(width):
+      for _ in range(degree):
+        head = min(ranks - 1, r + rng.randint(1, span))
+        lines += [f"  n{r}_{i} -> n{head}_{rng.randrange(width)};"]
+  lines += ["}"]
+  return "\n".join(lines)
+
+def measure(dot: str, source: str, repeat: int) -> float:
+  """
+  best wall clock time of laying out `source` with `dot`, in seconds
+  """
+  best = float("inf")
+  for _ in range(repeat):
+    start = time.monotonic()
+    subprocess.run([dot, "-Tplain", "-o", "/dev/null"], input=source,
+                   check=True, universal_newlines=True)
+    best = min(best, time.monotonic() - start)
+  return best
+
+def main(args: List[str]) -> int:
+  """entry point"""
+
+  parser = argparse.ArgumentParser(description=__doc__,
+                   formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument("--ranks", type=int, default=10,
+                      help="number of layers of real nodes")
+  parser.add_argument("--width", type=int, default=200,
+                      help="number of real nodes per layer")
+  parser.add_argument("--span", type=int, default=6,
+                      help="maximum number of layers an edge skips")
+  parser.add_argument("--degree", type=int, default=2,
+                      help="number of out edges per node")
+  parser.add_argument("--seed", type=int, default=0,
+                      help="random seed")
+  parser.add_argument("--repeat", type=int, default=3,
+                      help="number of runs per binary; the best is reported")
+  parser.add_argument("--emit", action="store_true",
+                      help="print the generated graph instead of timing it")
+  parser.add_argument("dot", nargs="*", default=["dot"],
+                      help="dot binaries to time")
+  options = parser.parse_args(args[1:])
+
+  source = generate(options.ranks, options.width, options.span, options.degree,
+                    options.seed)
+
+  if options.emit:
+    sys.stdout.write(source)
+    return 0
+
+  for dot in options.dot:
+    print(f"{dot}: {measure(dot, source, options.repeat):.3f}s")
+
+  return 0
+
+if __name__ == "__main__":
+  sys.exit(main(sys.argv))
@@ -0,0 +1,107 @@
+/// \file
+/// \brief the arrays of agsnapshot should list the same edges, in the same
+/// order, as iterating over the graph does
+
+#include <graphviz/cgraph.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int check(Agraph_t *g) {
+  int ret = EXIT_SUCCESS;
+  Agsnapshot_t *s = agsnapshot(g);
+
+#define EXPECT(cond)                                                           \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s: failed %s\n", agnameof(g), #cond);                  \
+      ret = EXIT_FAILURE;                                                      \
+    }                                                                          \
+  } while (0)
+
+  EXPECT(s->nnodes == (size_t)agnnodes(g));
+  EXPECT(s->nedges == (size_t)agnedges(g));
+
+  size_t i = 0;
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n), ++i) {
+    EXPECT(i < s->nnodes && s->nodes[i] == n);
+    EXPECT(agsnapindex(s, n) == i);
+
+    size_t j = s->out_start[i];
+    for (Agedge_t *e = agfstout(g, n); e; e = agnxtout(g, e), ++j) {
+      EXPECT(j < s->out_start[i + 1] && s->out_edge[j] == e);
+      EXPECT(s->nodes[s->out_adj[j]] == aghead(e));
+    }
+    EXPECT(j == s->out_start[i + 1]);
+
+    j = s->in_start[i];
+    for (Agedge_t *e = agfstin(g, n); e; e = agnxtin(g, e), ++j) {
+      EXPECT(j < s->in_start[i + 1] && s->in_edge[j] == e);
+      EXPECT(s->nodes[s->in_adj[j]] == agtail(e));
+    }
+    EXPECT(j == s->in_start[i + 1]);
+
+    j = s->adj_start[i];
+    for (Agedge_t *e = agfstedge(g, n); e; e = agnxtedge(g, e, n), ++j) {
+      EXPECT(j < s->adj_start[i + 1] && s->adj_edge[j] == e);
+      EXPECT(s->nodes[s->adj[j]] == (agtail(e) == n ? aghead(e) : agtail(e)));
+    }
+    EXPECT(j == s->adj_start[i + 1]);
+  }
+  EXPECT(i == s->nnodes);
+
+  // a node of the root that is not in a subgraph has no number there
+  Agnode_t *outside = agnode(agroot(g), "outside", 0);
+  if (g != agroot(g)) {
+    EXPECT(agsnapindex(s, outside) == SIZE_MAX);
+  }
+
+#undef EXPECT
+
+  agsnapfree(s);
+  return ret;
+}
+
+int main(void) {
+  int ret = EXIT_SUCCESS;
+  Agdesc_t descs[] = {Agdirected, Agundirected};
+
+  for (size_t d = 0; d < sizeof(descs) / sizeof(descs[0]); ++d) {
+    Agraph_t *g = agopen("g", descs[d], NULL);
+    Agraph_t *sg = agsubg(g, "s", 1);
+    char name[16];
+    Agnode_t *nodes[40];
+    for (int i = 0; i < 40; ++i) {
+      snprintf(name, sizeof(name), "n%d", i);
+      nodes[i] = agnode(i % 3 ? g : sg, name, 1);
+    }
+    (void)agnode(g, "outside", 1);
+
+    // multi-edges, loops and edges in both directions
+    for (int i = 0; i < 120; ++i) {
+      Agnode_t *t = nodes[(i * 7) % 40], *h = nodes[(i * 13 + 5) % 40];
+      (void)agedge(i % 4 ? g : sg, t, h, NULL, 1);
+    }
+    (void)agedge(g, nodes[3], nodes[3], NULL, 1);
+    (void)agedge(sg, nodes[0], nodes[0], NULL, 1);
+    (void)agedge(sg, nodes[0], nodes[0], NULL, 1);
+
+    if (check(g) != EXIT_SUCCESS || check(sg) != EXIT_SUCCESS) {
+      ret = EXIT_FAILURE;
+    }
+
+    // leave sparse sequence numbers behind, so nodes are found by search
+    for (int i = 1; i < 40; ++i) {
+      if (i % 5 != 0) {
+        agdelnode(g, nodes[i]);
+      }
+    }
+    if (check(g) != EXIT_SUCCESS || check(sg) != EXIT_SUCCESS) {
+      ret = EXIT_FAILURE;
+    }
+
+    agclose(g);
+  }
+
+  return ret;
+}
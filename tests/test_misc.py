@@ -7,13 +7,15 @@ import json
 import os
 from pathlib import Path
 import platform
+import shlex
 import subprocess
 import sys
 import tempfile
+from typing import Dict, List
 import pytest
 
 sys.path.append(os.path.dirname(__file__))
-from gvtest import compile_c, dot, ROOT #pylint: disable=wrong-import-position
+from gvtest import compile_c, dot, ROOT, run_c #pylint: disable=wrong-import-position
 
 def test_json_node_order():
   """
@@ -184,3 +186,308 @@ def test_xml_escape():
           assert escaped == f"character |{expected}|", "bad UTF-8 escaping"
         else:
           assert escaped == unescaped, "bad UTF-8 passthrough"
+
+def test_threads_same_layout():
+  """
+  laying out with `threads` > 1 should give the same result as a single thread
+  """
+
+  # a graph with several connected components, some with clusters and some
+  # with flat edges
+  source = "digraph {\n"                                                     \
+           "  subgraph cluster_a { a1 -> a2; a1 -> a3; {rank=same; a2 -> a3} }\n" \
+           "  a0 -> a1; a0 -> a3;\n"                                        \
+           "  b1 -> b2 -> b3; b1 -> b3; b2 -> b4; {rank=same; b3; b4}\n"     \
+           "  c1 -> c2; c1 -> c3; c2 -> c4; c3 -> c4; c1 -> c4;\n"          \
+           "  subgraph cluster_d { d1 -> d2; d3 -> d2 }\n"                   \
+           "  d0 -> d1; d0 -> d3; d4 -> d1;\n"                              \
+           "  e1; f1 -> f2;\n"                                              \
+           "}"
+
+  serial = dot("plain", source=source)
+  parallel = dot("plain", source=source.replace("{", "{ threads=4;", 1))
+  assert serial == parallel, "layout changed when using multiple threads"
+
+def test_threads_wide_ranks():
+  """
+  the node order of a graph with a rank too wide for a single thread should
+  not depend on the number of threads
+  """
+
+  edges = "".join(f"r -> c{i}; c{i} -> g{i * 7919 % 300}; c{i} -> g{i * 104729 % 299};"
+                  for i in range(1100))
+  source = f"digraph {{ {edges} }}"
+
+  def orders(threads: int) -> List[str]:
+    laid_out = dot("dot", source=source.replace("{", f"{{ phase=2; threads={threads};", 1))
+    return [l.strip() for l in laid_out.decode().splitlines() if "order=" in l]
+
+  assert orders(2) == orders(3), "node order depends on the number of threads"
+
+def test_threads_sibling_clusters():
+  """
+  the node order of a graph with many independent clusters, which are ordered
+  concurrently, should not depend on the number of threads
+  """
+
+  def cluster(name: str, depth: int) -> str:
+    nodes = " ".join(f"{name}_{i} -> {name}_{(i * 5 + 1) % 7};" for i in range(7))
+    inner = "".join(cluster(f"{name}{k}", depth - 1) + f"{name}_0 -> {name}{k}_0;"
+                    for k in range(3)) if depth > 0 else ""
+    return f"subgraph cluster_{name} {{ {nodes} {inner} }}"
+
+  source = "digraph { " + "".join(cluster(f"c{i}", 2) + f"top -> c{i}_0;"
+                                  for i in range(4)) + "}"
+
+  def orders(threads: int) -> List[str]:
+    laid_out = dot("dot", source=source.replace("{", f"{{ phase=2; threads={threads};", 1))
+    return [l.strip() for l in laid_out.decode().splitlines() if "order=" in l]
+
+  assert orders(2) == orders(3), "node order depends on the number of threads"
+
+def test_mcstarts():
+  """
+  more `mcstarts` should never give more crossings, and the result should not
+  depend on the number of threads
+  """
+
+  source = (Path(__file__).parent / "../graphs/directed/world.gv").read_text()
+
+  def crossings(*args: str) -> int:
+    p = subprocess.run(["dot", "-v", "-Tplain", "-o", os.devnull, *args],
+                       input=source, stderr=subprocess.PIPE, check=True,
+                       universal_newlines=True)
+    counts = [int(l.split()[2]) for l in p.stderr.splitlines()
+              if l.startswith("mincross world:")]
+    assert len(counts) == 1, "crossing count not found in verbose output"
+    return counts[0]
+
+  assert crossings("-Gmcstarts=8") <= crossings(), \
+    "more starts gave more crossings"
+
+  # edges are routed differently with several threads, so only compare nodes
+  def nodes(plain: bytes) -> List[bytes]:
+    return [l for l in plain.splitlines() if l.startswith(b"node ")]
+
+  serial = dot("plain", source=source.replace("{", "{ mcstarts=8;", 1))
+  parallel = dot("plain", source=source.replace("{", "{ mcstarts=8; threads=4;",
+                                                1))
+  assert nodes(serial) == nodes(parallel), \
+    "layout with mcstarts depends on threads"
+
+def test_clustercache():
+  """
+  with `clustercache`, unchanged clusters of a later graph should reuse their
+  earlier layout, and the layout should stay the same
+  """
+
+  source = "digraph {\n"                                                  \
+           "  clustercache=true;\n"                                       \
+           "  subgraph cluster_a { a1 -> a2 -> a3; a1 -> a3; }\n"          \
+           "  subgraph cluster_b { b1 -> b2; b1 -> b3; {rank=same; b2 -> b3} }\n" \
+           "  a2 -> b1; a3 -> b3;\n"                                       \
+           "}\n"
+  changed = source.replace("b1 -> b3;", "b1 -> b3; b3 -> b4;")
+
+  p = subprocess.run(["dot", "-v", "-Tplain"], input=source + source + changed,
+                     stdout=subprocess.PIPE, stderr=subprocess.PIPE, check=True,
+                     universal_newlines=True)
+  first, second, _ = p.stdout.split("stop\n")[:3]
+  assert first + "stop\n" == dot("plain", source=source.replace(
+    "clustercache=true;", "", 1)).decode(), "clustercache changed the layout"
+  assert first == second, "reusing cached clusters changed the layout"
+
+  def reused(phase: str, cluster: str) -> int:
+    return p.stderr.count(f"{phase} {cluster}: reusing cached")
+
+  assert reused("rank", "cluster_a") == 2 and reused("mincross", "cluster_a") == 2
+  assert reused("rank", "cluster_b") == 1 and reused("mincross", "cluster_b") == 1
+
+def test_threads_edge_routing():
+  """
+  edges routed concurrently should not depend on the number of threads
+  """
+
+  source = (Path(__file__).parent / "../graphs/directed/world.gv").read_text()
+
+  two = dot("plain", source=source.replace("{", "{ threads=2;", 1))
+  four = dot("plain", source=source.replace("{", "{ threads=4;", 1))
+  assert two == four, "edge routes depend on the number of threads"
+
+def test_xcoord_bk():
+  """
+  Brandes–Köpf x coordinates should keep nodes apart and inside their clusters
+  """
+
+  source = (Path(__file__).parent / "graphs/compound.gv").read_text()
+  layout = json.loads(dot("json", source=source.replace("{", "{ xcoord=bk;", 1)))
+
+  nodes = {}
+  for o in layout["objects"]:
+    if "pos" in o:
+      x, y = (float(c) for c in o["pos"].split(","))
+      w = float(o["width"]) * 72
+      nodes[o["_gvid"]] = (o["name"], x - w / 2, x + w / 2, y)
+
+  for (a, l0, r0, y0), (b, l1, r1, y1) in itertools.combinations(
+      nodes.values(), 2):
+    assert y0 != y1 or r0 <= l1 or r1 <= l0, f"{a} and {b} overlap"
+
+  for o in layout["objects"]:
+    if "bb" not in o:
+      continue
+    llx, lly, urx, ury = (float(c) for c in o["bb"].split(","))
+    for gvid, (name, left, right, y) in nodes.items():
+      if gvid in o.get("nodes", []):
+        assert llx <= left and right <= urx, f"{name} is outside {o['name']}"
+      elif lly <= y <= ury:
+        assert right <= llx or urx <= left, f"{name} is inside {o['name']}"
+
+def test_mctime():
+  """
+  a generous `mctime` should not change the layout, and an exhausted one should
+  still lay out every node
+  """
+
+  source = (Path(__file__).parent / "../graphs/directed/world.gv").read_text()
+
+  generous = dot("plain", source=source.replace("{", "{ mctime=100000;", 1))
+  assert generous == dot("plain", source=source), \
+    "mctime changed the layout without running out"
+
+  p = subprocess.run(["dot", "-v", "-Tplain", "-Gmctime=0.000001"], input=source,
+                     stdout=subprocess.PIPE, stderr=subprocess.PIPE, check=True,
+                     universal_newlines=True)
+  assert "mctime exceeded" in p.stderr, "mctime was not enforced"
+  def nodes(plain: str) -> List[str]:
+    return sorted(l.split()[1] for l in plain.splitlines() if l.startswith("node "))
+  assert nodes(p.stdout) == nodes(generous.decode()), "nodes missing from layout"
+
+def test_cyclebreak_els():
+  """
+  `cyclebreak=els` should break all cycles through a hub by reversing the one
+  edge they share, where depth-first search from the hub reverses the others
+  """
+
+  source = "digraph { h; h -> a; a -> b1 -> h; a -> b2 -> h; a -> b3 -> h; }"
+
+  def heights(plain: str) -> Dict[str, float]:
+    return {l.split()[1]: float(l.split()[3]) for l in plain.splitlines()
+            if l.startswith("node ")}
+
+  dfs = heights(dot("plain", source=source).decode())
+  assert dfs["h"] > dfs["a"], "depth-first search no longer starts at h"
+
+  els = heights(dot("plain", source=source.replace("{", "{ cyclebreak=els;", 1))
+                .decode())
+  assert els["a"] > els["b1"] > els["h"], "cyclebreak=els reversed extra edges"
+
+def test_largemode():
+  """
+  `largemode` should only take effect on graphs of at least the given size,
+  and report what it changed
+  """
+
+  source = "digraph { a -> b -> c -> d; a -> d; b -> d; }"
+
+  def run(largemode: str) -> subprocess.CompletedProcess:
+    return subprocess.run(["dot", "-v", "-Tplain", f"-Glargemode={largemode}"],
+                          input=source, stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE, check=True,
+                          universal_newlines=True)
+
+  small = run("100")
+  assert "large graph" not in small.stderr, "largemode below its threshold"
+  assert small.stdout == dot("plain", source=source).decode(), \
+    "largemode below its threshold changed the layout"
+
+  large = run("9")
+  assert "large graph mode for 4 nodes, 5 edges" in large.stderr
+  for change in ("limiting iterations", "xcoord=bk", "long edges as lines"):
+    assert change in large.stderr, f"largemode did not report {change}"
+  assert "large graph mode" in run("true").stderr
+
+def test_curved_many_cycles():
+  """
+  curved edges should be laid out in reasonable time in a graph with a huge
+  number of cycles
+  """
+
+  # a ring of 30 nodes, each linked to the next three, whose number of simple
+  # cycles grows exponentially with its size
+  edges = " ".join(f"{i} -> {(i + k) % 30};" for i in range(30)
+                   for k in (1, 2, 3))
+  source = f"digraph {{ splines=curved; {edges} }}"
+
+  for engine in ("dot", "neato"):
+    subprocess.run([engine, "-Tsvg", "-o", os.devnull], input=source,
+                   check=True, timeout=60, universal_newlines=True)
+
+def test_mcinit_pos():
+  """
+  `mcinit=pos` should keep the node order of an earlier layout, whatever the
+  order of the input
+  """
+
+  source = (Path(__file__).parent / "../graphs/directed/unix.gv").read_text()
+
+  def ranks(plain: str) -> List[List[str]]:
+    nodes = [shlex.split(l) for l in plain.splitlines()
+             if l.startswith("node ")]
+    rows: Dict[float, List[List[str]]] = {}
+    for n in nodes:
+      rows.setdefault(float(n[3]), []).append(n)
+    return [[n[1] for n in sorted(row, key=lambda n: float(n[2]))]
+            for _, row in sorted(rows.items())]
+
+  before = dot("plain", source=source).decode("utf-8")
+  nodes = [shlex.split(l) for l in before.splitlines() if l.startswith("node ")]
+  edges = [shlex.split(l) for l in before.splitlines() if l.startswith("edge ")]
+
+  # the same graph, stated in reverse
+  stmts = [f'"{n[1]}" [pos="{n[2]},{n[3]}"];' for n in reversed(nodes)]
+  stmts += [f'"{e[1]}" -> "{e[2]}";' for e in reversed(edges)]
+  reordered = "digraph { " + " ".join(stmts) + " }"
+
+  after = subprocess.check_output(["dot", "-Tplain", "-Gmcinit=pos"],
+                                  input=reordered, universal_newlines=True)
+  assert ranks(after) == ranks(before), "mcinit=pos did not keep the node order"
+
+def test_bulk_construction():
+  """
+  graphs built with `agnodes` and `agedges` should be indistinguishable from
+  those built one object at a time
+  """
+
+  # find co-located test source
+  c_src = (Path(__file__).parent / "bulk.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  # run it
+  _, _ = run_c(c_src, link=["cgraph"])
+
+def test_arena_discipline():
+  """
+  graphs read with the arena memory discipline should lay out the same as
+  those read with the default one
+  """
+
+  source = (Path(__file__).parent / "graphs/clust4.gv").resolve()
+  assert source.exists(), "missing test case"
+
+  # read the same input twice, so the first graph is closed by the arena
+  default = subprocess.check_output(["dot", "-Tplain", source, source])
+  arena = subprocess.check_output(["dot", "-Marena", "-Tplain", source, source])
+  assert arena == default, "arena discipline changed the layout"
+
+def test_snapshot():
+  """
+  the adjacency arrays of `agsnapshot` should match iteration over the graph
+  """
+
+  # find co-located test source
+  c_src = (Path(__file__).parent / "snapshot.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  # run it
+  _, _ = run_c(c_src, link=["cgraph"])
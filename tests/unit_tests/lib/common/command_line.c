@@ -17,7 +17,7 @@ lt_symlist_t lt_preloaded_symbols[] = { { 0, 0 } };
 extern int GvExitOnUsage;
 
 static char usage_info[] =
-		"Usage: dot [-Vv?] [-(GNE)name=val] [-(KTlso)<val>] <dot files>\n"
+		"Usage: dot [-Vv?] [-(GNE)name=val] [-(KMTlso)<val>] <dot files>\n"
 		"(additional options for neato)    [-x] [-n<v>]\n"
 		"(additional options for fdp)      [-L(gO)] [-L(nUCT)<val>]\n"
 		"(additional options for memtest)  [-m<v>]\n"
@@ -31,6 +31,7 @@ static char usage_info[] =
 		" -Tv         - Set output format to 'v'\n"
 		" -Kv         - Set layout engine to 'v' (overrides default based on command name)\n"
 		" -lv         - Use external library 'v'\n"
+		" -Mv         - Set memory allocator for input graphs to 'v' (arena, malloc)\n"
 		" -ofile      - Write output to 'file'\n"
 		" -O          - Automatically generate an output filename based on the input filename with a .'format' appended. (Causes all -ofile options to be ignored.) \n"
 		" -P          - Internally generate a graph of the current plugins. \n"